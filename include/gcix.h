@@ -18,7 +18,18 @@
 // USE, DATA, OR PROFITS; OR BUSINESS INTERRUPTION) HOWEVER CAUSED AND ON ANY THEORY OF LIABILITY, WHETHER IN CONTRACT, STRICT 
 // LIABILITY, OR TORT (INCLUDING NEGLIGENCE OR OTHERWISE) ARISING IN ANY WAY OUT OF THE USE OF THIS SOFTWARE, EVEN IF ADVISED 
 // OF THE POSSIBILITY OF SUCH DAMAGE.
+#include <stddef.h>
 #include <stdint.h>
+#include <string.h>
+
+#include <atomic>
+
+#if defined(_MSC_VER)
+#define gcix_public_thread_local __declspec(thread)
+#else
+// Unlike thread_local, an extern __thread variable is accessed directly, without calling its initialization wrapper
+#define gcix_public_thread_local __thread
+#endif
 
 namespace gcix
 {
@@ -26,7 +37,13 @@ namespace gcix
 	The maximum size (inclusive) of a Standard object allocated in an immix block. Above this limit, an object must be 
 	allocated as a LargeObject.
 	*/
-	static const uint32_t StandardObjectMaxSizeInBytes = 16252;
+	static const uint32_t StandardObjectMaxSizeInBytes = 15740;
+
+	/**
+	The maximum size (inclusive) of a Large object. The size of a large object, with its header, is stored on 29 bits of its
+	header as a multiple of 4 bytes, that limits large objects to 2GB.
+	*/
+	static const uint32_t LargeObjectMaxSizeInBytes = 0x7F000000;
 
 	/**
 	Initialize Immix collector. This method must be called before any other methods. Usually done at program initialization
@@ -40,6 +57,147 @@ namespace gcix
 	*/
 	void InitializeMutatorThread();
 
+	/**
+	Shutdown the current mutator thread. Must be called by any thread initialized with InitializeMutatorThread before it
+	terminates.
+	*/
+	void ShutdownMutatorThread();
+
+	/**
+	Parks the current mutator thread if another thread is waiting to perform a collection. Should be called regularly by 
+	threads running long loops without allocating.
+	*/
+	void Safepoint();
+
+	/**
+	Declares that the current mutator thread is going to run native code (blocking IO, long computations...) without 
+	accessing any managed object. Collections can run concurrently with native code.
+	*/
+	void EnterNativeCode();
+
+	/**
+	Declares that the current mutator thread is leaving native code. Waits for the end of the current collection if any.
+	*/
+	void LeaveNativeCode();
+
+	/**
+	Write barrier of sticky collections (enabled by GCIX_ENABLE_STICKY) and concurrent marking (enabled by 
+	GCIX_ENABLE_CONCURRENT_MARK). Must be called by the current mutator thread before storing a reference into a field of
+	a managed object. While a concurrent trace is running, all the references of the object are logged: prefer 
+	@see WriteBarrier(void*, void**) that only logs the reference overwritten.
+	@param object The managed object being modified. Cannot be null.
+	*/
+	void WriteBarrier(void* object);
+
+	/**
+	Write barrier of sticky collections (enabled by GCIX_ENABLE_STICKY) and concurrent marking (enabled by 
+	GCIX_ENABLE_CONCURRENT_MARK). Must be called by the current mutator thread before storing a reference into the 
+	specified field of a managed object, while the field still contains the reference overwritten. A thread suspended 
+	asynchronously by a collection between this call and the store can overwrite a reference of the snapshot of a 
+	concurrent trace without logging it: threads that don't reach safepoints regularly must use @see WriteReference.
+	@param object The managed object being modified. Cannot be null.
+	@param slot The field of the object receiving the reference. Cannot be null.
+	*/
+	void WriteBarrier(void* object, void** slot);
+
+	/**
+	State of the write barrier read by the inlined fast path of @see WriteReference and @see WriteReferences, so that a 
+	store only calls into the collector when the object must be logged. Updated by the collector while the mutator 
+	threads are stopped, must not be modified by the application.
+	*/
+	struct WriteBarrierState
+	{
+		/** Size in bytes of the header preceding a managed object, starting with the 32 bits flags of the object */
+		uint32_t HeaderSize;
+
+		/** 
+		The write barrier must log an object when its flags masked by LogMask are equal to LogValue: an old object not
+		logged yet during sticky collections, any object while a concurrent trace is running, none otherwise.
+		*/
+		uint32_t LogMask;
+		uint32_t LogValue;
+
+		/** 
+		The write barrier must also call the slow path when the flags of an object masked by TypeMask are equal to 
+		TypeValue: inner objects, whose container is logged instead, and large objects with a card table.
+		*/
+		uint32_t TypeMask;
+		uint32_t TypeValue;
+	};
+
+	/**
+	Current state of the write barrier, see @see WriteBarrierState.
+	*/
+	extern WriteBarrierState CurrentWriteBarrierState;
+
+	/**
+	True while the current thread runs the inlined fast path of @see WriteReference or @see WriteReferences, between the 
+	check of the write barrier state and the store. The collector doesn't suspend a thread asynchronously in this window,
+	so that a collection cannot start a concurrent trace between the check and the store.
+	*/
+	extern gcix_public_thread_local bool InWriteBarrier;
+
+	/**
+	Slow path of @see WriteReference and @see WriteReferences, logs the object and the references about to be overwritten.
+	Should not be called directly.
+	@param object The managed object being modified. Cannot be null.
+	@param slots The fields of the object receiving the references.
+	@param count The number of fields.
+	*/
+	void WriteReferencesSlow(void* object, void** slots, size_t count);
+
+	/**
+	Indicates whether a store into the specified managed object must call the slow path of the write barrier.
+	*/
+	inline bool RequiresWriteBarrier(void* object)
+	{
+		auto& state = CurrentWriteBarrierState;
+		auto flags = *(const uint32_t*)((const uint8_t*)object - state.HeaderSize);
+		return (flags & state.LogMask) == state.LogValue || (flags & state.TypeMask) == state.TypeValue;
+	}
+
+	/**
+	Stores a reference into a field of a managed object, calling the write barrier of sticky collections and concurrent 
+	marking. Only the objects that must be logged call into the collector. Must be called by the current mutator thread.
+	@param object The managed object being modified. Cannot be null.
+	@param slot The field of the object receiving the reference. Cannot be null.
+	@param value The reference to store, a managed object or null.
+	*/
+	inline void WriteReference(void* object, void** slot, void* value)
+	{
+		InWriteBarrier = true;
+		std::atomic_signal_fence(std::memory_order_seq_cst);
+		if (RequiresWriteBarrier(object))
+		{
+			WriteReferencesSlow(object, slot, 1);
+		}
+		*slot = value;
+		std::atomic_signal_fence(std::memory_order_seq_cst);
+		InWriteBarrier = false;
+	}
+
+	/**
+	Copies references into consecutive fields of a managed object (e.g an array), calling the write barrier once for all
+	of them. The source and destination can overlap (e.g to shift the elements of an array). Must be called by the 
+	current mutator thread.
+	@param object The managed object being modified. Cannot be null.
+	@param slots The first field of the object receiving the references.
+	@param values The references to copy, managed objects or null.
+	@param count The number of references to copy.
+	*/
+	inline void WriteReferences(void* object, void** slots, void* const* values, size_t count)
+	{
+		InWriteBarrier = true;
+		std::atomic_signal_fence(std::memory_order_seq_cst);
+		if (count > 0 && RequiresWriteBarrier(object))
+		{
+			WriteReferencesSlow(object, slots, count);
+		}
+		memmove(slots, values, count * sizeof(void*));
+		std::atomic_signal_fence(std::memory_order_seq_cst);
+		InWriteBarrier = false;
+	}
+
 	/**
 	Allocates a standard size managed object.
 	@param size Size in bytes of the object. Must be > 0 and <= StandardObjectMaxSizeInBytes
@@ -50,8 +208,131 @@ namespace gcix
 
 	/**
 	Allocates a large size managed object.
-	@param size Size in bytes of the object. Must be > StandardObjectMaxSizeInBytes
+	@param size Size in bytes of the object. Must be > StandardObjectMaxSizeInBytes and <= LargeObjectMaxSizeInBytes
 	@param userClassDescriptor Pointer to the object class descriptor that will be setup on the header of the object. Cannot be
+	null.
+	@return the object or `nullptr` in case of an out of memory or if the size is above LargeObjectMaxSizeInBytes
 	*/
 	void* AllocateLargeObject(uint32_t size, void* userClassDescriptor);
+
+	/**
+	Number of buckets of the pause histogram of @see Statistics, covering pauses up to 2^32 microseconds.
+	*/
+	static const uint32_t PauseHistogramBucketCount = 124;
+
+	/**
+	Statistics of the collector, see @see GetStatistics. Durations are in nanoseconds and cumulated over all the 
+	collections.
+	*/
+	struct Statistics
+	{
+		/** Number of collections performed so far */
+		uint64_t CollectionCount;
+
+		/** Number of sticky collections among them */
+		uint64_t StickyCollectionCount;
+
+		/** Number of collections among them that traced the object graph concurrently with the mutator threads */
+		uint64_t ConcurrentCollectionCount;
+
+		/** Time spent waiting for the mutator threads to stop */
+		uint64_t StopMutatorsTime;
+
+		/** Time spent completing the sweep of the previous collection, clearing marks and selecting evacuated blocks */
+		uint64_t ClearTime;
+
+		/** Time spent scanning the stacks of the mutator threads */
+		uint64_t StackScanTime;
+
+		/** Time spent marking the gc roots and the remembered sets */
+		uint64_t RootsTime;
+
+		/** Time spent tracing the object graph */
+		uint64_t MarkTime;
+
+		/** Time spent sweeping large objects and flagging blocks to be swept */
+		uint64_t SweepTime;
+
+		/** 
+		Time elapsed between the initial and the remark pauses of the concurrent collections, while the object graph is 
+		traced concurrently with the mutator threads. Not included in the pause times.
+		*/
+		uint64_t ConcurrentMarkTime;
+
+		/** Total time the mutator threads have been stopped by collections */
+		uint64_t TotalPauseTime;
+
+		/** Longest collection pause */
+		uint64_t MaxPauseTime;
+
+		/** Bytes allocated by the mutator threads up to the last collection */
+		uint64_t BytesAllocated;
+
+		/** Bytes used by the objects marked by the last collection (lines of blocks and large objects) */
+		uint64_t BytesMarked;
+
+		/** Bytes freed by the collections, estimated from the bytes allocated and the bytes marked */
+		uint64_t BytesFreed;
+
+		/** Bytes of the old objects reclaimed by reference counting (GCIX_ENABLE_RC), without a full collection */
+		uint64_t ReferenceCountFreedBytes;
+
+		/** Number of free blocks, as of their last sweep */
+		uint32_t FreeBlockCount;
+
+		/** Number of recyclable blocks (blocks with free lines), as of their last sweep */
+		uint32_t RecyclableBlockCount;
+
+		/** Number of blocks without free lines or in use by mutator threads, as of their last sweep */
+		uint32_t UnavailableBlockCount;
+
+		/** Number of large objects */
+		uint32_t LargeObjectCount;
+
+		/** Bytes used by large objects */
+		uint64_t LargeObjectBytes;
+
+		/** 
+		Number of collection pauses per duration (a concurrent collection has two pauses). Bucket i counts the pauses 
+		lasting from GetPauseHistogramBucketStart(i) (inclusive) to GetPauseHistogramBucketStart(i + 1) (exclusive) 
+		microseconds. The buckets are log-linear: each power of two is split in 4 buckets, so that the relative error is 
+		below 25%.
+		*/
+		uint64_t PauseHistogram[PauseHistogramBucketCount];
+	};
+
+	/**
+	Gets the statistics of the collector. Can be called from any thread. Statistics are updated by each collection, 
+	without any cost for allocations.
+	@param statistics The statistics to fill. Cannot be null.
+	*/
+	void GetStatistics(Statistics* statistics);
+
+	/**
+	Gets the lowest duration in microseconds of a pause counted by a bucket of @see Statistics::PauseHistogram.
+	@param index Index of the bucket, lower or equal to PauseHistogramBucketCount (to get the end of the last bucket)
+	*/
+	uint64_t GetPauseHistogramBucketStart(uint32_t index);
+
+	/**
+	Starts recording the begin and end events of the phases of the collections (stop of the mutator threads, clear, stack 
+	scan, roots, mark, sweep, concurrent mark, work of the marker and sweeper threads) and of the stalls of the mutator 
+	threads (safepoints, block requests). Events are buffered per thread until @see WriteTrace. Requires gcix to be 
+	compiled with GCIX_ENABLE_TRACE.
+	@return false if the tracer is not compiled
+	*/
+	bool StartTrace();
+
+	/**
+	Stops recording events. Events already recorded are kept until the next @see WriteTrace.
+	*/
+	void StopTrace();
+
+	/**
+	Writes the events recorded so far to a Chrome trace event JSON file (loadable in chrome://tracing or Perfetto), and 
+	removes them from the buffers. Timestamps are relative to the initialization of gcix.
+	@param path Path of the file to write. Cannot be null.
+	@return false if the file cannot be written
+	*/
+	bool WriteTrace(const char* path);
 }
\ No newline at end of file
@@ -0,0 +1,88 @@
+﻿#pragma once
+// Copyright (c) 2014, Alexandre Mutel
+// All rights reserved.
+// 
+// Redistribution and use in source and binary forms, with or without modification, are permitted provided that the following 
+// conditions are met:
+// 
+// 1. Redistributions of source code must retain the above copyright notice, this list of conditions and the following 
+//    disclaimer.
+// 
+// 2. Redistributions in binary form must reproduce the above copyright notice, this list of conditions and the following 
+//    disclaimer in the documentation and/or other materials provided with the distribution.
+// 
+// THIS SOFTWARE IS PROVIDED BY THE COPYRIGHT HOLDERS AND CONTRIBUTORS "AS IS" AND ANY EXPRESS OR IMPLIED WARRANTIES, 
+// INCLUDING, BUT NOT LIMITED TO, THE IMPLIED WARRANTIES OF MERCHANTABILITY AND FITNESS FOR A PARTICULAR PURPOSE ARE 
+// DISCLAIMED. IN NO EVENT SHALL THE COPYRIGHT HOLDER OR CONTRIBUTORS BE LIABLE FOR ANY DIRECT, INDIRECT, INCIDENTAL, SPECIAL, 
+// EXEMPLARY, OR CONSEQUENTIAL DAMAGES (INCLUDING, BUT NOT LIMITED TO, PROCUREMENT OF SUBSTITUTE GOODS OR SERVICES; LOSS OF 
+// USE, DATA, OR PROFITS; OR BUSINESS INTERRUPTION) HOWEVER CAUSED AND ON ANY THEORY OF LIABILITY, WHETHER IN CONTRACT, STRICT 
+// LIABILITY, OR TORT (INCLUDING NEGLIGENCE OR OTHERWISE) ARISING IN ANY WAY OUT OF THE USE OF THIS SOFTWARE, EVEN IF ADVISED 
+// OF THE POSSIBILITY OF SUCH DAMAGE.
+
+
+#include "Common.h"
+#include "Constants.h"
+#include "BlockData.h"
+#include "GlobalAllocator.h"
+
+namespace gcix
+{
+	/**
+	A small per-thread cache of blocks, refilled by batch of @see Constants::BlockCacheCount blocks from the 
+	@see GlobalAllocator. This allows a @see ThreadLocalAllocator to request a new block without taking the chunks lock of 
+	the @see GlobalAllocator most of the time.
+	*/
+	class BlockCache
+	{
+	public:
+		BlockCache() : nextIndex(0), count(0), collectionCount(0)
+		{
+		}
+
+		/**
+		Returns the next block available in this cache, or refill the cache from the @see GlobalAllocator.
+		@param requestForEmptyBlock true to force the returned block to be an empty/free block (not recyclable)
+		@return an address to a @see BlockData or `nullptr_t` in case of an out of memory.
+		*/
+		inline BlockData* RequestBlock(bool requestForEmptyBlock)
+		{
+			// Blocks cached before a collection have been recycled by the collector and may be used by other threads
+			if (nextIndex == count || collectionCount != GlobalAllocator::Instance->CollectionCount())
+			{
+				return Refill(requestForEmptyBlock);
+			}
+			return blocks[nextIndex++];
+		}
+
+		/**
+		Discards all blocks cached.
+		*/
+		inline void Clear()
+		{
+			nextIndex = 0;
+			count = 0;
+		}
+
+	private:
+		gcix_disable_new_delete_operator();
+
+		gcix_noinline BlockData* Refill(bool requestForEmptyBlock)
+		{
+			collectionCount = GlobalAllocator::Instance->CollectionCount();
+			nextIndex = 0;
+			count = GlobalAllocator::Instance->RequestBlocks(requestForEmptyBlock, blocks, Constants::BlockCacheCount);
+
+			// If no blocks are returned, then we are running out of space
+			if (count == 0)
+			{
+				return nullptr;
+			}
+			return blocks[nextIndex++];
+		}
+
+		BlockData* blocks[Constants::BlockCacheCount];
+		int32_t nextIndex;
+		int32_t count;
+		uint32_t collectionCount;
+	};
+}
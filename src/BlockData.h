@@ -22,12 +22,15 @@
 #include "Common.h"
 #include "Constants.h"
 #include "ChunkHeader.h"
-#include "Utility\Memory.h"
+#include "Utility/Memory.h"
 #include "ObjectAddress.h"
 #include "LineFlags.h"
 #include "BlockFlags.h"
+#include "LineMask.h"
+#include "Utility/Bits.h"
 
 #include <algorithm>
+#include <atomic>
 
 namespace gcix
 {
@@ -52,11 +55,31 @@ namespace gcix
 					uint32_t BumpCursor;
 					uint32_t BumpCursorLimit;
 
-					BlockFlags BlockFlags;
+					gcix::BlockFlags BlockFlags;
 					uint8_t UsedLineCount;
 					uint8_t ConsecutiveUsedLineCount;
 					uint8_t Pinned;
 					uint8_t BlockIndex;
+
+					/* Non zero if at least one line of this block has been marked by the current trace */
+					uint8_t Marked;
+
+					/* Non zero if the objects of this block are evacuated by the current trace */
+					uint8_t Evacuating;
+
+					/* Non zero if the free lines of this block may contain stale data, cleared by @see ClearFreeLines */
+					uint8_t Dirty;
+
+					/* One bit per line, set if the line was marked by the last collection and cannot be allocated */
+					uint32_t UsedLines[LineMask::WordCount];
+
+#if (GCIX_ENABLE_RC == 1)
+					/* 
+					Number of objects marked in each line, 4 bits per line (low bits for even lines). A line whose count drops to 
+					zero is reclaimed without waiting for a full collection. Saturated counts are only reset by a full collection.
+					*/
+					uint8_t LineCounts[Constants::LineCount / 2];
+#endif
 				} Info;
 
 				/* One LineFlags per line */
@@ -64,7 +87,10 @@ namespace gcix
 			};
 
 			/* One LineFlags per line */
-			LineFlags LineFlags[Constants::LineCount];
+			gcix::LineFlags LineFlags[Constants::LineCount];
+
+			/* One bit per granule of the block, set if an object starts at this granule */
+			uint32_t ObjectStarts[(Constants::ObjectStartLineCount << Constants::LineBits) / sizeof(uint32_t)];
 		} Header;
 
 
@@ -104,6 +130,22 @@ namespace gcix
 			return (Header.LineFlags[lineIndex] & LineFlags::ContainsObject) != 0;
 		}
 
+		/**
+		Determines whether the specified line is used by objects that survived the last collection.
+		*/
+		inline bool IsLineUsed(uint32_t lineIndex) const
+		{
+			return (Header.Info.UsedLines[lineIndex >> 5] & (1u << (lineIndex & 31))) != 0;
+		}
+
+		/**
+		Gets the number of runs of used lines after the last collection, that is an estimate of the number of holes
+		*/
+		inline uint32_t GetUsedLineRunCount() const
+		{
+			return (uint32_t)Header.Info.UsedLineCount - Header.Info.ConsecutiveUsedLineCount;
+		}
+
 		/**
 		Gets the first object stored at the specified line. ContainsObject() must be called before calling this method
 		*/
@@ -116,6 +158,54 @@ namespace gcix
 		}
 
 
+		/**
+		Records that an object starts at the specified offset in this block.
+		*/
+		inline void SetObjectStart(uint32_t offset)
+		{
+			gcix_assert(offset >= Constants::HeaderSizeInBytes && offset < Constants::BlockSizeInBytes);
+			Header.ObjectStarts[offset >> (Constants::ObjectGranuleBits + 5)] |= 1u << ((offset >> Constants::ObjectGranuleBits) & 31);
+		}
+
+		/**
+		Atomically removes the object starting at the specified offset in this block (when it has been evacuated).
+		*/
+		inline void ClearObjectStart(uint32_t offset)
+		{
+			gcix_assert(offset >= Constants::HeaderSizeInBytes && offset < Constants::BlockSizeInBytes);
+			auto word = (std::atomic<uint32_t>*)&Header.ObjectStarts[offset >> (Constants::ObjectGranuleBits + 5)];
+			word->fetch_and(~(1u << ((offset >> Constants::ObjectGranuleBits) & 31)));
+		}
+
+		/**
+		Finds the last object starting at or before the specified address in this block, with a reverse bit scan of the 
+		object start bitmap. The object returned might not contain the address.
+		@return the object found or `nullptr` if no object starts before the address
+		*/
+		inline StandardObjectAddress* FindObjectStart(void* ptr) const
+		{
+			auto offset = (uint32_t)((intptr_t)ptr - (intptr_t)this);
+			if (offset < Constants::HeaderSizeInBytes)
+			{
+				return nullptr;
+			}
+
+			auto granule = offset >> Constants::ObjectGranuleBits;
+			auto wordIndex = granule >> 5;
+			auto bits = Header.ObjectStarts[wordIndex] & (~0u >> (31 - (granule & 31)));
+			while (bits == 0)
+			{
+				if (wordIndex == (Constants::HeaderSizeInBytes >> (Constants::ObjectGranuleBits + 5)))
+				{
+					return nullptr;
+				}
+				bits = Header.ObjectStarts[--wordIndex];
+			}
+
+			auto objectOffset = ((wordIndex << 5) + Bits::HighestBitIndex(bits)) << Constants::ObjectGranuleBits;
+			return (StandardObjectAddress*)((intptr_t)this + objectOffset);
+		}
+
 		/** 
 		Get the block associated with this address
 		*/
@@ -127,8 +217,20 @@ namespace gcix
 			return (BlockData*)((intptr_t)object & Constants::BlockSizeInBytesInverseMask);
 		}
 
+		/** 
+		Get the block containing the specified address, that must be an address allocated in a block (e.g an object 
+		being evacuated)
+		*/
+		static inline BlockData* FromAddress(void* address)
+		{
+			gcix_assert(address != nullptr);
+			return (BlockData*)((intptr_t)address & Constants::BlockSizeInBytesInverseMask);
+		}
+
 		/**
 		Mark lines associated with the specified object.
+		Lines already marked are not written, so that the lines of objects copied by evacuation (marked by 
+		@see AllocateCopy) are not modified concurrently with the worker allocating copies in this block.
 		*/
 		inline void MarkLines(StandardObjectAddress* object)
 		{
@@ -138,26 +240,192 @@ namespace gcix
 			for(uint32_t i = lineFrom; i <= lineTo; i++)
 			{
 				LineFlags& lineFlags = Header.LineFlags[i];
-				lineFlags |= LineFlags::Marked;
+				if ((lineFlags & LineFlags::Marked) == 0)
+				{
+					lineFlags |= LineFlags::Marked;
+				}
+			}
+			if (Header.Info.Marked == 0)
+			{
+				Header.Info.Marked = 1;
+			}
+		}
+
+#if (GCIX_ENABLE_RC == 1)
+		/**
+		Atomically increments the count of the lines used by the specified object, just marked by the current trace. The
+		range of lines is the one of @see MarkLines, within the block.
+		*/
+		inline void IncrementLineCounts(StandardObjectAddress* object)
+		{
+			uint32_t offset = (intptr_t)object - (intptr_t)this;
+			uint32_t lineFrom = offset >> Constants::LineBits;
+			uint32_t lineTo = std::min((offset + object->Size()) >> Constants::LineBits, Constants::LineCount - 1);
+			for (uint32_t i = lineFrom; i <= lineTo; i++)
+			{
+				auto counts = (std::atomic<uint8_t>*)&Header.Info.LineCounts[i >> 1];
+				auto shift = (i & 1) * 4;
+				auto value = counts->load();
+				do
+				{
+					if (((value >> shift) & 0xF) == 0xF)
+					{
+						break;
+					}
+				} while (!counts->compare_exchange_weak(value, (uint8_t)(value + (1 << shift))));
+			}
+		}
+
+		/**
+		Decrements the count of the lines used by the specified object, whose reference count dropped to zero. A line 
+		whose count drops to zero is neither marked nor used anymore, so that it is reclaimed by the next recycle of this 
+		block. Only called by the collecting thread once the trace is completed.
+		*/
+		inline void DecrementLineCounts(StandardObjectAddress* object)
+		{
+			uint32_t offset = (intptr_t)object - (intptr_t)this;
+			uint32_t lineFrom = offset >> Constants::LineBits;
+			uint32_t lineTo = std::min((offset + object->Size()) >> Constants::LineBits, Constants::LineCount - 1);
+			for (uint32_t i = lineFrom; i <= lineTo; i++)
+			{
+				auto& counts = Header.Info.LineCounts[i >> 1];
+				auto shift = (i & 1) * 4;
+				auto count = (counts >> shift) & 0xF;
+				if (count == 0 || count == 0xF)
+				{
+					continue;
+				}
+				counts = (uint8_t)(counts - (1 << shift));
+				if (count == 1)
+				{
+					Header.LineFlags[i] &= ~LineFlags::Marked;
+					Header.Info.UsedLines[i >> 5] &= ~(1u << (i & 31));
+				}
+			}
+		}
+
+		/**
+		Clears the count of all the lines of this block. Must be called before a full trace, that counts them again.
+		*/
+		inline void ClearLineCounts()
+		{
+			Memory::ClearSmall(Header.Info.LineCounts, sizeof(Header.Info.LineCounts));
+		}
+#endif
+
+		/**
+		Marks the objects allocated in the free lines of this block since its last recycle, and their lines. Used by the 
+		remark pause of a concurrent trace for the blocks handed out during the trace, whose objects are all live.
+		*/
+		inline void MarkAllocatedObjects()
+		{
+			uint32_t holeStart;
+			uint32_t holeEnd;
+			for (uint32_t line = Constants::HeaderLineCount; 
+				LineMask::FindHole(Header.Info.UsedLines, line, 1, holeStart, holeEnd); line = holeEnd)
+			{
+				for (uint32_t i = holeStart * ObjectStartWordCountPerLine; i < holeEnd * ObjectStartWordCountPerLine; i++)
+				{
+					for (auto bits = Header.ObjectStarts[i]; bits != 0; bits &= bits - 1)
+					{
+						auto offset = ((i << 5) + Bits::TrailingZeroCount(bits)) << Constants::ObjectGranuleBits;
+						auto object = (StandardObjectAddress*)((intptr_t)this + offset);
+						if (!object->IsMarked())
+						{
+							object->Mark();
+							MarkLines(object);
+						}
+					}
+				}
 			}
-			Header.Info.BlockFlags = BlockFlags::Unavailable;
 		}
-	private:
-		gcix_disable_new_delete_operator();
-		friend class Chunk;
 
 		/**
-		Clears this block as not marked. This is performed before a new full collection.
+		Allocates the copy of an evacuated object in this block with the bump cursor, and marks its lines. The copies fill
+		the holes of a recyclable block, starting with the bump cursor range set by its last recycle. Only used by the 
+		marker worker owning this block while tracing.
+		@param size Total size in bytes of the object (including its header)
+		@return the address of the copy or `nullptr` if this block is full
 		*/
-		inline void ClearMarked()
+		inline StandardObjectAddress* AllocateCopy(uint32_t size)
 		{
-			Header.Info.BlockFlags = BlockFlags::Free;
-			for(uint32_t i = Constants::HeaderLineCount; i < Constants::LineCount; i++)
+			auto offset = Header.Info.BumpCursor;
+			auto end = offset + size;
+
+			// The bump cursor limit of a free block is zero, its bump cursor range ends with the block
+			auto limit = Header.Info.BumpCursorLimit;
+			if (limit != 0 && end > limit)
+			{
+				uint32_t holeStart;
+				uint32_t holeEnd;
+				if (!LineMask::FindHole(Header.Info.UsedLines, limit >> Constants::LineBits, 
+					(size + Constants::LineSizeInBytes - 1) >> Constants::LineBits, holeStart, holeEnd))
+				{
+					return nullptr;
+				}
+				offset = holeStart << Constants::LineBits;
+				end = offset + size;
+				Header.Info.BumpCursorLimit = holeEnd << Constants::LineBits;
+			}
+
+			if (end & Constants::BlockSizeInBytesInverseMask)
+			{
+				return nullptr;
+			}
+			Header.Info.BumpCursor = end;
+
+			auto lineIndex = offset >> Constants::LineBits;
+			LineFlags& lineFlags = Header.LineFlags[lineIndex];
+			if ((lineFlags & LineFlags::ContainsObject) == 0)
+			{
+				lineFlags = (LineFlags)((offset & Constants::LineSizeInBytesMask) | (uint8_t)LineFlags::ContainsObject | 
+					(uint8_t)LineFlags::Marked);
+			}
+			for (uint32_t i = lineIndex + 1; i <= (end >> Constants::LineBits); i++)
 			{
-				Header.LineFlags[i] &= ~LineFlags::Marked;
+				Header.LineFlags[i] |= LineFlags::Marked;
 			}
+			Header.Info.Marked = 1;
+
+			SetObjectStart(offset);
+			return (StandardObjectAddress*)((intptr_t)this + offset);
 		}
 
+		/**
+		Clears the free lines of this block if they have not been cleared since the last recycle. Called when the block is 
+		claimed for allocation, so that the collection pause doesn't have to clear the whole heap.
+		*/
+		inline void ClearFreeLines()
+		{
+			if (!Header.Info.Dirty)
+			{
+				return;
+			}
+			Header.Info.Dirty = 0;
+
+			// A free block is cleared at once, most of it will be evicted from the cache before being allocated
+			if (Header.Info.UsedLineCount == 0)
+			{
+				Memory::ClearNonTemporal(&Lines[Constants::HeaderLineCount], Constants::EffectiveBlockSizeInBytes);
+				return;
+			}
+
+			uint32_t holeStart;
+			uint32_t holeEnd;
+			for (uint32_t line = Constants::HeaderLineCount; 
+				LineMask::FindHole(Header.Info.UsedLines, line, 1, holeStart, holeEnd); line = holeEnd)
+			{
+				Memory::ClearLarge(&Lines[holeStart], Constants::LineSizeInBytes * (holeEnd - holeStart));
+			}
+		}
+	private:
+		gcix_disable_new_delete_operator();
+		friend class Chunk;
+		FRIEND_TEST(BlockDataTest, ClearFreeLines);
+
+		/* Number of words of the object start bitmap per line */
+		static const uint32_t ObjectStartWordCountPerLine = Constants::LineSizeInBytes >> (Constants::ObjectGranuleBits + 5);
+
 		/**
 		Initialize this block
 		*/
@@ -181,50 +449,85 @@ namespace gcix
 
 		/**
 		Clears unmarked lines and mark the block free, recyclable or marked.
+		Line marks are transferred to @see Header.Info.UsedLines and cleared, so that the next collection starts without 
+		any marked line.
+		@param sticky true after a sticky trace: objects that survived previous collections were not traced, so that the 
+		lines used by them are kept in addition to the lines marked.
 		*/
-		__declspec(noinline) void Recycle()
+		gcix_noinline void Recycle(bool sticky)
 		{
+			// The free lines of a block allocated into since the last recycle have to be cleared before being reused
+			if (!IsFree())
+			{
+				Header.Info.Dirty = 1;
+			}
+
+			Header.Info.Evacuating = 0;
 			Header.Info.BumpCursor = 0;
 			Header.Info.BumpCursorLimit = 0;
 			Header.Info.UsedLineCount = 0;
 			Header.Info.ConsecutiveUsedLineCount = 0;
 
-			// If the block is marked, check if it is recyclable (at least one free line)
-			if (IsUnavailable())
+			auto usedLines = Header.Info.UsedLines;
+
+			// Lines used by old objects, without the header lines
+			uint32_t oldLines[LineMask::WordCount];
+			bool hasOldLines = false;
+			if (sticky)
 			{
-				bool previousLineWasUsed = false;
-				for(uint32_t i = Constants::HeaderLineCount; i < Constants::LineCount; i++)
+				for (uint32_t i = 0; i < LineMask::WordCount; i++)
 				{
-					if ((Header.LineFlags[i] & LineFlags::Marked) != 0)
-					{
-						Header.Info.UsedLineCount++;
-						if (previousLineWasUsed)
-						{
-							Header.Info.ConsecutiveUsedLineCount++;
-						}
-						previousLineWasUsed = true;
-						if (Header.Info.BumpCursorLimit == 0 && Header.Info.BumpCursor != 0)
-						{
-							Header.Info.BumpCursorLimit = i << Constants::LineBits;
-						}
-					}
-					else
-					{
-						previousLineWasUsed = false;
-						Header.LineFlags[i] = LineFlags::Empty;
-						if (Header.Info.BumpCursor == 0)
-						{
-							Header.Info.BumpCursor = i << Constants::LineBits;
-						}
+					oldLines[i] = usedLines[i];
+				}
+				oldLines[0] &= ~((1u << Constants::HeaderLineCount) - 1);
+				for (uint32_t i = 0; i < LineMask::WordCount; i++)
+				{
+					hasOldLines |= oldLines[i] != 0;
+				}
+			}
 
-						// Clear the line to recycle.
-						Memory::ClearSmall(&Lines[i], Constants::LineSizeInBytes);
+			// If the block is marked or contains old objects, check if it is recyclable (at least one free line)
+			if (Header.Info.Marked || hasOldLines)
+			{
+				Header.Info.Marked = 0;
+
+				// Transfer line marks to the used lines mask
+				LineMask::ExtractMarkedLines(Header.LineFlags, usedLines);
+				if (hasOldLines)
+				{
+					for (uint32_t i = 0; i < LineMask::WordCount; i++)
+					{
+						usedLines[i] |= oldLines[i];
 					}
 				}
 
-				if (Header.Info.BumpCursor != 0 && Header.Info.BumpCursorLimit == 0)
+				Header.Info.UsedLineCount = (uint8_t)LineMask::CountLines(usedLines);
+				Header.Info.ConsecutiveUsedLineCount = (uint8_t)LineMask::CountConsecutiveLines(usedLines);
+
+				// Header lines are never available for allocation
+				usedLines[0] |= (1u << Constants::HeaderLineCount) - 1;
+
+				// Clear all holes
+				uint32_t holeStart;
+				uint32_t holeEnd;
+				for (uint32_t line = Constants::HeaderLineCount; LineMask::FindHole(usedLines, line, 1, holeStart, holeEnd);
+					line = holeEnd)
 				{
-					Header.Info.BumpCursorLimit = Constants::LineCount << Constants::LineBits;
+					// The first hole is used as the initial bump cursor range
+					if (Header.Info.BumpCursor == 0)
+					{
+						Header.Info.BumpCursor = holeStart << Constants::LineBits;
+						Header.Info.BumpCursorLimit = holeEnd << Constants::LineBits;
+					}
+
+					for (uint32_t i = holeStart; i < holeEnd; i++)
+					{
+						Header.LineFlags[i] = LineFlags::Empty;
+					}
+					for (uint32_t i = holeStart * ObjectStartWordCountPerLine; i < holeEnd * ObjectStartWordCountPerLine; i++)
+					{
+						Header.ObjectStarts[i] = 0;
+					}
 				}
 
 				Header.Info.BlockFlags = Header.Info.UsedLineCount == Constants::EffectiveLineCount ? BlockFlags::Unavailable :
@@ -233,8 +536,14 @@ namespace gcix
 			else
 			{
 				Header.Info.BlockFlags = BlockFlags::Free;
-				//memset(&Lines[1], 0, Constants::LineSizeInBytes * (Constants::LineCount - 1));
-				Memory::ClearSmall(&Lines[1], Constants::LineSizeInBytes * (Constants::LineCount - 1));
+				for (uint32_t i = 0; i < LineMask::WordCount; i++)
+				{
+					usedLines[i] = 0;
+				}
+				usedLines[0] = (1u << Constants::HeaderLineCount) - 1;
+
+				// Clear the line flags and the object start bitmap, the lines are cleared by ClearFreeLines
+				Memory::ClearSmall(&Lines[1], Constants::LineSizeInBytes * (Constants::HeaderLineCount - 1));
 			}
 
 			if (Header.Info.BumpCursor == 0)
@@ -244,4 +553,5 @@ namespace gcix
 		}
 	};
 	static_assert(sizeof(BlockData) == Constants::BlockSizeInBytes, "Size of BlockData doesn't match expected size");
+	static_assert(sizeof(BlockData::Header) == Constants::HeaderSizeInBytes, "Size of BlockData header doesn't match expected size");
 }
\ No newline at end of file
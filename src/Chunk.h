@@ -22,11 +22,12 @@
 #include "Common.h"
 #include "Constants.h"
 #include "BlockData.h"
+#include "ChunkSpace.h"
 
 namespace gcix
 {
 	/**
-	A chunk contains several continous blocks in memory, aligned on a block size in memory.
+	A chunk contains several continous blocks in memory, aligned on a chunk size in memory.
 	*/
 	class Chunk
 	{
@@ -89,23 +90,21 @@ namespace gcix
 		Chunk() {} 
 
 		/**
-		Overrides new operator for chunk for handling special alignment and initialization.
+		Overrides new operator for chunk for handling special alignment and initialization. Declared as not throwing, 
+		so that the compiler checks the `nullptr` returned on out of memory before calling the constructor.
 		*/
-		static void* operator new (size_t size)
+		static void* operator new (size_t) throw()
 		{
-			// We are not using the original size of the chunk, as a chunk is a special block of memory
-			auto rawChunk = Memory::AllocateZero(Constants::ChunkSizeInBytes + Constants::BlockSizeInBytes);
+			// We are not using the original size of the chunk, as a chunk is a special block of memory. The memory of a 
+			// chunk is aligned and already zeroed.
+			auto chunk = (Chunk*)ChunkSpace::Instance->Allocate();
 
 			// out of memory, early exit
-			if (rawChunk == nullptr)
+			if (chunk == nullptr)
 			{
 				return nullptr;
 			}
 
-			// Align on a Block size boundary
-			auto chunk = (Chunk*)(((intptr_t)rawChunk + Constants::BlockSizeInBytes - 1)
-				& (~((intptr_t)(1 << Constants::BlockBits) - 1)));
-
 			// Initialize all blocks
 			for (int i = 0; i < chunk->GetBlockCount(); i++)
 			{
@@ -113,12 +112,10 @@ namespace gcix
 			}
 
 			// Set the chunk header AFTER block are initialized (as block initialize clear all information)
-			chunk->Header.AllocationOffset = (int32_t)((intptr_t)rawChunk - (intptr_t)chunk);
 			chunk->Header.BlockUnavailableCount = 0;
 			chunk->Header.BlockRecyclableCount = 0;
-
-			// TODO: Reuse space lost by alignment as a storage for an additionnal LargeObjectSpace for objects with a size 
-			// < Constants::BlockSizeInBytes
+			chunk->Header.FreeCollectionCount = 0;
+			chunk->Header.SweepEpoch = 0;
 
 			return (void*)chunk;
 		}
@@ -128,23 +125,9 @@ namespace gcix
 		*/
 		static void operator delete (void *p)
 		{
-			// Add gcix_assert here.
-			Chunk* chunk = (Chunk*)p;
-			auto rawChunk = (intptr_t)p + chunk->Header.AllocationOffset;
-			Memory::Free((void*)rawChunk);
-		}
-		/**
-		Clear marked flags on blocks.
-		*/
-		inline void ClearMarked()
-		{
-			auto count = GetBlockCount();
-			for(int i = 0; i < count; i++)
-			{
-				GetBlock(i)->ClearMarked();
-			}
+			gcix_assert(p != nullptr);
+			ChunkSpace::Instance->Free(p);
 		}
-
 		/**
 		Test if the block is recyclable, return true and update internal statistics. The block should then be used for 
 		recyclable allocation.
@@ -184,17 +167,21 @@ namespace gcix
 
 		/**
 		Recycle all blocks and update internal block and chunk statistics.
+		@param sticky true after a sticky trace (see @see BlockData::Recycle)
+		@return the number of lines used by the objects that survived in this chunk
 		*/
-		inline void Recycle()
+		inline uint32_t Recycle(bool sticky)
 		{
 			Header.BlockUnavailableCount = 0;
 			Header.BlockRecyclableCount = 0;
 
+			uint32_t usedLineCount = 0;
 			auto count = GetBlockCount();
 			for(int i = 0; i < count; i++)
 			{
 				auto block = GetBlock(i);
-				block->Recycle();
+				block->Recycle(sticky);
+				usedLineCount += block->Header.Info.UsedLineCount;
 				if (block->IsUnavailable())
 				{
 					Header.BlockUnavailableCount++;
@@ -204,6 +191,16 @@ namespace gcix
 					Header.BlockRecyclableCount++;
 				}
 			}
+
+			if (!IsFree())
+			{
+				Header.FreeCollectionCount = 0;
+			}
+			else if (Header.FreeCollectionCount < 0xFFFF)
+			{
+				Header.FreeCollectionCount++;
+			}
+			return usedLineCount;
 		}
 	};
 }
\ No newline at end of file
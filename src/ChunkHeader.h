@@ -28,12 +28,6 @@ namespace gcix
 	*/
 	struct ChunkHeader
 	{
-		/**
-		The offset between the address of a chunk and the raw address allocated for the chunk (in order to satisfy block
-		alignment).
-		*/
-		int32_t AllocationOffset;
-
 		/**
 		The number of unavailable blocks in this chunk.
 		*/
@@ -43,5 +37,15 @@ namespace gcix
 		The number of recyclable blocks in this chunk.
 		*/
 		uint16_t BlockRecyclableCount;
+
+		/**
+		The number of consecutive collections this chunk has been found free.
+		*/
+		uint16_t FreeCollectionCount;
+
+		/**
+		The sweep epoch of the last collection this chunk has been swept for.
+		*/
+		uint16_t SweepEpoch;
 	};
 }
\ No newline at end of file
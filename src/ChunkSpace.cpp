@@ -0,0 +1,182 @@
+﻿// Copyright (c) 2014, Alexandre Mutel
+// All rights reserved.
+// 
+// Redistribution and use in source and binary forms, with or without modification, are permitted provided that the following  
+// conditions are met:
+// 
+// 1. Redistributions of source code must retain the above copyright notice, this list of conditions and the following 
+//    disclaimer.
+// 
+// 2. Redistributions in binary form must reproduce the above copyright notice, this list of conditions and the following 
+//    disclaimer in the documentation and/or other materials provided with the distribution.
+// 
+// THIS SOFTWARE IS PROVIDED BY THE COPYRIGHT HOLDERS AND CONTRIBUTORS "AS IS" AND ANY EXPRESS OR IMPLIED WARRANTIES, 
+// INCLUDING, BUT NOT LIMITED TO, THE IMPLIED WARRANTIES OF MERCHANTABILITY AND FITNESS FOR A PARTICULAR PURPOSE ARE 
+// DISCLAIMED. IN NO EVENT SHALL THE COPYRIGHT HOLDER OR CONTRIBUTORS BE LIABLE FOR ANY DIRECT, INDIRECT, INCIDENTAL, SPECIAL, 
+// EXEMPLARY, OR CONSEQUENTIAL DAMAGES (INCLUDING, BUT NOT LIMITED TO, PROCUREMENT OF SUBSTITUTE GOODS OR SERVICES; LOSS OF 
+// USE, DATA, OR PROFITS; OR BUSINESS INTERRUPTION) HOWEVER CAUSED AND ON ANY THEORY OF LIABILITY, WHETHER IN CONTRACT, STRICT 
+// LIABILITY, OR TORT (INCLUDING NEGLIGENCE OR OTHERWISE) ARISING IN ANY WAY OUT OF THE USE OF THIS SOFTWARE, EVEN IF ADVISED 
+// OF THE POSSIBILITY OF SUCH DAMAGE.
+
+#include "gcix.h"
+
+#include "ChunkSpace.h"
+
+namespace gcix
+{
+	/**
+	Initialize the @see ChunkSpace::Instance variable.
+	*/
+	void ChunkSpace::Initialize()
+	{
+		if (Instance == nullptr)
+		{
+			Instance = new ChunkSpace();
+		}
+	}
+
+	ChunkSpace::ChunkSpace() : 
+		reservations(ReservationCount), 
+		freeChunks(FreeChunkCount), 
+		releasedChunks(FreeChunkCount), 
+		decommitThread(nullptr),
+		nextChunk(0), 
+		endOfReservation(0)
+	{
+#if (GCIX_HEAP_RESERVATION_SIZE > 0)
+		heapStart = 0;
+		heapSize = 0;
+		allocatedChunks = (uint8_t*)Memory::AllocateZero(HeapSize >> ChunkBits);
+		auto heap = allocatedChunks != nullptr ? Memory::Reserve(HeapSize, ReservationAlignment) : nullptr;
+
+		// out of memory, all the allocations will fail
+		if (heap == nullptr)
+		{
+			return;
+		}
+
+#if (GCIX_ENABLE_HUGE_PAGES == 1)
+		Memory::AdviseHugePages(heap, HeapSize);
+#endif
+		reservations.Add(heap);
+		heapStart = (intptr_t)heap;
+		heapSize = HeapSize;
+		nextChunk = heapStart;
+		endOfReservation = heapStart + HeapSize;
+#endif
+	}
+
+	void* ChunkSpace::Allocate()
+	{
+		gcix_lock(mutexChunks);
+
+		void* chunk;
+		int32_t freeChunkCount = freeChunks.Count();
+		if (freeChunkCount > 0)
+		{
+			chunk = freeChunks[freeChunkCount - 1];
+			freeChunks.Remove(freeChunkCount - 1);
+		}
+		else if (releasedChunks.Count() > 0)
+		{
+			// Not decommitted yet, decommit it now to get zeroed pages
+			chunk = releasedChunks[releasedChunks.Count() - 1];
+			releasedChunks.Remove(releasedChunks.Count() - 1);
+			Memory::Decommit(chunk, Constants::ChunkSizeInBytes);
+		}
+		else
+		{
+			if (nextChunk == endOfReservation)
+			{
+#if (GCIX_HEAP_RESERVATION_SIZE > 0)
+				// The heap range is exhausted
+				return nullptr;
+#endif
+				auto reservation = Memory::Reserve(ReservationSize, ReservationAlignment);
+
+				// out of memory, early exit
+				if (reservation == nullptr)
+				{
+					return nullptr;
+				}
+
+#if (GCIX_ENABLE_HUGE_PAGES == 1)
+				Memory::AdviseHugePages(reservation, ReservationSize);
+#endif
+				reservations.Add(reservation);
+				nextChunk = (intptr_t)reservation;
+				endOfReservation = nextChunk + ReservationSize;
+			}
+
+			chunk = (void*)nextChunk;
+			nextChunk += Constants::ChunkSizeInBytes;
+		}
+
+		if (!Memory::Commit(chunk, Constants::ChunkSizeInBytes))
+		{
+			freeChunks.Add(chunk);
+			return nullptr;
+		}
+
+#if (GCIX_HEAP_RESERVATION_SIZE > 0)
+		allocatedChunks[((intptr_t)chunk - heapStart) >> ChunkBits] = 1;
+#endif
+		return chunk;
+	}
+
+	void ChunkSpace::Free(void* chunk)
+	{
+		gcix_assert(chunk != nullptr);
+		gcix_assert(((intptr_t)chunk & (Constants::ChunkSizeInBytes - 1)) == 0);
+
+		gcix_lock(mutexChunks);
+
+#if (GCIX_HEAP_RESERVATION_SIZE > 0)
+		allocatedChunks[((intptr_t)chunk - heapStart) >> ChunkBits] = 0;
+#endif
+		releasedChunks.Add(chunk);
+		if (decommitThread == nullptr)
+		{
+			decommitThread = new Thread(DecommitRun, this);
+		}
+		decommitEvent.Set();
+	}
+
+	void ChunkSpace::DecommitReleasedChunks()
+	{
+		while (true)
+		{
+			void* chunk;
+			{
+				gcix_lock(mutexChunks);
+
+				int32_t releasedChunkCount = releasedChunks.Count();
+				if (releasedChunkCount == 0)
+				{
+					decommitEvent.Reset();
+					return;
+				}
+				chunk = releasedChunks[releasedChunkCount - 1];
+				releasedChunks.Remove(releasedChunkCount - 1);
+			}
+
+			// The chunk is owned by this thread until it is added back to the free chunks
+			Memory::Decommit(chunk, Constants::ChunkSizeInBytes);
+
+			gcix_lock(mutexChunks);
+			freeChunks.Add(chunk);
+		}
+	}
+
+	void ChunkSpace::DecommitRun(void* context)
+	{
+		auto chunkSpace = (ChunkSpace*)context;
+		while (true)
+		{
+			chunkSpace->decommitEvent.WaitOne();
+			chunkSpace->DecommitReleasedChunks();
+		}
+	}
+
+	ChunkSpace* ChunkSpace::Instance;
+}
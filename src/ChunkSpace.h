@@ -0,0 +1,148 @@
+﻿#pragma once
+// Copyright (c) 2014, Alexandre Mutel
+// All rights reserved.
+// 
+// Redistribution and use in source and binary forms, with or without modification, are permitted provided that the following 
+// conditions are met:
+// 
+// 1. Redistributions of source code must retain the above copyright notice, this list of conditions and the following 
+//    disclaimer.
+// 
+// 2. Redistributions in binary form must reproduce the above copyright notice, this list of conditions and the following 
+//    disclaimer in the documentation and/or other materials provided with the distribution.
+// 
+// THIS SOFTWARE IS PROVIDED BY THE COPYRIGHT HOLDERS AND CONTRIBUTORS "AS IS" AND ANY EXPRESS OR IMPLIED WARRANTIES, 
+// INCLUDING, BUT NOT LIMITED TO, THE IMPLIED WARRANTIES OF MERCHANTABILITY AND FITNESS FOR A PARTICULAR PURPOSE ARE 
+// DISCLAIMED. IN NO EVENT SHALL THE COPYRIGHT HOLDER OR CONTRIBUTORS BE LIABLE FOR ANY DIRECT, INDIRECT, INCIDENTAL, SPECIAL, 
+// EXEMPLARY, OR CONSEQUENTIAL DAMAGES (INCLUDING, BUT NOT LIMITED TO, PROCUREMENT OF SUBSTITUTE GOODS OR SERVICES; LOSS OF 
+// USE, DATA, OR PROFITS; OR BUSINESS INTERRUPTION) HOWEVER CAUSED AND ON ANY THEORY OF LIABILITY, WHETHER IN CONTRACT, STRICT 
+// LIABILITY, OR TORT (INCLUDING NEGLIGENCE OR OTHERWISE) ARISING IN ANY WAY OUT OF THE USE OF THIS SOFTWARE, EVEN IF ADVISED 
+// OF THE POSSIBILITY OF SUCH DAMAGE.
+
+
+#include "Common.h"
+#include "Constants.h"
+#include "Collections/List.h"
+#include "Threading/Mutex.h"
+#include "Threading/Thread.h"
+#include "Threading/ManualResetEvent.h"
+#include "Utility/Memory.h"
+
+namespace gcix
+{
+	/**
+	Provides the memory of chunks. Chunks are carved from large ranges of virtual memory reserved at once 
+	(GCIX_CHUNK_RESERVATION_SIZE), so that they are naturally aligned without any slack, and are committed on demand.
+	Committed memory is zeroed by the OS, so that a new chunk doesn't have to be cleared. Freed chunks are decommitted by a 
+	background thread, off the collection pause, and reused first by the next allocations.
+	When GCIX_HEAP_RESERVATION_SIZE is set, a single range is reserved at initialization for all the chunks, so that the 
+	chunk of an address is found arithmetically with @see FindChunk.
+	*/
+	class ChunkSpace
+	{
+	public:
+		/**
+		Initialize the @see ChunkSpace::Instance variable.
+		*/
+		static void Initialize();
+
+		/**
+		Allocates the memory of a chunk, aligned on @see Constants::ChunkSizeInBytes and zeroed.
+		@return the address of the chunk or `nullptr` in case of an out of memory
+		*/
+		void* Allocate();
+
+		/**
+		Frees the memory of a chunk allocated by @see Allocate. Its physical pages are returned to the OS asynchronously.
+		*/
+		void Free(void* chunk);
+
+#if (GCIX_HEAP_RESERVATION_SIZE > 0)
+		/**
+		Determines whether the specified address is inside the reserved heap range.
+		*/
+		inline bool Contains(const void* ptr) const
+		{
+			return (size_t)((intptr_t)ptr - heapStart) < heapSize;
+		}
+
+		/**
+		Finds the allocated chunk containing the specified address.
+		@return the address of the chunk or `nullptr` if the address is not inside an allocated chunk
+		*/
+		inline void* FindChunk(const void* ptr) const
+		{
+			auto offset = (size_t)((intptr_t)ptr - heapStart);
+			if (offset >= heapSize || allocatedChunks[offset >> ChunkBits] == 0)
+			{
+				return nullptr;
+			}
+			return (void*)(heapStart + (offset & ~((size_t)Constants::ChunkSizeInBytes - 1)));
+		}
+#endif
+
+		static ChunkSpace* Instance;
+	private:
+		gcix_overrides_new_delete();
+
+		ChunkSpace();
+
+		/* Decommits the released chunks until there are none left */
+		void DecommitReleasedChunks();
+
+		/* Entry point of the decommit thread */
+		static void DecommitRun(void* context);
+
+		static const int ReservationCount = 64;
+		static const int FreeChunkCount = 512;
+
+		/* Size of a reserved range, multiple of the size of a chunk */
+		static const size_t ReservationSize = ((size_t)GCIX_CHUNK_RESERVATION_SIZE + Constants::ChunkSizeInBytes - 1) & 
+			~((size_t)Constants::ChunkSizeInBytes - 1);
+
+		/* Alignment of a reserved range, large enough to be backed by huge pages */
+		static const size_t ReservationAlignment = 2 << 20;
+
+		static_assert(ReservationAlignment % Constants::ChunkSizeInBytes == 0, 
+			"ReservationAlignment must be a multiple of the size of a chunk");
+
+#if (GCIX_HEAP_RESERVATION_SIZE > 0)
+		/* Size of a chunk in bits */
+		static const uint32_t ChunkBits = Constants::BlockBits + Constants::BlockCountBitsPerChunk;
+
+		/* Size of the reserved heap range, multiple of the size of a chunk */
+		static const size_t HeapSize = ((size_t)GCIX_HEAP_RESERVATION_SIZE + Constants::ChunkSizeInBytes - 1) & 
+			~((size_t)Constants::ChunkSizeInBytes - 1);
+#endif
+
+		Mutex mutexChunks;
+
+		/* Ranges of virtual memory reserved so far */
+		List<void*> reservations;
+
+		/* Decommitted chunks to reuse */
+		List<void*> freeChunks;
+
+		/* Freed chunks still committed, waiting for the decommit thread */
+		List<void*> releasedChunks;
+
+		/* Event used to wake up the decommit thread, created on the first free */
+		ManualResetEvent decommitEvent;
+		Thread* decommitThread;
+
+		/* Next chunk never allocated in the last reserved range */
+		intptr_t nextChunk;
+
+		/* End of the last reserved range */
+		intptr_t endOfReservation;
+
+#if (GCIX_HEAP_RESERVATION_SIZE > 0)
+		/* Start and size of the reserved heap range, the size is 0 if it could not be reserved */
+		intptr_t heapStart;
+		size_t heapSize;
+
+		/* A non zero byte per chunk of the heap range currently allocated */
+		uint8_t* allocatedChunks;
+#endif
+	};
+}
@@ -20,7 +20,7 @@
 // OF THE POSSIBILITY OF SUCH DAMAGE.
 
 #include "Common.h"
-#include "Utility\Memory.h"
+#include "Utility/Memory.h"
 
 namespace gcix
 {
@@ -84,6 +84,12 @@ namespace gcix
 			count = 0;
 		}
 
+		inline void Truncate(int32_t newCount)
+		{
+			gcix_assert(newCount >= 0 && newCount <= count);
+			count = newCount;
+		}
+
 		inline void Add(const T& item)
 		{
 			if (count == capacity)
@@ -0,0 +1,136 @@
+﻿#pragma once
+// Copyright (c) 2014, Alexandre Mutel
+// All rights reserved.
+// 
+// Redistribution and use in source and binary forms, with or without modification, are permitted provided that the following 
+// conditions are met:
+// 
+// 1. Redistributions of source code must retain the above copyright notice, this list of conditions and the following 
+//    disclaimer.
+// 
+// 2. Redistributions in binary form must reproduce the above copyright notice, this list of conditions and the following 
+//    disclaimer in the documentation and/or other materials provided with the distribution.
+// 
+// THIS SOFTWARE IS PROVIDED BY THE COPYRIGHT HOLDERS AND CONTRIBUTORS "AS IS" AND ANY EXPRESS OR IMPLIED WARRANTIES, 
+// INCLUDING, BUT NOT LIMITED TO, THE IMPLIED WARRANTIES OF MERCHANTABILITY AND FITNESS FOR A PARTICULAR PURPOSE ARE 
+// DISCLAIMED. IN NO EVENT SHALL THE COPYRIGHT HOLDER OR CONTRIBUTORS BE LIABLE FOR ANY DIRECT, INDIRECT, INCIDENTAL, SPECIAL, 
+// EXEMPLARY, OR CONSEQUENTIAL DAMAGES (INCLUDING, BUT NOT LIMITED TO, PROCUREMENT OF SUBSTITUTE GOODS OR SERVICES; LOSS OF 
+// USE, DATA, OR PROFITS; OR BUSINESS INTERRUPTION) HOWEVER CAUSED AND ON ANY THEORY OF LIABILITY, WHETHER IN CONTRACT, STRICT 
+// LIABILITY, OR TORT (INCLUDING NEGLIGENCE OR OTHERWISE) ARISING IN ANY WAY OUT OF THE USE OF THIS SOFTWARE, EVEN IF ADVISED 
+// OF THE POSSIBILITY OF SUCH DAMAGE.
+
+
+#include "Common.h"
+#include "Utility/Memory.h"
+
+namespace gcix
+{
+	/**
+	A two-level radix map from an address to a value of type T, one value per page of (1 << TPageBits) bytes.
+	A lookup costs at most two dependent loads (root then leaf) whatever the number of pages mapped. Leaves are 
+	allocated lazily when a page is first set and are never freed before the map is destroyed.
+	Reads are not synchronized with writes: callers must serialize @see Set and @see Get.
+	*/
+	template<typename T, uint32_t TPageBits>
+	class PageMap
+	{
+	public:
+		/** Number of significant bits of an address (user space canonical addresses on x64) */
+		static const uint32_t AddressBits = sizeof(void*) == 8 ? 48 : 32;
+
+		/** Number of bits of a page index */
+		static const uint32_t KeyBits = AddressBits - TPageBits;
+
+		/** Number of bits of a page index resolved by a leaf */
+		static const uint32_t LeafBits = KeyBits / 2;
+
+		/** Number of bits of a page index resolved by the root */
+		static const uint32_t RootBits = KeyBits - LeafBits;
+
+		static const size_t RootCount = (size_t)1 << RootBits;
+		static const size_t LeafCount = (size_t)1 << LeafBits;
+
+		PageMap() : root((T**)Memory::AllocateZero(RootCount * sizeof(T*)))
+		{
+		}
+
+		~PageMap()
+		{
+			if (root == nullptr)
+			{
+				return;
+			}
+			for (size_t i = 0; i < RootCount; i++)
+			{
+				if (root[i] != nullptr)
+				{
+					Memory::Free(root[i]);
+				}
+			}
+			Memory::Free(root);
+		}
+
+		/**
+		Returns the value of the page containing the specified address, or `nullptr` if this page was never set.
+		This method never allocates.
+		*/
+		inline T* Find(const void* ptr) const
+		{
+			auto page = (uint64_t)(size_t)ptr >> TPageBits;
+			if ((page >> KeyBits) != 0)
+			{
+				return nullptr;
+			}
+			auto leaf = root[(size_t)page >> LeafBits];
+			return leaf == nullptr ? nullptr : &leaf[(size_t)page & (LeafCount - 1)];
+		}
+
+		/**
+		Returns the value of the page containing the specified address, allocating the leaf if necessary. 
+		@return a pointer to the value of the page or `nullptr` in case of an out of memory.
+		*/
+		inline T* Get(const void* ptr)
+		{
+			auto page = (uint64_t)(size_t)ptr >> TPageBits;
+			gcix_assert((page >> KeyBits) == 0);
+			if (root == nullptr)
+			{
+				return nullptr;
+			}
+
+			auto& leaf = root[(size_t)page >> LeafBits];
+			if (leaf == nullptr)
+			{
+				leaf = (T*)Memory::AllocateZero(LeafCount * sizeof(T));
+				if (leaf == nullptr)
+				{
+					return nullptr;
+				}
+			}
+			return &leaf[(size_t)page & (LeafCount - 1)];
+		}
+
+		/**
+		Sets the value of all the pages overlapping the range [start, end).
+		@return false in case of an out of memory (some pages might have been set).
+		*/
+		inline bool Set(const void* start, const void* end, const T& value)
+		{
+			for (auto page = (size_t)start >> TPageBits; page <= ((size_t)end - 1) >> TPageBits; page++)
+			{
+				auto entry = Get((void*)(page << TPageBits));
+				if (entry == nullptr)
+				{
+					return false;
+				}
+				*entry = value;
+			}
+			return true;
+		}
+
+	private:
+		PageMap(const PageMap& pageMap) {}
+
+		T** root;
+	};
+}
@@ -18,5 +18,5 @@
 // LIABILITY, OR TORT (INCLUDING NEGLIGENCE OR OTHERWISE) ARISING IN ANY WAY OUT OF THE USE OF THIS SOFTWARE, EVEN IF ADVISED 
 // OF THE POSSIBILITY OF SUCH DAMAGE.
 
-#include "Utility\Memory.h"
-#include "Collections\SequentialStoreBuffer.h"
+#include "Utility/Memory.h"
+#include "Collections/SequentialStoreBuffer.h"
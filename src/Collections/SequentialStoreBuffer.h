@@ -20,9 +20,9 @@
 // OF THE POSSIBILITY OF SUCH DAMAGE.
 
 #include "Common.h"
-#include "Utility\Memory.h"
-#include "Threading\Mutex.h"
-#include "Collections\List.h"
+#include "Utility/Memory.h"
+#include "Threading/Mutex.h"
+#include "Collections/List.h"
 
 namespace gcix
 {
@@ -113,7 +113,7 @@ namespace gcix
 	/**
 	Main memory class handling memory allocation in gcix
 	*/
-	template<int TSize = 4096, int TChunkCount = 8>
+	template<int TSize, int TChunkCount>
 	class SequentialStoreBuffer
 	{
 	private:
@@ -172,7 +172,7 @@ namespace gcix
 		FRIEND_TEST(SequentialStoreBufferTest, TestAllocation);
 	};
 
-	template<int TSize = 4096, int TChunkCount = 8>
+	template<int TSize, int TChunkCount>
 	class SequentialStoreBufferHandle
 	{
 	private:
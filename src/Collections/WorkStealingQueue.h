@@ -0,0 +1,133 @@
+﻿#pragma once
+// Copyright (c) 2014, Alexandre Mutel
+// All rights reserved.
+// 
+// Redistribution and use in source and binary forms, with or without modification, are permitted provided that the following 
+// conditions are met:
+// 
+// 1. Redistributions of source code must retain the above copyright notice, this list of conditions and the following 
+//    disclaimer.
+// 
+// 2. Redistributions in binary form must reproduce the above copyright notice, this list of conditions and the following 
+//    disclaimer in the documentation and/or other materials provided with the distribution.
+// 
+// THIS SOFTWARE IS PROVIDED BY THE COPYRIGHT HOLDERS AND CONTRIBUTORS "AS IS" AND ANY EXPRESS OR IMPLIED WARRANTIES, 
+// INCLUDING, BUT NOT LIMITED TO, THE IMPLIED WARRANTIES OF MERCHANTABILITY AND FITNESS FOR A PARTICULAR PURPOSE ARE 
+// DISCLAIMED. IN NO EVENT SHALL THE COPYRIGHT HOLDER OR CONTRIBUTORS BE LIABLE FOR ANY DIRECT, INDIRECT, INCIDENTAL, SPECIAL, 
+// EXEMPLARY, OR CONSEQUENTIAL DAMAGES (INCLUDING, BUT NOT LIMITED TO, PROCUREMENT OF SUBSTITUTE GOODS OR SERVICES; LOSS OF 
+// USE, DATA, OR PROFITS; OR BUSINESS INTERRUPTION) HOWEVER CAUSED AND ON ANY THEORY OF LIABILITY, WHETHER IN CONTRACT, STRICT 
+// LIABILITY, OR TORT (INCLUDING NEGLIGENCE OR OTHERWISE) ARISING IN ANY WAY OUT OF THE USE OF THIS SOFTWARE, EVEN IF ADVISED 
+// OF THE POSSIBILITY OF SUCH DAMAGE.
+
+
+#include "Common.h"
+#include "Utility/Memory.h"
+
+#include <atomic>
+
+namespace gcix
+{
+	/**
+	A bounded Chase-Lev work stealing queue.
+	The owner thread pushes and pops items at the bottom of the queue (LIFO), while other threads can steal items from the
+	top of the queue (FIFO). Implementation follows "Correct and Efficient Work-Stealing for Weak Memory Models" 
+	(Le, Pop, Cohen, Zappa Nardelli - PPoPP 2013) without the growing of the circular array: when the queue is full, 
+	@see Push returns false and the owner is responsible to store the item elsewhere.
+	@param T type of an item. Must be a pointer or an integral type.
+	@param TCapacity number of items this queue can hold. Must be a power of two.
+	*/
+	template<typename T, int32_t TCapacity = 4096>
+	class WorkStealingQueue
+	{
+	public:
+		const static int32_t Capacity = TCapacity;
+
+		WorkStealingQueue() : top(0), bottom(0)
+		{
+		}
+
+		/**
+		Pushes an item at the bottom of this queue. Must only be called by the owner thread.
+		@return false if the queue is full
+		*/
+		inline bool Push(T item)
+		{
+			auto b = bottom.load(std::memory_order_relaxed);
+			auto t = top.load(std::memory_order_acquire);
+			if (b - t >= TCapacity)
+			{
+				return false;
+			}
+			items[b & (TCapacity - 1)].store(item, std::memory_order_relaxed);
+			std::atomic_thread_fence(std::memory_order_release);
+			bottom.store(b + 1, std::memory_order_relaxed);
+			return true;
+		}
+
+		/**
+		Pops an item from the bottom of this queue. Must only be called by the owner thread.
+		@return false if the queue is empty
+		*/
+		inline bool Pop(T& item)
+		{
+			auto b = bottom.load(std::memory_order_relaxed) - 1;
+			bottom.store(b, std::memory_order_relaxed);
+			std::atomic_thread_fence(std::memory_order_seq_cst);
+			auto t = top.load(std::memory_order_relaxed);
+
+			if (t > b)
+			{
+				// Queue was empty
+				bottom.store(b + 1, std::memory_order_relaxed);
+				return false;
+			}
+
+			item = items[b & (TCapacity - 1)].load(std::memory_order_relaxed);
+			if (t == b)
+			{
+				// Last item, race against thieves
+				bool won = top.compare_exchange_strong(t, t + 1, std::memory_order_seq_cst, std::memory_order_relaxed);
+				bottom.store(b + 1, std::memory_order_relaxed);
+				return won;
+			}
+			return true;
+		}
+
+		/**
+		Steals an item from the top of this queue. Can be called by any thread.
+		@return false if the queue is empty or if the item has been taken by another thread
+		*/
+		inline bool Steal(T& item)
+		{
+			auto t = top.load(std::memory_order_acquire);
+			std::atomic_thread_fence(std::memory_order_seq_cst);
+			auto b = bottom.load(std::memory_order_acquire);
+			if (t >= b)
+			{
+				return false;
+			}
+
+			item = items[t & (TCapacity - 1)].load(std::memory_order_relaxed);
+			return top.compare_exchange_strong(t, t + 1, std::memory_order_seq_cst, std::memory_order_relaxed);
+		}
+
+		/**
+		Determines whether this queue is empty. The result is only a hint when called from a thread other than the owner.
+		*/
+		inline bool IsEmpty() const
+		{
+			return bottom.load(std::memory_order_acquire) <= top.load(std::memory_order_acquire);
+		}
+
+		gcix_overrides_new_delete();
+	private:
+		WorkStealingQueue(const WorkStealingQueue&) = delete;
+		WorkStealingQueue& operator=(const WorkStealingQueue&) = delete;
+
+		std::atomic<int64_t> top;
+		std::atomic<int64_t> bottom;
+		std::atomic<T> items[TCapacity];
+
+		static_assert(TCapacity > 0 && (TCapacity & (TCapacity - 1)) == 0, "Invalid TCapacity. Must be power of two");
+	};
+}
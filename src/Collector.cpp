@@ -0,0 +1,896 @@
+﻿// Copyright (c) 2014, Alexandre Mutel
+// All rights reserved.
+// 
+// Redistribution and use in source and binary forms, with or without modification, are permitted provided that the following  
+// conditions are met:
+// 
+// 1. Redistributions of source code must retain the above copyright notice, this list of conditions and the following 
+//    disclaimer.
+// 
+// 2. Redistributions in binary form must reproduce the above copyright notice, this list of conditions and the following 
+//    disclaimer in the documentation and/or other materials provided with the distribution.
+// 
+// THIS SOFTWARE IS PROVIDED BY THE COPYRIGHT HOLDERS AND CONTRIBUTORS "AS IS" AND ANY EXPRESS OR IMPLIED WARRANTIES, 
+// INCLUDING, BUT NOT LIMITED TO, THE IMPLIED WARRANTIES OF MERCHANTABILITY AND FITNESS FOR A PARTICULAR PURPOSE ARE 
+// DISCLAIMED. IN NO EVENT SHALL THE COPYRIGHT HOLDER OR CONTRIBUTORS BE LIABLE FOR ANY DIRECT, INDIRECT, INCIDENTAL, SPECIAL, 
+// EXEMPLARY, OR CONSEQUENTIAL DAMAGES (INCLUDING, BUT NOT LIMITED TO, PROCUREMENT OF SUBSTITUTE GOODS OR SERVICES; LOSS OF 
+// USE, DATA, OR PROFITS; OR BUSINESS INTERRUPTION) HOWEVER CAUSED AND ON ANY THEORY OF LIABILITY, WHETHER IN CONTRACT, STRICT 
+// LIABILITY, OR TORT (INCLUDING NEGLIGENCE OR OTHERWISE) ARISING IN ANY WAY OUT OF THE USE OF THIS SOFTWARE, EVEN IF ADVISED 
+// OF THE POSSIBILITY OF SUCH DAMAGE.
+
+#include "gcix.h"
+
+#include "Collector.h"
+
+#include "GlobalAllocator.h"
+#include "ThreadLocalAllocator.h"
+#include "Marker.h"
+#include "Tracer.h"
+#include "Threading/Thread.h"
+#include "Utility/Histogram.h"
+
+#include <algorithm>
+#include <chrono>
+
+#ifdef GCIX_PLATFORM_WINDOWS
+#define WIN32_LEAN_AND_MEAN 1
+#include <Windows.h>
+#else
+#include <pthread.h>
+#include <signal.h>
+#include <string.h>
+#include <time.h>
+#endif
+
+namespace gcix
+{
+	static_assert(PauseHistogramBucketCount == Histogram::BucketCount, 
+		"PauseHistogramBucketCount must match the number of buckets of Histogram");
+
+	/**
+	Returns the nanoseconds elapsed between two time points.
+	*/
+	static inline uint64_t ElapsedNanoseconds(std::chrono::steady_clock::time_point start, 
+		std::chrono::steady_clock::time_point end)
+	{
+		return (uint64_t)std::chrono::duration_cast<std::chrono::nanoseconds>(end - start).count();
+	}
+
+#ifndef GCIX_PLATFORM_WINDOWS
+	/**
+	Handler of GCIX_SUSPEND_SIGNAL, running on the mutator thread to suspend. The registers of the thread are saved by 
+	the kernel on the stack, above the frame of this handler, so that they are scanned along the stack.
+	*/
+	void Collector::SuspendHandler(int)
+	{
+		auto mutator = ThreadLocalAllocator::Instance;
+
+		// If the thread is running gcix code or the fast path of the write barrier, it will reach a safepoint soon or will 
+		// be suspended by the next attempt
+		if (mutator == nullptr || mutator->inRuntime || InWriteBarrier)
+		{
+			return;
+		}
+
+		volatile int stackHere = 0;
+		mutator->stackFrame.SetTopOfStack((void*)&stackHere);
+
+		auto expected = MutatorState::Running;
+		if (!mutator->state.compare_exchange_strong(expected, MutatorState::Suspended))
+		{
+			return;
+		}
+
+		// Wait for the collector to resume this thread (nanosleep is async-signal-safe)
+		timespec delay = { 0, 100000 };
+		while (mutator->state.load() == MutatorState::Suspended)
+		{
+			nanosleep(&delay, nullptr);
+		}
+	}
+#endif
+
+	void Collector::Initialize()
+	{
+		if (Instance == nullptr)
+		{
+			Instance = new Collector();
+			UpdateWriteBarrierState();
+
+#ifndef GCIX_PLATFORM_WINDOWS
+			struct sigaction action;
+			memset(&action, 0, sizeof(action));
+			action.sa_handler = SuspendHandler;
+			action.sa_flags = SA_RESTART;
+			sigfillset(&action.sa_mask);
+			sigaction(GCIX_SUSPEND_SIGNAL, &action, nullptr);
+#endif
+		}
+	}
+
+	Collector::Collector() : safepointEpoch(0), mutators(MutatorCount), fullCollectionRequested(true),
+		previousCollectionSticky(false), liveBytesAfterFullCollection(0), rememberedSetAllocator(MutatorCount), 
+		rememberedSet(&rememberedSetAllocator), satbLog(&rememberedSetAllocator), 
+#if (GCIX_ENABLE_RC == 1)
+		previousCollectionCounted(false), decrementLog(&rememberedSetAllocator), rootLog(&rememberedSetAllocator), 
+		previousRootLog(&rememberedSetAllocator), pendingDecrements(&rememberedSetAllocator), referenceCountFreedBytes(0),
+#endif
+		statistics(), unregisteredAllocatedBytes(0)
+	{
+	}
+
+	void Collector::Register(ThreadLocalAllocator* mutator)
+	{
+		gcix_assert(mutator != nullptr);
+
+		gcix_lock(mutexMutators);
+
+#ifdef GCIX_PLATFORM_WINDOWS
+		mutator->threadHandle = (uintptr_t)::OpenThread(THREAD_SUSPEND_RESUME | THREAD_GET_CONTEXT | 
+			THREAD_QUERY_INFORMATION, FALSE, ::GetCurrentThreadId());
+#else
+		mutator->threadHandle = (uintptr_t)pthread_self();
+#endif
+		mutator->state = MutatorState::Running;
+		mutators.Add(mutator);
+	}
+
+	void Collector::Unregister(ThreadLocalAllocator* mutator)
+	{
+		gcix_assert(mutator != nullptr);
+
+		gcix_lock(mutexMutators);
+
+		// A collection is not running while we hold the lock, the state of the thread is Native
+		gcix_assert(mutator->state == MutatorState::Native);
+
+		int32_t index;
+		if (mutators.Find(mutator, index))
+		{
+			mutators.Remove(index);
+		}
+
+		// Bytes allocated by this thread are accounted by the next collection
+		unregisteredAllocatedBytes += mutator->allocatedBytes;
+		mutator->allocatedBytes = 0;
+
+		// Objects logged by this thread must be visited by the next collection
+		void* object;
+		while ((object = mutator->rememberedSet.Pop()) != nullptr)
+		{
+			rememberedSet.Push(object);
+		}
+		while ((object = mutator->satbLog.Pop()) != nullptr)
+		{
+			satbLog.Push(object);
+		}
+#if (GCIX_ENABLE_RC == 1)
+		while ((object = mutator->decrementLog.Pop()) != nullptr)
+		{
+			decrementLog.Push(object);
+		}
+#endif
+
+#ifdef GCIX_PLATFORM_WINDOWS
+		::CloseHandle((HANDLE)mutator->threadHandle);
+#endif
+		mutator->threadHandle = 0;
+	}
+
+	void Collector::Safepoint(ThreadLocalAllocator* mutator)
+	{
+		// Elect the thread performing the collection
+		bool expected = false;
+		if (GlobalAllocator::Instance->CollectRequested() && safepointRequested.compare_exchange_strong(expected, true))
+		{
+			// The collection might have been performed by another thread since we checked it
+			if (GlobalAllocator::Instance->CollectRequested())
+			{
+				mutator->state = MutatorState::Parked;
+				Collect(mutator);
+				mutator->state = MutatorState::Running;
+			}
+			ReleaseSafepoint();
+			return;
+		}
+
+		// Read the epoch before checking the request, so that we cannot miss the end of the safepoint
+		auto epoch = safepointEpoch.load();
+		if (!safepointRequested.load())
+		{
+			return;
+		}
+
+		// Park this thread until the end of the safepoint
+		gcix_trace_scope("Safepoint");
+		mutator->state = MutatorState::Parked;
+		while (true)
+		{
+			while (safepointEpoch.load() == epoch)
+			{
+				resumeEvent.WaitOne();
+			}
+
+			// A collection started by another thread meanwhile may have counted this thread as stopped while it was still 
+			// parked: the thread leaves its park only if no safepoint is requested once it is seen running, otherwise it 
+			// stays parked, with its stack still captured, until the end of that safepoint
+			epoch = safepointEpoch.load();
+			mutator->state = MutatorState::Running;
+			if (!safepointRequested.load())
+			{
+				return;
+			}
+			mutator->state = MutatorState::Parked;
+		}
+	}
+
+	void Collector::EnterNativeCode(ThreadLocalAllocator* mutator)
+	{
+		gcix_assert(mutator->state == MutatorState::Running);
+		mutator->state = MutatorState::Native;
+	}
+
+	void Collector::LeaveNativeCode(ThreadLocalAllocator* mutator)
+	{
+		while (true)
+		{
+			auto expected = MutatorState::Native;
+			if (mutator->state.compare_exchange_strong(expected, MutatorState::Running))
+			{
+				return;
+			}
+
+			// The collector is running, the resume event was reset before blocking this thread
+			gcix_assert(expected == MutatorState::NativeBlocked);
+			gcix_trace_scope("LeaveNativeCode");
+			resumeEvent.WaitOne();
+		}
+	}
+
+	void Collector::ReleaseSafepoint()
+	{
+		safepointRequested = false;
+		safepointEpoch++;
+		resumeEvent.Set();
+	}
+
+	void Collector::Collect(ThreadLocalAllocator* collector)
+	{
+		CollectionTimes times = {};
+		auto start = std::chrono::steady_clock::now();
+		gcix_trace_begin("Collect");
+		gcix_trace_begin("StopMutators");
+
+		resumeEvent.Reset();
+
+		gcix_lock(mutexMutators);
+
+		StopMutators(collector);
+
+		gcix_trace_end("StopMutators");
+		gcix_trace_begin("Clear");
+		auto stopped = std::chrono::steady_clock::now();
+		times.StopMutators = ElapsedNanoseconds(start, stopped);
+
+		// The remark pause of a concurrent collection completes its trace
+		if (Marker::Marking())
+		{
+			Remark(times, stopped);
+			ResumeMutators();
+			gcix_trace_end("Collect");
+			return;
+		}
+
+		// Blocks not yet swept since the previous collection are swept before being marked again, reconciling the bytes
+		// left alive by the previous collection
+		GlobalAllocator::Instance->CompleteSweepParallel();
+
+		// Request a full collection when the objects promoted by sticky collections exceed the live objects left by the 
+		// last full collection
+		if (GlobalAllocator::Instance->CollectionCount() > 0)
+		{
+			auto liveBytes = GlobalAllocator::Instance->LiveBytes();
+			if (!previousCollectionSticky)
+			{
+				liveBytesAfterFullCollection = liveBytes;
+			}
+			auto promotedBytes = liveBytes > liveBytesAfterFullCollection ? liveBytes - liveBytesAfterFullCollection : 0;
+			if (promotedBytes >= liveBytesAfterFullCollection && promotedBytes >= Constants::FullCollectionTriggerLimit)
+			{
+				fullCollectionRequested = true;
+			}
+		}
+
+#if (GCIX_ENABLE_RC == 1)
+		// The references to old objects are only known if they have been counted since the last full collection
+		bool counting = rcEnabled;
+		if (counting && !previousCollectionCounted)
+		{
+			fullCollectionRequested = true;
+		}
+		previousCollectionCounted = counting;
+#else
+		bool counting = false;
+#endif
+
+		// A sticky collection only traces the objects allocated since the previous collection
+		bool sticky = StickyEnabled() && !fullCollectionRequested;
+		if (!sticky)
+		{
+			fullCollectionRequested = false;
+		}
+		previousCollectionSticky = sticky;
+
+		// Objects marked by the previous collection are now seen as not marked, unless this is a sticky collection
+		Marker::Instance->Prepare(sticky);
+
+#if (GCIX_ENABLE_RC == 1)
+		// A full collection counts all the references and the lines again
+		Marker::Instance->CountReferences(counting);
+		if (counting && !sticky)
+		{
+			GlobalAllocator::Instance->ClearLineCounts();
+		}
+#endif
+
+		// Counted objects must stay in place, and their references must be counted while the mutators are stopped
+		bool concurrent = concurrentEnabled && !counting;
+
+		// Old objects are not traced by a sticky collection, so that they cannot be evacuated. Objects are never moved while 
+		// the mutators are running
+		if (!sticky && !concurrent && !counting)
+		{
+			GlobalAllocator::Instance->SelectEvacuationBlocks();
+		}
+
+#if (GCIX_ENABLE_NURSERY == 1)
+		// The objects surviving in the nursery of the mutators are copied out of it, unless the graph is traced while the
+		// mutators are running
+		if (NurseryEnabled() && (sticky || !concurrent))
+		{
+			int32_t nurseryBlockCount = 0;
+			for (int32_t i = 0; i < mutators.Count(); i++)
+			{
+				GlobalAllocator::Instance->SelectNurseryBlocks(mutators[i]->nursery, mutators[i]->nurseryBlockCount);
+				nurseryBlockCount += mutators[i]->nurseryBlockCount;
+			}
+			GlobalAllocator::Instance->ReserveEvacuationBlocks(nurseryBlockCount);
+		}
+#endif
+
+		auto cleared = std::chrono::steady_clock::now();
+		times.Clear = ElapsedNanoseconds(stopped, cleared);
+		gcix_trace_end("Clear");
+		gcix_trace_begin("StackScan");
+
+		// Conservative mark of the stacks of all mutators. Objects referenced by the stacks are pinned, so they must be 
+		// marked before any object is evacuated
+		for (int32_t i = 0; i < mutators.Count(); i++)
+		{
+			ScanStack(mutators[i]->stackFrame);
+		}
+
+		auto stacksScanned = std::chrono::steady_clock::now();
+		times.StackScan = ElapsedNanoseconds(cleared, stacksScanned);
+		gcix_trace_end("StackScan");
+		gcix_trace_begin("Roots");
+
+		// Mark roots, updated if the objects they reference are evacuated
+		GlobalAllocator::Instance->MarkRoots();
+#if (GCIX_ENABLE_RC == 1)
+		if (counting)
+		{
+			auto& gcRoots = GlobalAllocator::Instance->gcRoots;
+			for (int32_t i = 0; i < gcRoots.Count(); i++)
+			{
+				CountRoot(ObjectAddress::FromUserObject(*gcRoots[i]));
+			}
+		}
+#endif
+
+		// Old objects modified since the previous collection. Remembered sets are emptied by full collections as well,
+		// as all the objects surviving a collection are old objects
+		ProcessRememberedSet(rememberedSet, sticky);
+		for (int32_t i = 0; i < mutators.Count(); i++)
+		{
+			ProcessRememberedSet(mutators[i]->rememberedSet, sticky);
+		}
+
+		auto rootsMarked = std::chrono::steady_clock::now();
+		times.Roots = ElapsedNanoseconds(stacksScanned, rootsMarked);
+		gcix_trace_end("Roots");
+
+		// A full collection traces the object graph concurrently with the mutators, until the remark pause
+		if (concurrent && !sticky)
+		{
+			// The blocks used by the mutators may contain objects allocated before the trace, that must be traced. The 
+			// mutators allocate into new blocks, whose objects are all marked by the remark pause
+			for (int32_t i = 0; i < mutators.Count(); i++)
+			{
+				mutators[i]->ResetBlocks();
+			}
+			GlobalAllocator::Instance->BeginConcurrentTrace();
+			Marker::Instance->StartConcurrentTrace();
+
+			UpdateStatistics(times, PauseKind::InitialMark, sticky);
+			concurrentMarkStart = std::chrono::steady_clock::now();
+
+			ResumeMutators();
+			gcix_trace_end("Collect");
+			return;
+		}
+
+		gcix_trace_begin("Mark");
+
+		// Trace all objects reachable from roots and the stacks
+		Marker::Instance->Trace();
+
+		auto traced = std::chrono::steady_clock::now();
+		times.Mark = ElapsedNanoseconds(rootsMarked, traced);
+		gcix_trace_end("Mark");
+		gcix_trace_begin("Sweep");
+
+#if (GCIX_ENABLE_RC == 1)
+		// Objects left unreferenced are reclaimed with their lines before the blocks are recycled
+		ProcessDecrements(counting && sticky);
+#endif
+
+		GlobalAllocator::Instance->Recycle(sticky);
+
+		// Blocks used by mutators have been recycled
+		for (int32_t i = 0; i < mutators.Count(); i++)
+		{
+			mutators[i]->ResetBlocks();
+		}
+
+		times.Sweep = ElapsedNanoseconds(traced, std::chrono::steady_clock::now());
+		gcix_trace_end("Sweep");
+
+		UpdateStatistics(times, PauseKind::Collection, sticky);
+
+		ResumeMutators();
+		gcix_trace_end("Collect");
+	}
+
+	void Collector::Remark(CollectionTimes& times, std::chrono::steady_clock::time_point stopped)
+	{
+		times.ConcurrentMark = ElapsedNanoseconds(concurrentMarkStart, stopped);
+		gcix_trace_begin("Roots");
+
+		// The remark is requested by the end of the concurrent trace. The stacks and the roots have been marked by the 
+		// initial pause, and any reference loaded by the mutators since then was reachable from them or from a new object
+		Marker::Instance->CompleteConcurrentTrace();
+
+		// Objects reachable when the trace started that the mutators have unlinked in the meantime
+		ProcessSatbLog(satbLog);
+		for (int32_t i = 0; i < mutators.Count(); i++)
+		{
+			ProcessSatbLog(mutators[i]->satbLog);
+		}
+
+		auto rootsMarked = std::chrono::steady_clock::now();
+		times.Roots = ElapsedNanoseconds(stopped, rootsMarked);
+		gcix_trace_end("Roots");
+		gcix_trace_begin("Mark");
+
+		Marker::Instance->Trace();
+
+		// Objects allocated during the trace are live
+		GlobalAllocator::Instance->MarkAllocatedObjects();
+
+		auto traced = std::chrono::steady_clock::now();
+		times.Mark = ElapsedNanoseconds(rootsMarked, traced);
+		gcix_trace_end("Mark");
+		gcix_trace_begin("Sweep");
+
+		GlobalAllocator::Instance->Recycle(false);
+
+		for (int32_t i = 0; i < mutators.Count(); i++)
+		{
+			mutators[i]->ResetBlocks();
+		}
+
+		times.Sweep = ElapsedNanoseconds(traced, std::chrono::steady_clock::now());
+		gcix_trace_end("Sweep");
+
+		UpdateStatistics(times, PauseKind::Remark, false);
+	}
+
+	void Collector::UpdateWriteBarrierState()
+	{
+		auto& state = CurrentWriteBarrierState;
+		state.HeaderSize = ObjectConstants::HeaderTotalSizeInBytes;
+		state.TypeMask = 0;
+		state.TypeValue = 1;
+
+		if (Marker::Marking())
+		{
+			// All the stores log the references they overwrite
+			state.LogMask = 0;
+			state.LogValue = 0;
+		}
+		else if (StickyEnabled())
+		{
+			// Same check as ObjectAddress::RequiresStickyLog
+			state.LogMask = ObjectFlags::MarkStateMask | ObjectFlags::StickyLog;
+			state.LogValue = ObjectAddress::MarkState;
+#if (GCIX_ENABLE_CARD_TABLE == 1)
+			// Every store into a large object dirties its cards. The mask also matches inner objects, as ObjectType::Inner
+			// contains the bit of ObjectType::Large
+			state.TypeMask = (uint32_t)ObjectType::Large;
+			state.TypeValue = (uint32_t)ObjectType::Large;
+#elif (GCIX_ENABLE_INNER_OBJECT == 1)
+			state.TypeMask = ObjectFlags::ObjectTypeMask;
+			state.TypeValue = (uint32_t)ObjectType::Inner;
+#endif
+		}
+		else
+		{
+			state.LogMask = 0;
+			state.LogValue = 1;
+		}
+	}
+
+	void Collector::UpdateStatistics(const CollectionTimes& times, PauseKind kind, bool sticky)
+	{
+		// Mutators are stopped, their allocation counters can be read and reset
+		uint64_t allocatedBytes = unregisteredAllocatedBytes;
+		unregisteredAllocatedBytes = 0;
+		for (int32_t i = 0; i < mutators.Count(); i++)
+		{
+			allocatedBytes += mutators[i]->allocatedBytes;
+			mutators[i]->allocatedBytes = 0;
+		}
+
+		auto pauseTime = times.StopMutators + times.Clear + times.StackScan + times.Roots + times.Mark + times.Sweep;
+		auto pauseMicroseconds = pauseTime / 1000;
+
+		gcix_lock(mutexStatistics);
+
+		// The initial pause of a concurrent collection is accounted as a pause, the collection is completed by the remark
+		if (kind != PauseKind::InitialMark)
+		{
+			statistics.CollectionCount++;
+		}
+		if (sticky)
+		{
+			statistics.StickyCollectionCount++;
+		}
+		if (kind == PauseKind::Remark)
+		{
+			statistics.ConcurrentCollectionCount++;
+			statistics.ConcurrentMarkTime += times.ConcurrentMark;
+		}
+		statistics.StopMutatorsTime += times.StopMutators;
+		statistics.ClearTime += times.Clear;
+		statistics.StackScanTime += times.StackScan;
+		statistics.RootsTime += times.Roots;
+		statistics.MarkTime += times.Mark;
+		statistics.SweepTime += times.Sweep;
+		statistics.TotalPauseTime += pauseTime;
+		statistics.MaxPauseTime = std::max(statistics.MaxPauseTime, pauseTime);
+		statistics.BytesAllocated += allocatedBytes;
+#if (GCIX_ENABLE_RC == 1)
+		statistics.ReferenceCountFreedBytes += referenceCountFreedBytes;
+		referenceCountFreedBytes = 0;
+#endif
+		statistics.PauseHistogram[Histogram::GetBucketIndex(
+			pauseMicroseconds > 0xFFFFFFFF ? 0xFFFFFFFF : (uint32_t)pauseMicroseconds)]++;
+	}
+
+	void Collector::GetStatistics(Statistics& statistics)
+	{
+		{
+			gcix_lock(mutexStatistics);
+			statistics = this->statistics;
+		}
+
+		GlobalAllocator::Instance->GetStatistics(statistics);
+
+		// Objects not marked are freed, up to the line granularity of the marked bytes
+		statistics.BytesFreed = statistics.BytesAllocated > statistics.BytesMarked ? 
+			statistics.BytesAllocated - statistics.BytesMarked : 0;
+	}
+
+	void Collector::StopMutators(ThreadLocalAllocator* collector)
+	{
+		auto start = std::chrono::steady_clock::now();
+		while (true)
+		{
+			auto suspend = std::chrono::steady_clock::now() - start >= std::chrono::milliseconds(GCIX_SUSPEND_TIMEOUT_MS);
+			bool stopped = true;
+			for (int32_t i = 0; i < mutators.Count(); i++)
+			{
+				auto mutator = mutators[i];
+				if (mutator == collector)
+				{
+					continue;
+				}
+
+				auto expected = MutatorState::Native;
+				if (mutator->state.compare_exchange_strong(expected, MutatorState::NativeBlocked))
+				{
+					continue;
+				}
+
+				if (expected == MutatorState::Running)
+				{
+					stopped = false;
+					if (suspend)
+					{
+						Suspend(mutator);
+					}
+				}
+			}
+
+			if (stopped)
+			{
+				break;
+			}
+
+			// Let mutators reach a safepoint, or handle the suspend request
+			if (suspend)
+			{
+				Thread::Sleep(1);
+			}
+			else
+			{
+				Thread::YieldExecution();
+			}
+		}
+	}
+
+	void Collector::ResumeMutators()
+	{
+		// The mutators check the write barrier state without synchronization
+		UpdateWriteBarrierState();
+
+		for (int32_t i = 0; i < mutators.Count(); i++)
+		{
+			auto mutator = mutators[i];
+			if (mutator->state == MutatorState::NativeBlocked)
+			{
+				mutator->state = MutatorState::Native;
+			}
+			else if (mutator->state == MutatorState::Suspended)
+			{
+				Resume(mutator);
+			}
+		}
+	}
+
+#ifdef GCIX_PLATFORM_WINDOWS
+	void Collector::Suspend(ThreadLocalAllocator* mutator)
+	{
+		auto threadHandle = (HANDLE)mutator->threadHandle;
+		if (::SuspendThread(threadHandle) == (DWORD)-1)
+		{
+			return;
+		}
+
+		// GetThreadContext waits for the thread to be effectively suspended
+		CONTEXT context;
+		context.ContextFlags = CONTEXT_INTEGER | CONTEXT_CONTROL;
+		if (!::GetThreadContext(threadHandle, &context) || mutator->inRuntime || *mutator->inWriteBarrier || 
+			mutator->state != MutatorState::Running)
+		{
+			::ResumeThread(threadHandle);
+			return;
+		}
+
+		// Save the registers that can hold references along the stack
+		auto registers = mutator->stackFrame.GetRegisters();
+#ifdef _M_X64
+		static_assert(StackFrame::RegisterCount >= 16, "jmp_buf is too small to store the registers");
+		void* values[] = { (void*)context.Rax, (void*)context.Rbx, (void*)context.Rcx, (void*)context.Rdx, 
+			(void*)context.Rsi, (void*)context.Rdi, (void*)context.Rbp, (void*)context.R8, (void*)context.R9, 
+			(void*)context.R10, (void*)context.R11, (void*)context.R12, (void*)context.R13, (void*)context.R14, 
+			(void*)context.R15 };
+		mutator->stackFrame.SetTopOfStack((void*)context.Rsp);
+#else
+		static_assert(StackFrame::RegisterCount >= 7, "jmp_buf is too small to store the registers");
+		void* values[] = { (void*)context.Eax, (void*)context.Ebx, (void*)context.Ecx, (void*)context.Edx, 
+			(void*)context.Esi, (void*)context.Edi, (void*)context.Ebp };
+		mutator->stackFrame.SetTopOfStack((void*)context.Esp);
+#endif
+		for (size_t i = 0; i < sizeof(values) / sizeof(void*); i++)
+		{
+			registers[i] = values[i];
+		}
+
+		mutator->state = MutatorState::Suspended;
+	}
+
+	void Collector::Resume(ThreadLocalAllocator* mutator)
+	{
+		mutator->state = MutatorState::Running;
+		::ResumeThread((HANDLE)mutator->threadHandle);
+	}
+#else
+	void Collector::Suspend(ThreadLocalAllocator* mutator)
+	{
+		// The thread is suspended by its signal handler, and will be seen as stopped when its state is Suspended
+		pthread_kill((pthread_t)mutator->threadHandle, GCIX_SUSPEND_SIGNAL);
+	}
+
+	void Collector::Resume(ThreadLocalAllocator* mutator)
+	{
+		// Exits the wait loop of the signal handler
+		mutator->state = MutatorState::Running;
+	}
+#endif
+
+	void Collector::ScanStack(StackFrame& stackFrame)
+	{
+		auto registers = stackFrame.GetRegisters();
+		ScanRange(registers, registers + StackFrame::RegisterCount);
+		ScanRange(stackFrame.GetToOfStack(), stackFrame.GetBottomOfStack());
+	}
+
+	void Collector::ScanRange(void* start, void* end)
+	{
+		auto globalAllocator = GlobalAllocator::Instance;
+
+		// Pointers are checked on every 4 bytes, as they might not be aligned on the stack
+		auto endPointer = (uint32_t*)((intptr_t)end - sizeof(void*));
+		for (auto pointer = (uint32_t*)start; pointer <= endPointer; pointer++)
+		{
+			auto object = globalAllocator->FindObjectConservative(*(void**)pointer);
+			if (object != nullptr)
+			{
+				Marker::Mark(object);
+#if (GCIX_ENABLE_RC == 1)
+				if (rcEnabled)
+				{
+					CountRoot(object);
+				}
+#endif
+			}
+		}
+	}
+
+	void Collector::ProcessSatbLog(DefaultSequentialStoreBufferHandle& satbLog)
+	{
+		void* pointer;
+		while ((pointer = satbLog.Pop()) != nullptr)
+		{
+			Marker::Mark((ObjectAddress*)pointer);
+		}
+	}
+
+	void Collector::ProcessRememberedSet(DefaultSequentialStoreBufferHandle& rememberedSet, bool sticky)
+	{
+		void* pointer;
+		while ((pointer = rememberedSet.Pop()) != nullptr)
+		{
+			auto object = (ObjectAddress*)pointer;
+			object->ClearStickyLog();
+
+#if (GCIX_ENABLE_CARD_TABLE == 1)
+			// Only the references stored into the dirty cards of an old large object are visited. When counting references, 
+			// all of them have been logged to be decremented and must be counted again
+			if (object->IsLargeObject())
+			{
+				if (sticky && RcEnabled())
+				{
+					Marker::Rescan(object);
+				}
+				else if (sticky)
+				{
+					Marker::RescanCards((LargeObjectAddress*)object);
+				}
+				((LargeObjectAddress*)object)->CleanCards();
+				continue;
+			}
+#endif
+
+			// The object is old, its references to objects allocated since the previous collection must be visited
+			if (sticky)
+			{
+				Marker::Rescan(object);
+			}
+		}
+	}
+
+#if (GCIX_ENABLE_RC == 1)
+	void Collector::CountRoot(ObjectAddress* object)
+	{
+		if (object == nullptr)
+		{
+			return;
+		}
+		Marker::CountReference(object->ToUserObject());
+		rootLog.Push(object);
+	}
+
+	void Collector::ProcessDecrements(bool sticky)
+	{
+		gcix_trace_scope("ProcessDecrements");
+
+		// The references counted by the previous collection from the roots and the stacks are released
+		DecrementReferences(previousRootLog, sticky);
+		DecrementReferences(decrementLog, sticky);
+		for (int32_t i = 0; i < mutators.Count(); i++)
+		{
+			DecrementReferences(mutators[i]->decrementLog, sticky);
+		}
+
+		void* pointer;
+		while ((pointer = rootLog.Pop()) != nullptr)
+		{
+			previousRootLog.Push(pointer);
+		}
+	}
+
+	void Collector::DecrementReferences(DefaultSequentialStoreBufferHandle& log, bool decrement)
+	{
+		void* pointer;
+		while ((pointer = log.Pop()) != nullptr)
+		{
+			if (!decrement)
+			{
+				continue;
+			}
+
+			// The references of the objects reclaimed are decremented iteratively
+			pendingDecrements.Push(pointer);
+			void* pending;
+			while ((pending = pendingDecrements.Pop()) != nullptr)
+			{
+				auto object = (ObjectAddress*)pending;
+#if (GCIX_ENABLE_INNER_OBJECT == 1)
+				if (object->IsInnerObject())
+				{
+					object = ((InnerObjectAddress*)object)->Parent();
+				}
+#endif
+				// Objects allocated since the previous collection are not counted, and large objects are only reclaimed by
+				// full collections
+				if (!object->IsStandardObject() || !object->IsMarked() || !object->DecrementReferenceCount())
+				{
+					continue;
+				}
+
+				// The object is unreachable: the lines it leaves empty are reclaimed, and it cannot be found anymore by 
+				// conservative lookups
+				auto standardObject = (StandardObjectAddress*)object;
+				auto blockData = BlockData::FromObject(standardObject);
+				blockData->DecrementLineCounts(standardObject);
+				blockData->ClearObjectStart((uint32_t)((intptr_t)object - (intptr_t)blockData));
+				referenceCountFreedBytes += standardObject->Size();
+				object->UnMark();
+
+				VisitorContext context;
+				context.Visitor = PushDecrement;
+				object->VisitReferences(&context);
+			}
+		}
+	}
+
+	void gcix_fastcall Collector::PushDecrement(void** reference, VisitorContext*)
+	{
+		if (*reference != nullptr)
+		{
+			Instance->pendingDecrements.Push(ObjectAddress::FromUserObject(*reference));
+		}
+	}
+#endif
+
+	std::atomic<bool> Collector::safepointRequested(false);
+
+	bool Collector::stickyEnabled = GCIX_ENABLE_STICKY == 1;
+
+	bool Collector::concurrentEnabled = GCIX_ENABLE_CONCURRENT_MARK == 1;
+
+	bool Collector::rcEnabled = GCIX_ENABLE_RC == 1;
+
+#if (GCIX_ENABLE_NURSERY == 1)
+	bool Collector::nurseryEnabled = true;
+#endif
+
+	WriteBarrierState CurrentWriteBarrierState;
+
+	gcix_public_thread_local bool InWriteBarrier;
+
+	Collector* Collector::Instance;
+}
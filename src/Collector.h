@@ -0,0 +1,337 @@
+﻿#pragma once
+// Copyright (c) 2014, Alexandre Mutel
+// All rights reserved.
+// 
+// Redistribution and use in source and binary forms, with or without modification, are permitted provided that the following 
+// conditions are met:
+// 
+// 1. Redistributions of source code must retain the above copyright notice, this list of conditions and the following 
+//    disclaimer.
+// 
+// 2. Redistributions in binary form must reproduce the above copyright notice, this list of conditions and the following 
+//    disclaimer in the documentation and/or other materials provided with the distribution.
+// 
+// THIS SOFTWARE IS PROVIDED BY THE COPYRIGHT HOLDERS AND CONTRIBUTORS "AS IS" AND ANY EXPRESS OR IMPLIED WARRANTIES, 
+// INCLUDING, BUT NOT LIMITED TO, THE IMPLIED WARRANTIES OF MERCHANTABILITY AND FITNESS FOR A PARTICULAR PURPOSE ARE 
+// DISCLAIMED. IN NO EVENT SHALL THE COPYRIGHT HOLDER OR CONTRIBUTORS BE LIABLE FOR ANY DIRECT, INDIRECT, INCIDENTAL, SPECIAL, 
+// EXEMPLARY, OR CONSEQUENTIAL DAMAGES (INCLUDING, BUT NOT LIMITED TO, PROCUREMENT OF SUBSTITUTE GOODS OR SERVICES; LOSS OF 
+// USE, DATA, OR PROFITS; OR BUSINESS INTERRUPTION) HOWEVER CAUSED AND ON ANY THEORY OF LIABILITY, WHETHER IN CONTRACT, STRICT 
+// LIABILITY, OR TORT (INCLUDING NEGLIGENCE OR OTHERWISE) ARISING IN ANY WAY OUT OF THE USE OF THIS SOFTWARE, EVEN IF ADVISED 
+// OF THE POSSIBILITY OF SUCH DAMAGE.
+
+
+#include "gcix.h"
+#include "Common.h"
+#include "MutatorState.h"
+#include "StackFrame.h"
+#include "Collections/List.h"
+#include "Collections/SequentialStoreBuffer.h"
+#include "Threading/Mutex.h"
+#include "Threading/ManualResetEvent.h"
+
+#include <atomic>
+#include <chrono>
+
+namespace gcix
+{
+	class ThreadLocalAllocator;
+	struct ObjectAddress;
+	struct VisitorContext;
+
+	/**
+	Performs collections while all the mutator threads are stopped (stop-the-world).
+	Mutator threads are registered by @see gcix::InitializeMutatorThread and are stopped cooperatively: the allocation 
+	slow path and @see gcix::Safepoint poll a global flag and park the thread until the end of the collection. Threads 
+	running native code (@see gcix::EnterNativeCode) are not stopped but cannot leave native code during a collection. 
+	Threads that don't reach a safepoint after GCIX_SUSPEND_TIMEOUT_MS are suspended asynchronously (with a signal on 
+	POSIX platforms, SuspendThread on Windows), unless they are running gcix code.
+	The stacks of all the mutator threads are then scanned conservatively.
+	When sticky collections are enabled (GCIX_ENABLE_STICKY), objects that survived a collection are old objects, and a 
+	sticky collection only traces from the roots, the stacks and the remembered sets of old objects logged by the write 
+	barrier, leaving the marks of old objects intact. A full collection is performed when the objects promoted since the 
+	last full collection exceed the live objects left by it.
+	When concurrent marking is enabled (GCIX_ENABLE_CONCURRENT_MARK), a full collection is split in two pauses: the 
+	initial pause scans the stacks and the roots and starts a concurrent trace (@see Marker::StartConcurrentTrace), and 
+	the remark pause, requested at the end of the trace, marks the references logged by the write barrier and the objects 
+	allocated in the meantime before recycling the blocks. Sticky collections are always performed in a single pause.
+	When reference counting is enabled (GCIX_ENABLE_RC), collections are sticky collections that also count the 
+	references to old objects: the references visited by the trace and the objects referenced by the roots and the stacks
+	(until the next collection) are incremented, and the references overwritten in old objects, logged by the write
+	barrier, are decremented once the trace is completed. Objects whose count drops to zero are reclaimed with the lines 
+	they leave empty, and full collections are only needed to collect cycles and objects with saturated counts.
+	*/
+	class Collector
+	{
+	public:
+		/**
+		Initialize the @see Collector::Instance variable.
+		*/
+		static void Initialize();
+
+		/**
+		Indicates whether a collection is waiting for mutator threads to reach a safepoint.
+		*/
+		static inline bool SafepointRequested()
+		{
+			return safepointRequested.load(std::memory_order_relaxed);
+		}
+
+		/**
+		Indicates whether sticky collections are enabled, in which case the write barrier must log old objects.
+		*/
+		static inline bool StickyEnabled()
+		{
+#if (GCIX_ENABLE_RC == 1)
+			return stickyEnabled || rcEnabled;
+#else
+			return stickyEnabled;
+#endif
+		}
+
+		/**
+		Indicates whether the references to old objects are counted, in which case the write barrier must log the 
+		references overwritten in old objects.
+		*/
+		static inline bool RcEnabled()
+		{
+#if (GCIX_ENABLE_RC == 1)
+			return rcEnabled;
+#else
+			return false;
+#endif
+		}
+
+		/**
+		Indicates whether the mutators allocate into their nursery, whose surviving objects are copied by the next 
+		collection.
+		*/
+		static inline bool NurseryEnabled()
+		{
+#if (GCIX_ENABLE_NURSERY == 1)
+			return nurseryEnabled && !RcEnabled();
+#else
+			return false;
+#endif
+		}
+
+		/**
+		Registers the calling mutator thread. Waits for the end of the current collection if any.
+		*/
+		void Register(ThreadLocalAllocator* mutator);
+
+		/**
+		Unregisters the calling mutator thread. The thread must be running native code.
+		*/
+		void Unregister(ThreadLocalAllocator* mutator);
+
+		/**
+		Called by a mutator thread at a safepoint, after its stack has been captured. Performs the collection if one was 
+		requested by the @see GlobalAllocator and no other thread is collecting, otherwise parks the thread until the end 
+		of the current collection if any.
+		*/
+		void Safepoint(ThreadLocalAllocator* mutator);
+
+		/**
+		Called by a mutator thread entering native code, after its stack has been captured.
+		*/
+		void EnterNativeCode(ThreadLocalAllocator* mutator);
+
+		/**
+		Called by a mutator thread leaving native code. Waits for the end of the current collection if any.
+		*/
+		void LeaveNativeCode(ThreadLocalAllocator* mutator);
+
+		/**
+		Gets the statistics of the collections. Can be called from any thread.
+		@param statistics The statistics to fill
+		*/
+		void GetStatistics(Statistics& statistics);
+
+		static Collector* Instance;
+	private:
+		gcix_overrides_new_delete();
+
+		Collector();
+
+		static const int MutatorCount = 64;
+
+		/* Stops all mutators and performs a collection. Called by the mutator elected to collect */
+		void Collect(ThreadLocalAllocator* collector);
+
+		/* Waits until all the mutators other than the collector are stopped */
+		void StopMutators(ThreadLocalAllocator* collector);
+
+		/* Restarts all the mutators stopped by @see StopMutators */
+		void ResumeMutators();
+
+		/* Ends a safepoint, releasing all parked mutators */
+		void ReleaseSafepoint();
+
+		/* Tries to suspend asynchronously a running mutator */
+		void Suspend(ThreadLocalAllocator* mutator);
+
+		/* Resumes a mutator suspended asynchronously */
+		void Resume(ThreadLocalAllocator* mutator);
+
+#ifndef GCIX_PLATFORM_WINDOWS
+		/* Handler of GCIX_SUSPEND_SIGNAL */
+		static void SuspendHandler(int signal);
+#endif
+
+		/* Marks all the objects referenced by the registers and the stack of a stopped mutator */
+		void ScanStack(StackFrame& stackFrame);
+
+		/* Marks all the objects referenced conservatively by the specified memory range */
+		void ScanRange(void* start, void* end);
+
+		/* Empties a remembered set, clearing the log bit of objects and pushing them to the mark stack if sticky */
+		void ProcessRememberedSet(DefaultSequentialStoreBufferHandle& rememberedSet, bool sticky);
+
+		/* Empties the log of the references overwritten during a concurrent trace, marking their objects */
+		void ProcessSatbLog(DefaultSequentialStoreBufferHandle& satbLog);
+
+#if (GCIX_ENABLE_RC == 1)
+		/* Counts a reference from the roots or the stacks to a marked object, decremented by the next collection */
+		void CountRoot(ObjectAddress* object);
+
+		/* 
+		Decrements the references logged since the previous collection and reclaims the objects left unreferenced, after
+		a sticky trace. The logs are discarded after a full trace, that counted all the references again.
+		*/
+		void ProcessDecrements(bool sticky);
+
+		/* Empties a log of references to decrement, decrementing them if requested */
+		void DecrementReferences(DefaultSequentialStoreBufferHandle& log, bool decrement);
+
+		/* Visitor of the references of a reclaimed object, pushing them to @see pendingDecrements */
+		static void gcix_fastcall PushDecrement(void** reference, VisitorContext* context);
+#endif
+
+		/* Durations of the phases of a collection pause, in nanoseconds */
+		struct CollectionTimes
+		{
+			uint64_t StopMutators;
+			uint64_t Clear;
+			uint64_t StackScan;
+			uint64_t Roots;
+			uint64_t Mark;
+			uint64_t Sweep;
+
+			/* Time elapsed between the initial and the remark pauses of a concurrent collection */
+			uint64_t ConcurrentMark;
+		};
+
+		/* 
+		Updates @see CurrentWriteBarrierState from the mark state, the sticky collections and the concurrent trace. Must 
+		be called while the mutators are stopped.
+		*/
+		static void UpdateWriteBarrierState();
+
+		/* Kind of a collection pause */
+		enum class PauseKind
+		{
+			/* A collection performed while the mutators are stopped */
+			Collection,
+
+			/* The initial pause of a concurrent collection, starting the concurrent trace */
+			InitialMark,
+
+			/* The remark pause of a concurrent collection, completing it */
+			Remark,
+		};
+
+		/* Accumulates the durations of a pause and the bytes allocated by the mutators into the statistics */
+		void UpdateStatistics(const CollectionTimes& times, PauseKind kind, bool sticky);
+
+		/* Completes a concurrent collection while the mutators are stopped, called by @see Collect */
+		void Remark(CollectionTimes& times, std::chrono::steady_clock::time_point stopped);
+
+		/* Set while a collection is waiting for mutators to reach a safepoint */
+		static std::atomic<bool> safepointRequested;
+
+		/* Incremented at the end of each safepoint, used by parked mutators to detect that they can resume */
+		std::atomic<uint32_t> safepointEpoch;
+
+		/* Event signaled at the end of a safepoint */
+		ManualResetEvent resumeEvent;
+
+		Mutex mutexMutators;
+		List<ThreadLocalAllocator*> mutators;
+
+		/* True if collections can be sticky collections */
+		static bool stickyEnabled;
+
+		/* True if full collections trace the object graph concurrently with the mutators */
+		static bool concurrentEnabled;
+
+		/* True if collections count the references to old objects, ignored unless GCIX_ENABLE_RC is enabled */
+		static bool rcEnabled;
+
+#if (GCIX_ENABLE_NURSERY == 1)
+		/* True if the mutators allocate into their nursery */
+		static bool nurseryEnabled;
+#endif
+
+		/* End of the initial pause of the current concurrent collection */
+		std::chrono::steady_clock::time_point concurrentMarkStart;
+
+		/* True if the next collection must be a full collection */
+		bool fullCollectionRequested;
+
+		/* True if the previous collection was a sticky collection, its live bytes are known at the next collection */
+		bool previousCollectionSticky;
+
+		/* Bytes used by live objects after the last full collection */
+		size_t liveBytesAfterFullCollection;
+
+		/* Allocator of the buffers of remembered sets and of the logs of concurrent traces */
+		DefaultSequentialStoreBufferAllocator rememberedSetAllocator;
+
+		/* Objects logged by mutators unregistered since the last collection */
+		DefaultSequentialStoreBufferHandle rememberedSet;
+
+		/* References logged by mutators unregistered during the current concurrent trace */
+		DefaultSequentialStoreBufferHandle satbLog;
+
+#if (GCIX_ENABLE_RC == 1)
+		/* True if the previous collection counted the references, otherwise the next one must count all of them */
+		bool previousCollectionCounted;
+
+		/* References overwritten in old objects by mutators unregistered since the last collection */
+		DefaultSequentialStoreBufferHandle decrementLog;
+
+		/* Objects referenced by the roots and the stacks, counted by the current collection */
+		DefaultSequentialStoreBufferHandle rootLog;
+
+		/* Objects referenced by the roots and the stacks, counted by the previous collection */
+		DefaultSequentialStoreBufferHandle previousRootLog;
+
+		/* References of the objects reclaimed, not yet decremented */
+		DefaultSequentialStoreBufferHandle pendingDecrements;
+
+		/* Bytes of the objects reclaimed by reference counting since the last collection */
+		uint64_t referenceCountFreedBytes;
+#endif
+
+		/* Statistics updated at the end of each collection, block and large objects counts are filled on demand */
+		Mutex mutexStatistics;
+		Statistics statistics;
+
+		/* Bytes allocated by the mutators unregistered since the last collection */
+		uint64_t unregisteredAllocatedBytes;
+
+		friend class ThreadLocalAllocator;
+
+		// -----------------------------------------------------------
+		// Unit tets
+		// -----------------------------------------------------------
+		FRIEND_TEST(CollectorTest, StickyCollections);
+		FRIEND_TEST(CollectorTest, WriteReference);
+		FRIEND_TEST(CollectorTest, CardTable);
+		FRIEND_TEST(CollectorTest, ConcurrentMark);
+		FRIEND_TEST(CollectorTest, Evacuation);
+		FRIEND_TEST(CollectorTest, ReferenceCounting);
+		FRIEND_TEST(CollectorTest, Nursery);
+		FRIEND_TEST(CollectorTest, LargeObjects);
+	};
+}
@@ -19,6 +19,7 @@
 // LIABILITY, OR TORT (INCLUDING NEGLIGENCE OR OTHERWISE) ARISING IN ANY WAY OUT OF THE USE OF THIS SOFTWARE, EVEN IF ADVISED 
 // OF THE POSSIBILITY OF SUCH DAMAGE.
 
+#include <stddef.h>
 #include <stdint.h>
 
 #include "gtest/gtest_prod.h"
@@ -27,10 +28,23 @@
 #define GCIX_PLATFORM_WINDOWS 1
 #endif
 
-// TODO Make it compiler dependent
+#if defined(_MSC_VER)
 #define gcix_thread_local  __declspec(thread)
 #define gcix_noinline __declspec(noinline)
 #define gcix_fastcall __fastcall
+// No attribute aligns a function: the visitor functions must not be reached through the thunks of incremental linking
+#define gcix_visitor
+#else
+#define gcix_thread_local thread_local
+#define gcix_noinline __attribute__((noinline))
+// The visitors use the default calling convention, there is no register calling convention on x64 targets
+#define gcix_fastcall
+/** 
+Aligns a visitor function of a class descriptor on 2 bytes, as an odd visitor is an inline visitor (see 
+ObjectAddress::VisitReferences). Functions may be placed at odd addresses otherwise, in debug builds especially.
+*/
+#define gcix_visitor __attribute__((aligned(2)))
+#endif
 
 #ifndef GCIX_ENABLE_INNER_OBJECT
 /** Allows inner object. Default is true. */
@@ -47,6 +61,128 @@
 #define GCIX_OBJECT_HEADER_ADDITIONAL_OFFSET (0)
 #endif
 
+#ifndef GCIX_ENABLE_SIMD
+/** Allows SSE2/AVX2 kernels (when supported by the target) instead of scalar loops. Default is true. */
+#define GCIX_ENABLE_SIMD 1
+#endif
+
+#if (GCIX_ENABLE_SIMD == 1)
+#if defined(__AVX2__)
+#define GCIX_SIMD_AVX2 1
+#endif
+#if defined(__SSE2__) || defined(_M_X64) || (defined(_M_IX86_FP) && _M_IX86_FP >= 2)
+#define GCIX_SIMD_SSE2 1
+#endif
+#endif
+
+#ifndef GCIX_CHUNK_RESERVATION_SIZE
+/** Size in bytes of the ranges of virtual memory reserved at once to allocate chunks. Default is 64 MB */
+#define GCIX_CHUNK_RESERVATION_SIZE (64 << 20)
+#endif
+
+#ifndef GCIX_HEAP_RESERVATION_SIZE
+/** 
+Size in bytes of a single range of virtual memory reserved at initialization for all the chunks. Finding the chunk of an 
+address is then a subtract and a shift, but the heap cannot grow beyond this size. Default is 0 (disabled, ranges of 
+GCIX_CHUNK_RESERVATION_SIZE are reserved on demand)
+*/
+#define GCIX_HEAP_RESERVATION_SIZE 0
+#endif
+
+#ifndef GCIX_FREE_CHUNK_POOL_COUNT
+/** Number of free chunks kept committed after a collection, to absorb the next allocations. Default is 1 */
+#define GCIX_FREE_CHUNK_POOL_COUNT 1
+#endif
+
+#ifndef GCIX_FREE_CHUNK_RELEASE_DELAY
+/** Number of consecutive collections a chunk must be found free before being returned to the OS. Default is 3 */
+#define GCIX_FREE_CHUNK_RELEASE_DELAY 3
+#endif
+
+#ifndef GCIX_ENABLE_HUGE_PAGES
+/** Advises the OS to back the chunks with huge pages (transparent huge pages on Linux). Default is false. */
+#define GCIX_ENABLE_HUGE_PAGES 0
+#endif
+
+#ifndef GCIX_MARKER_THREAD_COUNT
+/** Number of threads used to trace the object graph, including the collecting thread. 0 to use the number of processors */
+#define GCIX_MARKER_THREAD_COUNT 0
+#endif
+
+#ifndef GCIX_SUSPEND_TIMEOUT_MS
+/** Time in milliseconds to wait for mutator threads to reach a safepoint before suspending them asynchronously */
+#define GCIX_SUSPEND_TIMEOUT_MS 10
+#endif
+
+#ifndef GCIX_SUSPEND_SIGNAL
+/** Signal used to suspend mutator threads asynchronously on POSIX platforms */
+#if defined(__linux__)
+#define GCIX_SUSPEND_SIGNAL SIGPWR
+#else
+#define GCIX_SUSPEND_SIGNAL SIGXCPU
+#endif
+#endif
+
+#ifndef GCIX_ENABLE_STICKY
+/** 
+Enables sticky collections (Sticky Immix): most collections only trace the objects allocated since the previous 
+collection, and mutators must call the write barrier before storing a reference into a managed object. Default is false.
+*/
+#define GCIX_ENABLE_STICKY 0
+#endif
+
+#ifndef GCIX_ENABLE_CONCURRENT_MARK
+/** 
+Enables concurrent marking: full collections only stop the mutators to scan their stacks and the roots, the object graph
+is then traced by the marker threads while the mutators run, and a short remark pause completes the trace. Mutators must
+call the write barrier before storing a reference into a managed object. Default is false.
+*/
+#define GCIX_ENABLE_CONCURRENT_MARK 0
+#endif
+
+#ifndef GCIX_ENABLE_CARD_TABLE
+/** 
+Enables the card table of large objects: the write barrier dirties a byte per card of 512 bytes of an old large object,
+and sticky collections only visit the references stored in its dirty cards instead of all its references (e.g large 
+arrays of references). Default is false.
+*/
+#define GCIX_ENABLE_CARD_TABLE 0
+#endif
+
+#ifndef GCIX_ENABLE_RC
+/** 
+Enables reference counting (RC Immix): sticky collections count the references to old objects and the lines they use, 
+so that old objects and lines are reclaimed as soon as they are unreferenced instead of waiting for a full collection,
+that only remains to collect cycles. Implies sticky collections, disables evacuation and concurrent marking. Default is
+false, collections then never count references.
+*/
+#define GCIX_ENABLE_RC 0
+#endif
+
+#ifndef GCIX_ENABLE_NURSERY
+/** 
+Enables the nursery: each mutator thread bump allocates into a fixed number of free blocks (see 
+GCIX_NURSERY_BLOCK_COUNT) and requests a collection once they are full. The collection copies the objects surviving in 
+them into the holes of the other blocks, so that the objects dying young are neither line marked nor swept. Objects 
+referenced from the stacks are kept in place, and collections tracing concurrently with the mutators don't copy any 
+object. Ignored when reference counting is enabled. Default is false.
+*/
+#define GCIX_ENABLE_NURSERY 0
+#endif
+
+#ifndef GCIX_NURSERY_BLOCK_COUNT
+/** Number of blocks of the nursery of each mutator thread when GCIX_ENABLE_NURSERY is enabled. Default is 8 */
+#define GCIX_NURSERY_BLOCK_COUNT 8
+#endif
+
+#ifndef GCIX_ENABLE_TRACE
+/** 
+Compiles the tracer of the phases of the collections and of the stalls of the mutator threads (see gcix::StartTrace). 
+While the tracer is not started, each traced phase costs a test of a flag. Default is false.
+*/
+#define GCIX_ENABLE_TRACE 0
+#endif
+
 #ifdef _DEBUG
 #define GCIX_ENABLE_ASSERT
 #endif
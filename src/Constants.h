@@ -41,13 +41,19 @@ namespace gcix
 		/** Number of lines in a block = 256 */
 		static const uint32_t LineCount = 1 << LineCountBits;
 		
-		/** Number of lines in the header = 2  */
-		static const uint32_t HeaderLineCount = (LineCount >> LineBits) * 2;
+		/** Granule in bit size of the object start bitmap = 2 bits ~ 4 bytes (objects are aligned on 4 bytes) */
+		static const uint32_t ObjectGranuleBits = 2;
 
-		/** Number of lines effectively available in a block = 256 - 2 lines = 254  */
+		/** Number of lines used by the object start bitmap, one bit per granule = 8 */
+		static const uint32_t ObjectStartLineCount = (1 << (BlockBits - ObjectGranuleBits - 3)) >> LineBits;
+
+		/** Number of lines in the header = 2 + 8 (object start bitmap) = 10  */
+		static const uint32_t HeaderLineCount = (LineCount >> LineBits) * 2 + ObjectStartLineCount;
+
+		/** Number of lines effectively available in a block = 256 - 10 lines = 246  */
 		static const uint32_t EffectiveLineCount = LineCount - HeaderLineCount;
 
-		/** Size of block available for allocation without headers = 254 * 256 bytes = 65024 bytes */
+		/** Size of block available for allocation without headers = 246 * 256 bytes = 62976 bytes */
 		static const uint32_t EffectiveBlockSizeInBytes = EffectiveLineCount << LineBits;
 
 		/** Size of the header in bytes */
@@ -91,13 +97,38 @@ namespace gcix
 		/** Try to collect every CollectTriggerLimit bytes allocated */
 		static const size_t CollectTriggerLimit = ChunkSizeInBytes * 7;
 
+		/** Minimum bytes of objects promoted by sticky collections since the last full collection to run a full collection */
+		static const size_t FullCollectionTriggerLimit = CollectTriggerLimit * 4;
+
 		/** Try to collect every CollectTriggerLimit bytes allocated */
 		static const size_t AlignSizeMask = ~((size_t)BlockSizeInBytesMask);
 
 		/** The minimum number of free chunks to keep alive after recycle */
-		static const int32_t MinimumFreeChunkToKeepAliveAfterRecycle = 1;
+		static const int32_t MinimumFreeChunkToKeepAliveAfterRecycle = GCIX_FREE_CHUNK_POOL_COUNT;
 		static_assert(MinimumFreeChunkToKeepAliveAfterRecycle >= 1, "MinimumFreeChunkToKeepAliveAfterRecycle must be >= 1");
 
+		/** Number of consecutive collections a chunk must be found free before being released */
+		static const uint32_t FreeChunkReleaseDelay = GCIX_FREE_CHUNK_RELEASE_DELAY;
+		static_assert(FreeChunkReleaseDelay >= 1 && FreeChunkReleaseDelay <= 0xFFFF, 
+			"FreeChunkReleaseDelay must be in [1, 65535]");
+
+		/** Card of the card table of large objects in bit size = 9 bits ~ 512 bytes */
+		static const uint32_t CardBits = 9;
+
+		/** Size of a card in bytes */
+		static const uint32_t CardSizeInBytes = 1 << CardBits;
+
+		/** Minimum number of holes (estimated by the runs of used lines) of a block to evacuate its objects */
+		static const uint32_t EvacuationMinimumHoleCount = 2;
+
+		/** Number of blocks requested at once from the GlobalAllocator to refill a thread local block cache */
+		static const int32_t BlockCacheCount = 4;
+		static_assert(BlockCacheCount >= 1, "BlockCacheCount must be >= 1");
+
+		/** Number of blocks of the nursery of a mutator thread, a collection is requested once they are all used */
+		static const int32_t NurseryBlockCount = GCIX_NURSERY_BLOCK_COUNT;
+		static_assert(NurseryBlockCount >= 1, "NurseryBlockCount must be >= 1");
+
 	private:
 		Constants(){}
 	};
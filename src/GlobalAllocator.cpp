@@ -20,15 +20,29 @@
 
 #include "GlobalAllocator.h"
 
-#include "Collections\List.h"
+#include "Collections/List.h"
 #include "ObjectFlags.h"
 #include "LineFlags.h"
-#include "Utility\Memory.h"
-#include "Threading\Thread.h"
-#include "Threading\ManualResetEvent.h"
+#include "Utility/Memory.h"
+#include "Threading/Thread.h"
+#include "Threading/ManualResetEvent.h"
+#include "Collector.h"
+#include "Tracer.h"
 
 namespace gcix
 {
+	// The largest large object, with its header and its cards rounded up to pages, must fit in the size of its flags
+#if (GCIX_ENABLE_CARD_TABLE == 1)
+	static_assert(((uint64_t)LargeObjectMaxSizeInBytes + ObjectConstants::HeaderTotalSizeInBytes + 
+		(((uint64_t)LargeObjectMaxSizeInBytes + ObjectConstants::HeaderTotalSizeInBytes) >> Constants::CardBits) + 1 + 
+		LargeObjectSpace::PageSizeInBytes - 1) <= ((uint64_t)ObjectFlags::LargeSizeAndInnerObjectOffsetMask << 2), 
+		"LargeObjectMaxSizeInBytes declared in gcix.h cannot be stored in [ObjectFlags::LargeSizeAndInnerObjectOffsetMask]");
+#else
+	static_assert(((uint64_t)LargeObjectMaxSizeInBytes + ObjectConstants::HeaderTotalSizeInBytes + 
+		LargeObjectSpace::PageSizeInBytes - 1) <= ((uint64_t)ObjectFlags::LargeSizeAndInnerObjectOffsetMask << 2), 
+		"LargeObjectMaxSizeInBytes declared in gcix.h cannot be stored in [ObjectFlags::LargeSizeAndInnerObjectOffsetMask]");
+#endif
+
 	/**
 	Initializze the @see GlobalCollector::Instance variable.
 	*/
@@ -37,7 +51,12 @@ namespace gcix
 		if (Instance == nullptr)
 		{
 			Memory::Initialize();
+			Tracer::Initialize();
+			ChunkSpace::Initialize();
+			LargeObjectSpace::Initialize();
 			Instance = new GlobalAllocator();
+			Marker::Initialize();
+			Collector::Initialize();
 		}
 	}
 
@@ -45,17 +64,55 @@ namespace gcix
 	{
 		gcix_assert(GlobalAllocator::Instance != nullptr);
 
+		gcix_trace_scope("RequestBlock");
 		gcix_lock(mutexChunks);
 
-		// Update allocation counters
-		AddAllocatedSize(Constants::TotalChunkSizeInBytes);
+		auto block = RequestBlockUnsafe(requestForEmptyBlock);
+		if (block != nullptr)
+		{
+			// Update allocation counters
+			AddAllocatedBlock(block);
+		}
+		return block;
+	}
+
+	int32_t GlobalAllocator::RequestBlocks(bool requestForEmptyBlock, BlockData** blocks, int32_t count)
+	{
+		gcix_assert(GlobalAllocator::Instance != nullptr);
+		gcix_assert(blocks != nullptr);
+		gcix_assert(count > 0);
+
+		gcix_trace_scope("RequestBlock");
+		gcix_lock(mutexChunks);
+
+		int32_t blockCount = 0;
+		for (; blockCount < count; blockCount++)
+		{
+			auto block = RequestBlockUnsafe(requestForEmptyBlock);
+
+			// out of memory, return the blocks we have been able to allocate
+			if (block == nullptr)
+			{
+				break;
+			}
 
+			// Update allocation counters
+			AddAllocatedBlock(block);
+			blocks[blockCount] = block;
+		}
+
+		return blockCount;
+	}
+
+	BlockData* GlobalAllocator::RequestBlockUnsafe(bool requestForEmptyBlock)
+	{
 		// Allocate from recyclable blocks
 		if (useRecyclableBlocks && !requestForEmptyBlock)
 		{
 			for(; nextRecyclableChunkIndex < Chunks.Count(); nextRecyclableChunkIndex++)
 			{
 				auto chunk = Chunks[nextRecyclableChunkIndex];
+				SweepChunk(chunk);
 				if (chunk->HasRecyclableBlocks())
 				{
 					for(; nextBlockIndexInChunk < chunk->GetBlockCount(); nextBlockIndexInChunk++)
@@ -64,6 +121,7 @@ namespace gcix
 						if (chunk->TryGetRecyclableBlock(block))
 						{
 							nextBlockIndexInChunk++;
+							recyclableBlocksHandedOut = true;
 							return block;
 						}
 					}
@@ -82,6 +140,7 @@ namespace gcix
 			for(; nextFreeChunkIndex < Chunks.Count(); nextFreeChunkIndex++)
 			{
 				auto chunk = Chunks[nextFreeChunkIndex];
+				SweepChunk(chunk);
 				if (chunk->HasFreeBlocks())
 				{
 					for(; nextBlockIndexInChunk < chunk->GetBlockCount(); nextBlockIndexInChunk++)
@@ -100,7 +159,7 @@ namespace gcix
 		}
 
 		// Create new chunk and free blocks
-		Chunk* chunk = new Chunk();
+		Chunk* chunk = AddChunkUnsafe();
 
 		// out of memory, early exit
 		if (chunk == nullptr)
@@ -109,121 +168,409 @@ namespace gcix
 		}
 
 		// Set the current chunk and current block index in the chunk
-		nextFreeChunkIndex = Chunks.Count();
+		nextFreeChunkIndex = Chunks.Count() - 1;
 		nextBlockIndexInChunk = 0;
 
+		// Claim the first block through the chunk, like any other free block
+		auto block = chunk->GetBlock(nextBlockIndexInChunk++);
+		chunk->TryGetFreeBlock(block);
+		return block;
+	}
+
+	Chunk* GlobalAllocator::AddChunkUnsafe()
+	{
+		Chunk* chunk = new Chunk();
+
+		// out of memory, early exit
+		if (chunk == nullptr)
+		{
+			return nullptr;
+		}
+
+		// Map all the blocks of the chunk for conservative lookups
+		if (!chunkMap.Set(chunk, (void*)((intptr_t)chunk + Constants::ChunkSizeInBytes), chunk))
+		{
+			delete chunk;
+			return nullptr;
+		}
+
+		// A new chunk has nothing to sweep
+		chunk->Header.SweepEpoch = sweepEpoch;
+
 		Chunks.Add(chunk);
 
-		return chunk->GetBlock(nextBlockIndexInChunk++);
+		return chunk;
+	}
+
+	void GlobalAllocator::SelectEvacuationBlocks()
+	{
+		ResetEvacuationBlocks();
+
+		// Lines of the free blocks receiving evacuated objects, and lines used by the candidate blocks per number of holes
+		uint32_t freeLineCount = 0;
+		uint32_t usedLineCounts[Constants::EffectiveLineCount + 1] = {};
+		for (int i = 0; i < Chunks.Count(); i++)
+		{
+			auto chunk = Chunks[i];
+			for (int j = 0; j < chunk->GetBlockCount(); j++)
+			{
+				auto block = chunk->GetBlock(j);
+				if (block->IsFree())
+				{
+					freeLineCount += Constants::EffectiveLineCount;
+				}
+				else if (block->Header.Info.Pinned == 0)
+				{
+					usedLineCounts[block->GetUsedLineRunCount()] += block->Header.Info.UsedLineCount;
+				}
+			}
+		}
+
+		// Select the blocks with the most holes first
+		uint32_t minimumHoleCount = Constants::EffectiveLineCount + 1;
+		uint32_t evacuatedLineCount = 0;
+		for (uint32_t holeCount = Constants::EffectiveLineCount; holeCount >= Constants::EvacuationMinimumHoleCount; 
+			holeCount--)
+		{
+			evacuatedLineCount += usedLineCounts[holeCount];
+			if (evacuatedLineCount > freeLineCount)
+			{
+				break;
+			}
+			minimumHoleCount = holeCount;
+		}
+
+		if (minimumHoleCount > Constants::EffectiveLineCount)
+		{
+			return;
+		}
+
+		for (int i = 0; i < Chunks.Count(); i++)
+		{
+			auto chunk = Chunks[i];
+			for (int j = 0; j < chunk->GetBlockCount(); j++)
+			{
+				auto block = chunk->GetBlock(j);
+				if (!block->IsFree() && block->Header.Info.Pinned == 0 && block->GetUsedLineRunCount() >= minimumHoleCount)
+				{
+					block->Header.Info.Evacuating = 1;
+				}
+			}
+		}
+	}
+
+#if (GCIX_ENABLE_RC == 1)
+	void GlobalAllocator::ClearLineCounts()
+	{
+		for (int i = 0; i < Chunks.Count(); i++)
+		{
+			auto chunk = Chunks[i];
+			for (int j = 0; j < chunk->GetBlockCount(); j++)
+			{
+				chunk->GetBlock(j)->ClearLineCounts();
+			}
+		}
 	}
+#endif
 
-	void GlobalAllocator::ClearMarked()
+#if (GCIX_ENABLE_NURSERY == 1)
+	void GlobalAllocator::SelectNurseryBlocks(BlockData** blocks, int32_t count)
 	{
-		auto count = Chunks.Count();
-		for(int i = 0; i < count; i++)
+		ResetEvacuationBlocks();
+
+		for (int32_t i = 0; i < count; i++)
+		{
+			if (blocks[i]->Header.Info.Pinned == 0)
+			{
+				blocks[i]->Header.Info.Evacuating = 1;
+			}
+		}
+	}
+
+	void GlobalAllocator::ReserveEvacuationBlocks(int32_t count)
+	{
+		gcix_lock(mutexChunks);
+
+		int32_t freeBlockCount = 0;
+		for (int32_t i = 0; i < Chunks.Count(); i++)
 		{
 			auto chunk = Chunks[i];
-			chunk->ClearMarked();
+			freeBlockCount += chunk->GetBlockCount() - (int32_t)chunk->Header.BlockUnavailableCount - 
+				chunk->Header.BlockRecyclableCount;
+		}
+
+		// The copies are left in place if there is no memory left for new chunks
+		while (freeBlockCount < count)
+		{
+			auto chunk = AddChunkUnsafe();
+			if (chunk == nullptr)
+			{
+				break;
+			}
+			freeBlockCount += chunk->GetBlockCount();
 		}
+	}
+#endif
+
+	BlockData* GlobalAllocator::RequestEvacuationBlock()
+	{
+		gcix_lock(mutexChunks);
 
-		// Clear marked for large objects, batch per 4 objects
-		count = LargeObjects.Count();
-		if (count > 0)
+		// A recyclable block not handed out has its initial bump cursor range on its first hole (see 
+		// @see BlockData::AllocateCopy). Recyclable blocks being evacuated don't receive copies.
+		if (evacuateIntoRecyclableBlocks)
 		{
-			LargeObjectAddress** pLargeObject = &LargeObjects[0];
-			for(int i = 0; i < count/4; i++)
+			for (; nextEvacuationChunkIndex < Chunks.Count(); nextEvacuationChunkIndex++)
 			{
-				(*pLargeObject++)->UnMark();
-				(*pLargeObject++)->UnMark();
-				(*pLargeObject++)->UnMark();
-				(*pLargeObject++)->UnMark();
+				auto chunk = Chunks[nextEvacuationChunkIndex];
+				if (chunk->HasRecyclableBlocks())
+				{
+					for (; nextEvacuationBlockIndex < chunk->GetBlockCount(); nextEvacuationBlockIndex++)
+					{
+						auto block = chunk->GetBlock(nextEvacuationBlockIndex);
+						if (block->Header.Info.Evacuating == 0 && chunk->TryGetRecyclableBlock(block))
+						{
+							nextEvacuationBlockIndex++;
+							return block;
+						}
+					}
+				}
+				nextEvacuationBlockIndex = 0;
 			}
-			count &= 3;
-			while (count-- > 0)
+
+			// We have exhausted all chunks with recyclable blocks
+			evacuateIntoRecyclableBlocks = false;
+			nextEvacuationChunkIndex = 0;
+		}
+
+		for (; nextEvacuationChunkIndex < Chunks.Count(); nextEvacuationChunkIndex++)
+		{
+			auto chunk = Chunks[nextEvacuationChunkIndex];
+			if (chunk->HasFreeBlocks())
 			{
-				(*pLargeObject++)->UnMark();
+				for (int i = 0; i < chunk->GetBlockCount(); i++)
+				{
+					auto block = chunk->GetBlock(i);
+					if (chunk->TryGetFreeBlock(block))
+					{
+						return block;
+					}
+				}
 			}
 		}
+		return nullptr;
+	}
+
+	void GlobalAllocator::BeginConcurrentTrace()
+	{
+		gcix_lock(mutexChunks);
+
+		collectRequested = false;
+		markingBlocks.Clear();
 	}
 
-	void GlobalAllocator::Recycle()
+	void GlobalAllocator::MarkAllocatedObjects()
+	{
+		gcix_lock(mutexChunks);
+
+		for (int32_t i = 0; i < markingBlocks.Count(); i++)
+		{
+			markingBlocks[i]->MarkAllocatedObjects();
+		}
+		markingBlocks.Clear();
+	}
+
+	void GlobalAllocator::Recycle(bool sticky)
 	{
 		allocatedSinceLastCollect = 0;
 		collectRequested = false;
-		nextRecyclableChunkIndex = -1;
-		nextFreeChunkIndex = -1;
-		nextBlockIndexInChunk = 0;
+		collectionCount++;
 
-		// Recycle chunk/blocks
+		gcix_lock(mutexChunks);
+
+		// Blocks of the previous collection must be swept before their line marks are reused by this collection
+		CompleteSweepUnsafe(false);
+
+		// Release the free chunks above the pool kept for the next allocations. A chunk is released only after being
+		// found free by several consecutive collections, so that the heap doesn't shrink and grow again on each cycle.
 		int freeChunkTotalCount = 0;
 		for (int i = 0; i < Chunks.Count(); i++)
+		{
+			if (Chunks[i]->IsFree())
+			{
+				freeChunkTotalCount++;
+			}
+		}
+		for (int i = Chunks.Count() - 1; i >= 0 && freeChunkTotalCount > Constants::MinimumFreeChunkToKeepAliveAfterRecycle; 
+			i--)
 		{
 			auto chunk = Chunks[i];
-			chunk->Recycle();
-
-			if (chunk->HasRecyclableBlocks() && nextRecyclableChunkIndex < 0)
+			if (chunk->IsFree() && chunk->Header.FreeCollectionCount >= Constants::FreeChunkReleaseDelay)
 			{
-				nextRecyclableChunkIndex = i;
+				Chunks.Remove(i);
+				chunkMap.Set(chunk, (void*)((intptr_t)chunk + Constants::ChunkSizeInBytes), nullptr);
+				delete chunk;
+				FreeAllocatedSize(Constants::TotalChunkSizeInBytes);
+				freeChunkTotalCount--;
 			}
-			else if (chunk->HasFreeBlocks())
+		}
+
+		// All the chunks now need to be swept. They are swept lazily when blocks are requested from them, or by the 
+		// sweeper thread, so that the pause doesn't depend on the size of the heap. Until they are swept, any chunk may 
+		// have recyclable or free blocks.
+		recycleSticky = sticky;
+		sweepEpoch++;
+		nextSweepChunkIndex = 0;
+		sweptLineCount = 0;
+		sweepCompleted = false;
+		nextRecyclableChunkIndex = 0;
+		nextFreeChunkIndex = 0;
+		nextBlockIndexInChunk = 0;
+		useRecyclableBlocks = true;
+		recyclableBlocksHandedOut = false;
+
+		// Recycle large objects, compacting the list of the surviving objects in a single pass
+		{
+			gcix_lock(mutexLargeObjects);
+
+			largeObjectLiveBytes = 0;
+			int32_t liveLargeObjectCount = 0;
+			for (int i = 0; i < LargeObjects.Count(); i++)
 			{
-				if (chunk->IsFree())
+				auto largeObject = LargeObjects[i];
+				auto size = largeObject->Size();
+				if (!largeObject->IsMarked())
 				{
-					freeChunkTotalCount++;
+					totalAllocated -= size;
+					UnMapLargeObject(largeObject);
+					LargeObjectSpace::Instance->Free(largeObject, size);
 				}
-				if (nextFreeChunkIndex < 0)
+				else
 				{
-					nextFreeChunkIndex = i;
+					largeObjectLiveBytes += size;
+					LargeObjects[liveLargeObjectCount++] = largeObject;
 				}
 			}
+			LargeObjects.Truncate(liveLargeObjectCount);
+			largeObjectBytes = largeObjectLiveBytes;
 		}
 
-		// Check if we have any recyclable blocks to reuse
-		useRecyclableBlocks = nextRecyclableChunkIndex >= 0;
+		if (sweepThread == nullptr)
+		{
+			sweepThread = new Thread(SweepRun, this);
+		}
+		sweepEvent.Set();
+	}
+
+	void GlobalAllocator::CompleteSweep()
+	{
+		gcix_lock(mutexChunks);
+		CompleteSweepUnsafe(false);
+	}
 
-		/*
-		// Free chunks that can be completely freed
-		if (freeChunkTotalCount > Constants::MinimumFreeChunkToKeepAliveAfterRecycle)
+	void GlobalAllocator::GetStatistics(Statistics& statistics)
+	{
 		{
-			for (int i = Chunks.Count() - 1; i >= 0; i--)
+			gcix_lock(mutexChunks);
+
+			uint32_t unavailableBlockCount = 0;
+			uint32_t recyclableBlockCount = 0;
+			for (int32_t i = 0; i < Chunks.Count(); i++)
 			{
 				auto chunk = Chunks[i];
-				if (chunk->IsFree())
-				{
-					Chunks.Remove(i);
-					delete chunk;
-					FreeAllocatedSize(Constants::TotalChunkSizeInBytes);
-					break;
-					//freeChunkTotalCount--;
-					//if (freeChunkTotalCount == Constants::MinimumFreeChunkToKeepAliveAfterRecycle)
-					//{
-					//	break;
-					//}
-				}
+				unavailableBlockCount += chunk->Header.BlockUnavailableCount;
+				recyclableBlockCount += chunk->Header.BlockRecyclableCount;
 			}
 
-			// Recalculate min/max only after deleting all chunks
-			Chunks.ResetMinMax();
+			statistics.FreeBlockCount = GetBlockCount() - unavailableBlockCount - recyclableBlockCount;
+			statistics.RecyclableBlockCount = recyclableBlockCount;
+			statistics.UnavailableBlockCount = unavailableBlockCount;
+			statistics.BytesMarked = liveBytes;
+		}
+
+		gcix_lock(mutexLargeObjects);
+		statistics.LargeObjectCount = LargeObjects.Count();
+		statistics.LargeObjectBytes = largeObjectBytes;
+	}
+
+	void GlobalAllocator::CompleteSweepParallel()
+	{
+		gcix_lock(mutexChunks);
+		CompleteSweepUnsafe(true);
+	}
+
+	void GlobalAllocator::CompleteSweepUnsafe(bool parallel)
+	{
+		if (sweepCompleted)
+		{
+			return;
+		}
+
+		// Split the remaining chunks across the marker workers, as chunks are independent
+		if (parallel && Chunks.Count() - nextSweepChunkIndex > SweepChunkBatchCount)
+		{
+			Marker::Instance->RunTask(SweepChunks, this);
 		}
-		*/
+		else
+		{
+			SweepChunks(this, 0);
+		}
+
+		sweepCompleted = true;
+		liveBytes = (sweptLineCount << Constants::LineBits) + largeObjectLiveBytes;
+	}
 
-		// Recycle large objects
-		bool largeObjectRemoved = false;
-		for (int i = LargeObjects.Count() - 1; i >= 0; i--)
+	void GlobalAllocator::SweepChunks(void* context, int32_t)
+	{
+		auto allocator = (GlobalAllocator*)context;
+		auto chunkCount = allocator->Chunks.Count();
+
+		gcix_trace_scope("SweepChunks");
+
+		while (true)
 		{
-			auto largeObject = LargeObjects[i];
-			if (!largeObject->IsMarked())
+			auto start = allocator->nextSweepChunkIndex.fetch_add(SweepChunkBatchCount);
+			if (start >= chunkCount)
 			{
-				auto size = largeObject->Size();
-				totalAllocated -= size;
-				Memory::Free(largeObject);
-				LargeObjects.Remove(i);
-				largeObjectRemoved = true;
+				break;
+			}
+
+			auto end = std::min(start + SweepChunkBatchCount, chunkCount);
+			for (int32_t i = start; i < end; i++)
+			{
+				allocator->SweepChunk(allocator->Chunks[i]);
 			}
 		}
-		if (largeObjectRemoved)
+	}
+
+	void GlobalAllocator::SweepRun(void* context)
+	{
+		auto allocator = (GlobalAllocator*)context;
+		while (true)
 		{
-			LargeObjects.ResetMinMax();
+			allocator->sweepEvent.WaitOne();
+
+			// Sweep a few chunks at a time, so that mutators requesting blocks are not blocked for long
+			while (true)
+			{
+				gcix_trace_scope("LazySweep");
+				gcix_lock(allocator->mutexChunks);
+
+				int32_t start = allocator->nextSweepChunkIndex;
+				if (allocator->sweepCompleted || start >= allocator->Chunks.Count())
+				{
+					allocator->CompleteSweepUnsafe(false);
+					allocator->sweepEvent.Reset();
+					break;
+				}
+
+				auto end = std::min(start + SweepChunkBatchCount, allocator->Chunks.Count());
+				for (int32_t i = start; i < end; i++)
+				{
+					allocator->SweepChunk(allocator->Chunks[i]);
+				}
+				allocator->nextSweepChunkIndex = end;
+			}
 		}
 	}
 
@@ -232,10 +579,23 @@ namespace gcix
 		gcix_assert(GlobalAllocator::Instance != nullptr);
 		gcix_assert(size > ObjectConstants::MaxObjectSizePerBlock);
 		gcix_assert(classDescriptor != nullptr);
+		gcix_assert(ObjectAddress::IsValidClassDescriptor(classDescriptor, size));
+		gcix_assert(size <= LargeObjectMaxSizeInBytes);
+
+		// The size of the object would be truncated in its flags
+		if (size > LargeObjectMaxSizeInBytes)
+		{
+			return nullptr;
+		}
 
-		// Allocate the object with standard allocation, align size of object on 16 bytes
-		auto sizeOfLargeObject = Memory::Align(size + ObjectConstants::HeaderTotalSizeInBytes, 16);
-		LargeObjectAddress* object = (LargeObjectAddress*)Memory::AllocateZero(sizeOfLargeObject);
+		// Allocate the object from the large object space, the size of the object is a multiple of its pages
+		size_t objectSize = size + ObjectConstants::HeaderTotalSizeInBytes;
+#if (GCIX_ENABLE_CARD_TABLE == 1)
+		// Followed by its cards
+		objectSize += (objectSize >> Constants::CardBits) + 1;
+#endif
+		auto sizeOfLargeObject = LargeObjectSpace::GetAllocationSize(objectSize);
+		LargeObjectAddress* object = (LargeObjectAddress*)LargeObjectSpace::Instance->Allocate(sizeOfLargeObject);
 
 		// out of memory, early exit
 		if (object == nullptr)
@@ -245,86 +605,121 @@ namespace gcix
 
 		object->Initialize(sizeOfLargeObject);
 		object->SetClassDescriptor(classDescriptor);
+#if (GCIX_ENABLE_CARD_TABLE == 1)
+		gcix_assert((size_t)(object->Cards() - (uint8_t*)object) >= size + ObjectConstants::HeaderTotalSizeInBytes);
+#endif
+
+		// Objects allocated during a concurrent trace are live
+		if (Marker::Marking())
+		{
+			object->Mark();
+		}
 
 		// TODO use a separate lock for LOB?
 		gcix_lock(mutexLargeObjects);
 
+		if (!MapLargeObject(object))
+		{
+			UnMapLargeObject(object);
+			LargeObjectSpace::Instance->Free(object, sizeOfLargeObject);
+			return nullptr;
+		}
+
 		LargeObjects.Add(object);
+		largeObjectBytes += sizeOfLargeObject;
 		// Update allocation counters
 		AddAllocatedSize(Constants::ChunkSizeInBytes);
 
 		return object;
 	}
 
+	bool GlobalAllocator::MapLargeObject(LargeObjectAddress* object)
+	{
+		auto head = largeObjectMap.Get(object);
+		if (head == nullptr)
+		{
+			return false;
+		}
+		gcix_assert(head->Head == nullptr);
+		head->Head = object;
+
+		// All the following pages overlapped by the object
+		auto end = (intptr_t)object + object->Size();
+		auto nextPage = (((intptr_t)object >> LargeObjectPageBits) + 1) << LargeObjectPageBits;
+		for (auto page = nextPage; page < end; page += (1 << LargeObjectPageBits))
+		{
+			auto entry = largeObjectMap.Get((void*)page);
+			if (entry == nullptr)
+			{
+				return false;
+			}
+			gcix_assert(entry->Tail == nullptr);
+			entry->Tail = object;
+		}
+		return true;
+	}
+
+	void GlobalAllocator::UnMapLargeObject(LargeObjectAddress* object)
+	{
+		auto end = (intptr_t)object + object->Size();
+		for (auto page = (intptr_t)object & ~(intptr_t)((1 << LargeObjectPageBits) - 1); page < end; 
+			page += (1 << LargeObjectPageBits))
+		{
+			auto entry = largeObjectMap.Find((void*)page);
+			if (entry == nullptr)
+			{
+				continue;
+			}
+			if (entry->Head == object)
+			{
+				entry->Head = nullptr;
+			}
+			if (entry->Tail == object)
+			{
+				entry->Tail = nullptr;
+			}
+		}
+	}
+
 	ObjectAddress* GlobalAllocator::FindObjectConservative(void* ptr)
 	{
 		gcix_assert(GlobalAllocator::Instance != nullptr);
 
-		// Discard immediately pointers that are outside the min/max chunk memory range
-		if (Chunks.Contains((Chunk*)ptr))
+		// Get the chunk owning the block of this address, if any
+#if (GCIX_HEAP_RESERVATION_SIZE > 0)
+		if (ChunkSpace::Instance->Contains(ptr))
 		{
-			// Get the chunk bucket associated with this address
-			auto bucket = Chunks.GetBucket((Chunk*)ptr);
-
-			// Iterate on chunks
-			auto pChunk = &(*bucket)[0];
-		
-			// Iterate on all chunks
-			for(Chunk* chunk; ptr >= (chunk = *pChunk); pChunk++)
+			auto chunk = (Chunk*)ChunkSpace::Instance->FindChunk(ptr);
+#else
+		auto pChunk = chunkMap.Find(ptr);
+		if (pChunk != nullptr && *pChunk != nullptr)
+		{
+			auto chunk = *pChunk;
+#endif
+			if (chunk != nullptr && ptr < chunk->GetEndOfChunk())
 			{
-				if (ptr < chunk->GetEndOfChunk())
+				// Find the object starting before this address, and check that it contains it
+				auto blockData = (BlockData*)((size_t)ptr & Constants::AlignSizeMask);
+				auto object = blockData->FindObjectStart(ptr);
+				if (object != nullptr && ptr < object->NextObject())
 				{
-					auto blockData = (BlockData*)((size_t)ptr & Constants::AlignSizeMask);
-					auto offsetInBlock = (uint32_t)((size_t)ptr - (size_t)blockData);
-					auto lineInBlock = offsetInBlock >> Constants::LineBits;
-
-					for(uint32_t lineIndex = lineInBlock; lineIndex >= Constants::HeaderLineCount; lineIndex--)
-					{
-						if (blockData->ContainsObject(lineIndex))
-						{
-							auto object = blockData->GetFirstObject(lineIndex);
-							if (ptr < object)
-							{
-								continue;
-							}
-
-							while (true)
-							{
-								if (StandardObjectAddress::IsInteriorPointerOrNext(object, ptr))
-								{
-									return object;
-								}
-								else if (object == nullptr)
-								{
-									// If there is no other objects, or the next object after the pointer we are checking, 
-									// return null
-									goto CheckLargeObject;
-								}
-							} 
-						}
-					}
-					break;
+					return object;
 				}
 			}
+			return nullptr;
 		}
 
-CheckLargeObject:
-		// Discard immediately pointers that are outside the min/max memory range for LOB
-		if (LargeObjects.Contains((LargeObjectAddress*)ptr))
+		// Get the large objects overlapping the page of this address, if any
+		auto page = largeObjectMap.Find(ptr);
+		if (page != nullptr)
 		{
-			// Get the chunk bucket associated with this addrses
-			auto bucket = LargeObjects.GetBucket((LargeObjectAddress*)ptr);
-
-			// Iterate on chunks
-			auto pObjs = &(*bucket)[0];
-		
-			// Iterate on all chunks
-			for(LargeObjectAddress* obj; ptr >= (obj = *pObjs); pObjs++)
+			if (page->Head != nullptr && ptr >= page->Head)
 			{
-				if (obj->Contains(ptr))
-				{
-					return obj;
-				}
+				return page->Head->Contains(ptr) ? page->Head : nullptr;
+			}
+			if (page->Tail != nullptr && page->Tail->Contains(ptr))
+			{
+				return page->Tail;
 			}
 		}
 
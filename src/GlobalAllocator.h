@@ -19,35 +19,36 @@
 // LIABILITY, OR TORT (INCLUDING NEGLIGENCE OR OTHERWISE) ARISING IN ANY WAY OUT OF THE USE OF THIS SOFTWARE, EVEN IF ADVISED 
 // OF THE POSSIBILITY OF SUCH DAMAGE.
 
+#include "gcix.h"
 #include "Common.h"
 
-#include "Collections\List.h"
+#include "Collections/List.h"
 #include "BlockData.h"
-#include "Utility\Memory.h"
+#include "Utility/Memory.h"
 #include "Chunk.h"
+#include "LargeObjectSpace.h"
 #include "ObjectAddress.h"
-#include "Collections\OrderedBucketRange.h"
-#include "Threading\Mutex.h"
+#include "Collections/PageMap.h"
+#include "Threading/Mutex.h"
+#include "Threading/Thread.h"
+#include "Threading/ManualResetEvent.h"
 #include "Marker.h"
 
+#include <atomic>
+
 namespace gcix
 {
-	class OrderedBucketRangeChunkHelper 
+	/**
+	An entry of the large object page map. As a large object is larger than a page, a page overlaps at most one object 
+	starting before the page and one object starting inside the page.
+	*/
+	struct LargeObjectPage
 	{
-	public:
-		inline static Chunk* GetEndOfItem(Chunk* chunk)
-		{
-			return (Chunk*)((intptr_t)chunk + Constants::ChunkSizeInBytes);
-		}
-	};
+		/** The large object starting inside this page */
+		LargeObjectAddress* Head;
 
-	class OrderedBucketRangeLargeObjectHelper
-	{
-	public:
-		inline static LargeObjectAddress* GetEndOfItem(LargeObjectAddress* object)
-		{
-			return (LargeObjectAddress*)((intptr_t)object + object->Size());
-		}
+		/** The large object starting before this page and overlapping it */
+		LargeObjectAddress* Tail;
 	};
 
     /**
@@ -65,6 +66,16 @@ namespace gcix
         */
 		BlockData* RequestBlock(bool requestForEmptyBlock);
 
+        /**
+        Returns several allocated blocks while acquiring the chunks lock only once.
+        This function is primarily used by the @see BlockCache of a @see ThreadLocalAllocator
+        @param requestForEmptyBlock true to force the returned blocks to be empty/free blocks (not recyclable)
+        @param blocks An array receiving the allocated blocks
+        @param count The maximum number of blocks to allocate
+        @return the number of blocks stored in `blocks`. Less than `count` in case of an out of memory.
+        */
+		int32_t RequestBlocks(bool requestForEmptyBlock, BlockData** blocks, int32_t count);
+
         /**
         Allocate a large object.
         @param size Size of the large object to allocate.
@@ -78,6 +89,24 @@ namespace gcix
 			return collectRequested;
 		}
 
+		/**
+		Requests a collection, performed by the next mutator thread reaching a safepoint. Used at the end of a concurrent 
+		trace to request its remark pause.
+		*/
+		inline void RequestCollect()
+		{
+			collectRequested = true;
+		}
+
+		/**
+		Returns the number of collections performed so far. Blocks handed out before a collection must not be used
+		after it.
+		*/
+		inline uint32_t CollectionCount() const
+		{
+			return collectionCount;
+		}
+
 		ObjectAddress* FindObjectConservative(void* ptr);
 
         /**
@@ -103,54 +132,135 @@ namespace gcix
 			return allocatedSinceLastCollect;
 		}
 
-		/**
-		Clear all marked blocks/objects 
-		*/
-		void ClearMarked();
+        /**
+        Returns the bytes used by the objects that survived the last collection (lines of blocks and large objects), once
+        its sweep is completed (see @see CompleteSweep). Returns the value of the previous collection until then.
+        @return size of live data after the last collect
+        */
+		inline size_t LiveBytes()
+		{
+			return liveBytes;
+		}
 
         /**
-        Recycle allocated blocks.
+        Recycle allocated blocks. Large objects are swept immediately, while the chunks are only flagged to be swept 
+        lazily: by the first request of a block from them, by the sweeper thread, or by @see CompleteSweep.
+        @param sticky true after a sticky trace, to keep the blocks lines and the large objects of old objects
         */
-		void Recycle();
+		void Recycle(bool sticky);
+
+        /**
+        Sweeps all the chunks not yet swept since the last collection, and updates @see LiveBytes.
+        */
+		void CompleteSweep();
+
+		/**
+		Fills the block counts and the large objects statistics. The counts of a chunk are updated when it is swept.
+		@param statistics The statistics to fill
+		*/
+		void GetStatistics(Statistics& statistics);
 
 		void AddGcRoot(void** gcRoot);
 
 		void RemoveGcRoot(void** gcRoot);
 
 		/**
-		Mark all gc roots objects.
+		Mark all gc roots objects. Objects reachable from the roots are only marked by @see Marker::Trace. Roots are updated
+		if the objects they reference are evacuated.
 		*/
 		void MarkRoots()
 		{
 			for (int i = 0; i < gcRoots.Count(); i++)
 			{
-				if (*gcRoots[i] != nullptr)
-				{
-					ObjectAddress* object = ObjectAddress::FromUserObject(*gcRoots[i]);
-					Marker::Mark(object);
-				}
+				Marker::MarkReference(gcRoots[i]);
 			}
 		}
 
+		/**
+		Selects the blocks whose objects are evacuated by the next trace (opportunistic defragmentation). The most 
+		fragmented blocks, according to the statistics of the last recycle, are selected first, as long as their used lines
+		fit in the free blocks. Blocks with a non zero Pinned byte are never selected. Must be called before a full trace.
+		*/
+		void SelectEvacuationBlocks();
+
+#if (GCIX_ENABLE_RC == 1)
+		/**
+		Clears the line counts of all the blocks (see @see BlockData::ClearLineCounts). Must be called before a full trace
+		counting the references.
+		*/
+		void ClearLineCounts();
+#endif
+
+#if (GCIX_ENABLE_NURSERY == 1)
+		/**
+		Selects the blocks of the nursery of a mutator, whose objects are copied out of them by the next trace. Blocks with
+		a non zero Pinned byte are never selected. Must be called before the trace, the mutators being stopped.
+		@param blocks the blocks of the nursery.
+		@param count the number of blocks of the nursery.
+		*/
+		void SelectNurseryBlocks(BlockData** blocks, int32_t count);
+
+		/**
+		Allocates new chunks until the heap contains the specified number of free blocks, so that the objects surviving in
+		the nurseries can be copied out of them even when the nurseries use all the blocks of the heap. Must be called 
+		after @see SelectNurseryBlocks, before the trace.
+		@param count the number of blocks of the nurseries.
+		*/
+		void ReserveEvacuationBlocks(int32_t count);
+#endif
+
+		/**
+		Returns a block receiving objects evacuated by the current trace, without allocating a new chunk. The holes of the 
+		recyclable blocks are filled first if no recyclable block has been handed out to the mutators since the last 
+		collection (e.g the mutators only allocate into their nursery), then the free blocks.
+		@return an address to a @see BlockData or `nullptr_t` if there is no block left.
+		*/
+		BlockData* RequestEvacuationBlock();
+
+		/**
+		Marks the objects allocated by the mutators during a concurrent trace, in the blocks handed out since 
+		@see BeginConcurrentTrace, as if they had been allocated marked. Objects allocated during a concurrent trace are 
+		live and don't need to be traced: the objects they reference were reachable when the trace started or are 
+		allocated during the trace as well. Must be called during the remark pause, after the trace is completed.
+		*/
+		void MarkAllocatedObjects();
+
 		static GlobalAllocator* Instance;
 	private:
 		gcix_overrides_new_delete();
 			
 		GlobalAllocator() :
+			Chunks(ChunkCount),
+			LargeObjects(LargeObjectCount),
+			largeObjectBytes(0),
 			nextRecyclableChunkIndex(-1), 
 			nextFreeChunkIndex(-1),
 			nextBlockIndexInChunk(0), 
+			nextEvacuationChunkIndex(0),
+			nextEvacuationBlockIndex(0),
+			evacuateIntoRecyclableBlocks(false),
+			recyclableBlocksHandedOut(false),
 			totalAllocated(0), 
-			allocatedSinceLastCollect(0),
-			collectRequested(false),
 			useRecyclableBlocks(false),
+			collectRequested(false),
+			allocatedSinceLastCollect(0),
+			liveBytes(0),
+			collectionCount(0),
+			recycleSticky(false),
+			sweepCompleted(true),
+			sweepEpoch(0),
+			nextSweepChunkIndex(0),
+			sweptLineCount(0),
+			largeObjectLiveBytes(0),
+			markingBlocks(ChunkCount),
+			sweepThread(nullptr),
 			gcRoots(GCRootsCount)
 		{
 		}
 
 		static const int GCRootsCount = 512;
-		static const int BucketCount = 512;
-		static const int ChunkPerBucketCount = 8;
+		static const int ChunkCount = 512;
+		static const int LargeObjectCount = 512;
 
 		/* Gets the total number of block */
 		inline uint32_t GetBlockCount()
@@ -174,22 +284,106 @@ namespace gcix
 			// Update allocation counters
 			totalAllocated += size;
 			allocatedSinceLastCollect += size;;
-			if (allocatedSinceLastCollect >= Constants::CollectTriggerLimit )
+
+			// A concurrent trace requests its remark pause once completed, unless the mutators allocate another trigger limit 
+			// in the meantime: the remark pause then waits for the trace
+			auto limit = Marker::Marking() ? Constants::CollectTriggerLimit * 2 : Constants::CollectTriggerLimit;
+			if (allocatedSinceLastCollect >= limit)
 			{
 				collectRequested = true;
 			}
 		}
 
+		/* 
+		Updates the allocation counters for a block handed out with the bytes it can receive, a recyclable block only 
+		accounts for its free lines. The blocks handed out during a concurrent trace are recorded for 
+		@see MarkAllocatedObjects.
+		*/
+		inline void AddAllocatedBlock(BlockData* block)
+		{
+			if (Marker::Marking())
+			{
+				markingBlocks.Add(block);
+			}
+
+			if (block->IsRecyclable())
+			{
+				AddAllocatedSize((size_t)Constants::EffectiveBlockSizeInBytes * 
+					(Constants::EffectiveLineCount - block->Header.Info.UsedLineCount) / Constants::EffectiveLineCount);
+			}
+			else
+			{
+				AddAllocatedSize(Constants::EffectiveBlockSizeInBytes);
+			}
+		}
+
+		/* Number of chunks swept at once by a worker or the sweeper thread */
+		static const int32_t SweepChunkBatchCount = 4;
+
+		/* Sweeps a chunk if it has not been swept since the last collection */
+		inline void SweepChunk(Chunk* chunk)
+		{
+			if (chunk->Header.SweepEpoch != sweepEpoch)
+			{
+				sweptLineCount += chunk->Recycle(recycleSticky);
+				chunk->Header.SweepEpoch = sweepEpoch;
+			}
+		}
+
+		/* 
+		Starts recording the blocks handed out until the remark pause of a concurrent trace, and clears the collection 
+		request of its initial pause. Must be called from the collecting thread
+		*/
+		void BeginConcurrentTrace();
+
+		/* Sweeps the remaining chunks on the marker workers. Must be called from the collecting thread */
+		void CompleteSweepParallel();
+
+		/* Sweeps the remaining chunks, in parallel on the marker workers if requested. Must hold the chunks lock */
+		void CompleteSweepUnsafe(bool parallel);
+
+		/* Sweeps the chunks not yet claimed by other workers, see @see WorkerTaskDelegate */
+		static void SweepChunks(void* context, int32_t workerIndex);
+
+		/* Entry point of the sweeper thread */
+		static void SweepRun(void* context);
+
+		/* Returns the next block available without taking the chunks lock and without updating counters */
+		BlockData* RequestBlockUnsafe(bool requestForEmptyBlock);
+
+		/* Allocates a new chunk of free blocks and adds it to the chunks, without taking the chunks lock */
+		Chunk* AddChunkUnsafe();
+
 		inline void FreeAllocatedSize(size_t size)
 		{
 			totalAllocated -= size;
 		}
 
+		/* Size of a page of the large object page map, must be lower than the size of the smallest large object */
+		static const uint32_t LargeObjectPageBits = 13;
+		static_assert((1 << LargeObjectPageBits) <= ObjectConstants::MaxObjectSizePerBlock, 
+			"LargeObjectPageBits must be lower than the size of a large object");
+
+		/* Maps a large object to its page map entries. Returns false in case of an out of memory */
+		bool MapLargeObject(LargeObjectAddress* object);
+
+		/* Removes a large object from the page map */
+		void UnMapLargeObject(LargeObjectAddress* object);
+
 		Mutex mutexChunks;
-		OrderedBucketRange<Chunk, OrderedBucketRangeChunkHelper> Chunks;
+		List<Chunk*> Chunks;
+
+		/* Maps each block of the allocated chunks to its chunk */
+		PageMap<Chunk*, Constants::BlockBits> chunkMap;
 
 		Mutex mutexLargeObjects;
-		OrderedBucketRange<LargeObjectAddress, OrderedBucketRangeLargeObjectHelper> LargeObjects;
+		List<LargeObjectAddress*> LargeObjects;
+
+		/* Bytes used by the large objects */
+		size_t largeObjectBytes;
+
+		/* Maps each page overlapped by a large object to this object */
+		PageMap<LargeObjectPage, LargeObjectPageBits> largeObjectMap;
 
 		/* Pointer to the current chunk in used for allocation*/
 		int32_t nextRecyclableChunkIndex;
@@ -199,12 +393,51 @@ namespace gcix
 		/* Next block index in the chunk */
 		int32_t nextBlockIndexInChunk;
 
+		/* Next chunk to search for a block receiving evacuated objects */
+		int32_t nextEvacuationChunkIndex;
+
+		/* Next block index in the chunk searched for a recyclable block receiving evacuated objects */
+		int32_t nextEvacuationBlockIndex;
+
+		/* True while the recyclable blocks are searched for a block receiving evacuated objects */
+		bool evacuateIntoRecyclableBlocks;
+
+		/* True if a recyclable block has been handed out since the last collection, its holes being allocated into */
+		bool recyclableBlocksHandedOut;
+
+		/* Restarts the search of the blocks receiving evacuated objects, see @see RequestEvacuationBlock */
+		inline void ResetEvacuationBlocks()
+		{
+			nextEvacuationChunkIndex = 0;
+			nextEvacuationBlockIndex = 0;
+			evacuateIntoRecyclableBlocks = !recyclableBlocksHandedOut;
+		}
+
 		size_t totalAllocated;
 
 		bool useRecyclableBlocks;
 
-        bool collectRequested;
+		/* Set by the marker thread at the end of a concurrent trace, read by the mutators at their safepoints */
+		std::atomic<bool> collectRequested;
+
         size_t allocatedSinceLastCollect;
+		size_t liveBytes;
+		uint32_t collectionCount;
+
+		/* State of the sweep of the last collection, shared by the workers and the sweeper thread */
+		bool recycleSticky;
+		bool sweepCompleted;
+		uint16_t sweepEpoch;
+		std::atomic<int32_t> nextSweepChunkIndex;
+		std::atomic<size_t> sweptLineCount;
+		size_t largeObjectLiveBytes;
+
+		/* Blocks handed out during the current concurrent trace */
+		List<BlockData*> markingBlocks;
+
+		/* Thread sweeping the chunks in the background, created by the first collection */
+		ManualResetEvent sweepEvent;
+		Thread* sweepThread;
 
 		Mutex mutexRoots;
 		List<void**> gcRoots;
@@ -213,5 +446,6 @@ namespace gcix
 		// Unit tets
 		// -----------------------------------------------------------
 		FRIEND_TEST(GlobalAllocatorTest, RequestBlock);
+		FRIEND_TEST(CollectorTest, ParallelSweep);
 	};
 }
\ No newline at end of file
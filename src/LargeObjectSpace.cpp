@@ -0,0 +1,112 @@
+﻿// Copyright (c) 2014, Alexandre Mutel
+// All rights reserved.
+// 
+// Redistribution and use in source and binary forms, with or without modification, are permitted provided that the following  
+// conditions are met:
+// 
+// 1. Redistributions of source code must retain the above copyright notice, this list of conditions and the following 
+//    disclaimer.
+// 
+// 2. Redistributions in binary form must reproduce the above copyright notice, this list of conditions and the following 
+//    disclaimer in the documentation and/or other materials provided with the distribution.
+// 
+// THIS SOFTWARE IS PROVIDED BY THE COPYRIGHT HOLDERS AND CONTRIBUTORS "AS IS" AND ANY EXPRESS OR IMPLIED WARRANTIES, 
+// INCLUDING, BUT NOT LIMITED TO, THE IMPLIED WARRANTIES OF MERCHANTABILITY AND FITNESS FOR A PARTICULAR PURPOSE ARE 
+// DISCLAIMED. IN NO EVENT SHALL THE COPYRIGHT HOLDER OR CONTRIBUTORS BE LIABLE FOR ANY DIRECT, INDIRECT, INCIDENTAL, SPECIAL, 
+// EXEMPLARY, OR CONSEQUENTIAL DAMAGES (INCLUDING, BUT NOT LIMITED TO, PROCUREMENT OF SUBSTITUTE GOODS OR SERVICES; LOSS OF 
+// USE, DATA, OR PROFITS; OR BUSINESS INTERRUPTION) HOWEVER CAUSED AND ON ANY THEORY OF LIABILITY, WHETHER IN CONTRACT, STRICT 
+// LIABILITY, OR TORT (INCLUDING NEGLIGENCE OR OTHERWISE) ARISING IN ANY WAY OUT OF THE USE OF THIS SOFTWARE, EVEN IF ADVISED 
+// OF THE POSSIBILITY OF SUCH DAMAGE.
+
+#include "gcix.h"
+
+#include "LargeObjectSpace.h"
+
+namespace gcix
+{
+	/**
+	Initialize the @see LargeObjectSpace::Instance variable.
+	*/
+	void LargeObjectSpace::Initialize()
+	{
+		if (Instance == nullptr)
+		{
+			Instance = new LargeObjectSpace();
+		}
+	}
+
+	LargeObjectSpace::LargeObjectSpace() : reservations(ReservationCount), nextSpan(0), endOfReservation(0)
+	{
+	}
+
+	void* LargeObjectSpace::Allocate(size_t size)
+	{
+		gcix_assert(size > 0 && (size & (PageSizeInBytes - 1)) == 0);
+
+		// Huge objects are mapped directly, already zeroed by the OS
+		if (size > MaxSpanSizeInBytes)
+		{
+			return Memory::AllocatePages(size);
+		}
+
+		gcix_lock(mutexSpans);
+
+		// Reuse a freed span of the same size class
+		auto& sizeClass = freeSpans[(size >> PageBits) - 1];
+		int32_t freeSpanCount = sizeClass.Count();
+		if (freeSpanCount > 0)
+		{
+			auto span = sizeClass[freeSpanCount - 1];
+			sizeClass.Remove(freeSpanCount - 1);
+			Memory::ClearLarge(span, size);
+			return span;
+		}
+
+		if (nextSpan + (intptr_t)size > endOfReservation)
+		{
+			auto reservation = Memory::Reserve(ReservationSize, PageSizeInBytes);
+
+			// out of memory, early exit
+			if (reservation == nullptr)
+			{
+				return nullptr;
+			}
+
+			// Keep the remaining pages of the previous range for the next objects
+			if (nextSpan != endOfReservation)
+			{
+				AddFreeSpan((void*)nextSpan, endOfReservation - nextSpan);
+			}
+
+			reservations.Add(reservation);
+			nextSpan = (intptr_t)reservation;
+			endOfReservation = nextSpan + ReservationSize;
+		}
+
+		auto span = (void*)nextSpan;
+		if (!Memory::Commit(span, size))
+		{
+			return nullptr;
+		}
+		nextSpan += size;
+
+		return span;
+	}
+
+	void LargeObjectSpace::Free(void* object, size_t size)
+	{
+		gcix_assert(object != nullptr);
+		gcix_assert(size > 0 && (size & (PageSizeInBytes - 1)) == 0);
+
+		if (size > MaxSpanSizeInBytes)
+		{
+			Memory::FreePages(object, size);
+			return;
+		}
+
+		gcix_lock(mutexSpans);
+		AddFreeSpan(object, size);
+	}
+
+	LargeObjectSpace* LargeObjectSpace::Instance;
+}
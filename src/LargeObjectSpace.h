@@ -0,0 +1,112 @@
+﻿#pragma once
+// Copyright (c) 2014, Alexandre Mutel
+// All rights reserved.
+// 
+// Redistribution and use in source and binary forms, with or without modification, are permitted provided that the following 
+// conditions are met:
+// 
+// 1. Redistributions of source code must retain the above copyright notice, this list of conditions and the following 
+//    disclaimer.
+// 
+// 2. Redistributions in binary form must reproduce the above copyright notice, this list of conditions and the following 
+//    disclaimer in the documentation and/or other materials provided with the distribution.
+// 
+// THIS SOFTWARE IS PROVIDED BY THE COPYRIGHT HOLDERS AND CONTRIBUTORS "AS IS" AND ANY EXPRESS OR IMPLIED WARRANTIES, 
+// INCLUDING, BUT NOT LIMITED TO, THE IMPLIED WARRANTIES OF MERCHANTABILITY AND FITNESS FOR A PARTICULAR PURPOSE ARE 
+// DISCLAIMED. IN NO EVENT SHALL THE COPYRIGHT HOLDER OR CONTRIBUTORS BE LIABLE FOR ANY DIRECT, INDIRECT, INCIDENTAL, SPECIAL, 
+// EXEMPLARY, OR CONSEQUENTIAL DAMAGES (INCLUDING, BUT NOT LIMITED TO, PROCUREMENT OF SUBSTITUTE GOODS OR SERVICES; LOSS OF 
+// USE, DATA, OR PROFITS; OR BUSINESS INTERRUPTION) HOWEVER CAUSED AND ON ANY THEORY OF LIABILITY, WHETHER IN CONTRACT, STRICT 
+// LIABILITY, OR TORT (INCLUDING NEGLIGENCE OR OTHERWISE) ARISING IN ANY WAY OUT OF THE USE OF THIS SOFTWARE, EVEN IF ADVISED 
+// OF THE POSSIBILITY OF SUCH DAMAGE.
+
+
+#include "Common.h"
+#include "Constants.h"
+#include "Collections/List.h"
+#include "Threading/Mutex.h"
+#include "Utility/Memory.h"
+
+namespace gcix
+{
+	/**
+	Provides the memory of large objects. Objects up to @see LargeObjectSpace::MaxSpanSizeInBytes are allocated in spans of 
+	pages carved from large reserved ranges of virtual memory, segregated by their number of pages: a freed span is 
+	reused by the next object of the same size class. Larger objects are mapped directly from the OS and unmapped when
+	freed. 
+	*/
+	class LargeObjectSpace
+	{
+	public:
+		/** Size of a page of a span in bits = 12 bits ~ 4096 bytes */
+		static const uint32_t PageBits = 12;
+
+		/** Size of a page of a span in bytes */
+		static const uint32_t PageSizeInBytes = 1 << PageBits;
+
+		/** Maximum size of a span, larger objects are mapped directly from the OS = 1 MB */
+		static const uint32_t MaxSpanSizeInBytes = 1 << 20;
+
+		/**
+		Initialize the @see LargeObjectSpace::Instance variable.
+		*/
+		static void Initialize();
+
+		/**
+		Returns the size of the memory allocated for a large object of the specified size.
+		@param size Size in bytes of the large object, including its header
+		@return the size rounded up to a multiple of @see PageSizeInBytes
+		*/
+		static inline size_t GetAllocationSize(size_t size)
+		{
+			return Memory::Align(size, PageSizeInBytes);
+		}
+
+		/**
+		Allocates the memory of a large object, aligned on @see PageSizeInBytes and zeroed.
+		@param size Size in bytes returned by @see GetAllocationSize
+		@return the address of the memory or `nullptr` in case of an out of memory
+		*/
+		void* Allocate(size_t size);
+
+		/**
+		Frees the memory of a large object allocated by @see Allocate.
+		@param size Size in bytes passed to @see Allocate
+		*/
+		void Free(void* object, size_t size);
+
+		static LargeObjectSpace* Instance;
+	private:
+		gcix_overrides_new_delete();
+
+		LargeObjectSpace();
+
+		/* Adds a span to the free list of its size class */
+		inline void AddFreeSpan(void* span, size_t size)
+		{
+			freeSpans[(size >> PageBits) - 1].Add(span);
+		}
+
+		static const int ReservationCount = 64;
+
+		/* Number of size classes of spans, one per number of pages */
+		static const uint32_t SizeClassCount = MaxSpanSizeInBytes >> PageBits;
+
+		/* Size of a reserved range of spans, multiple of the maximum size of a span */
+		static const size_t ReservationSize = ((size_t)GCIX_CHUNK_RESERVATION_SIZE + MaxSpanSizeInBytes - 1) & 
+			~((size_t)MaxSpanSizeInBytes - 1);
+
+		Mutex mutexSpans;
+
+		/* Ranges of virtual memory reserved so far */
+		List<void*> reservations;
+
+		/* Freed spans to reuse, per size class */
+		List<void*> freeSpans[SizeClassCount];
+
+		/* Next span never allocated in the last reserved range */
+		intptr_t nextSpan;
+
+		/* End of the last reserved range */
+		intptr_t endOfReservation;
+	};
+}
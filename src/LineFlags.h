@@ -34,7 +34,7 @@ namespace gcix
 		Empty = 0x00,
 
 		/**
-		Marked bit indicates if a line is marked
+		Marked bit indicates if a line is marked by the current trace. Cleared when the block is recycled.
 		*/
 		Marked = 0x01,
 
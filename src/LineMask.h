@@ -0,0 +1,190 @@
+﻿#pragma once
+// Copyright (c) 2014, Alexandre Mutel
+// All rights reserved.
+// 
+// Redistribution and use in source and binary forms, with or without modification, are permitted provided that the following 
+// conditions are met:
+// 
+// 1. Redistributions of source code must retain the above copyright notice, this list of conditions and the following 
+//    disclaimer.
+// 
+// 2. Redistributions in binary form must reproduce the above copyright notice, this list of conditions and the following 
+//    disclaimer in the documentation and/or other materials provided with the distribution.
+// 
+// THIS SOFTWARE IS PROVIDED BY THE COPYRIGHT HOLDERS AND CONTRIBUTORS "AS IS" AND ANY EXPRESS OR IMPLIED WARRANTIES, 
+// INCLUDING, BUT NOT LIMITED TO, THE IMPLIED WARRANTIES OF MERCHANTABILITY AND FITNESS FOR A PARTICULAR PURPOSE ARE 
+// DISCLAIMED. IN NO EVENT SHALL THE COPYRIGHT HOLDER OR CONTRIBUTORS BE LIABLE FOR ANY DIRECT, INDIRECT, INCIDENTAL, SPECIAL, 
+// EXEMPLARY, OR CONSEQUENTIAL DAMAGES (INCLUDING, BUT NOT LIMITED TO, PROCUREMENT OF SUBSTITUTE GOODS OR SERVICES; LOSS OF 
+// USE, DATA, OR PROFITS; OR BUSINESS INTERRUPTION) HOWEVER CAUSED AND ON ANY THEORY OF LIABILITY, WHETHER IN CONTRACT, STRICT 
+// LIABILITY, OR TORT (INCLUDING NEGLIGENCE OR OTHERWISE) ARISING IN ANY WAY OUT OF THE USE OF THIS SOFTWARE, EVEN IF ADVISED 
+// OF THE POSSIBILITY OF SUCH DAMAGE.
+
+
+#include "Common.h"
+#include "Constants.h"
+#include "LineFlags.h"
+#include "Utility/Bits.h"
+
+#if defined(GCIX_SIMD_AVX2)
+#include <immintrin.h>
+#elif defined(GCIX_SIMD_SSE2)
+#include <emmintrin.h>
+#endif
+
+namespace gcix
+{
+	/**
+	Operations on a mask of lines of a block (one bit per line, 256 bits), used to find holes of free lines in a block with 
+	bit scans instead of visiting lines one by one.
+	*/
+	class LineMask
+	{
+	public:
+		/** Number of 32 bits words in a line mask */
+		static const uint32_t WordCount = Constants::LineCount / 32;
+
+		/**
+		Builds the mask of lines marked in the specified line flags and clears their marked bit.
+		@param lineFlags The @see LineFlags of a block (Constants::LineCount entries)
+		@param mask The mask receiving a bit set for each marked line
+		*/
+		static inline void ExtractMarkedLines(LineFlags* lineFlags, uint32_t* mask)
+		{
+			static_assert((uint8_t)LineFlags::Marked == 1, "LineFlags::Marked is expected to be the lowest bit");
+			auto flags = (uint8_t*)lineFlags;
+
+#if defined(GCIX_SIMD_AVX2)
+			auto clearMarked = _mm256_set1_epi8((char)~(uint8_t)LineFlags::Marked);
+			for (uint32_t i = 0; i < WordCount; i++)
+			{
+				auto value = _mm256_loadu_si256((__m256i*)(flags + i * 32));
+				// Move the marked bit of each byte to its sign bit
+				mask[i] = (uint32_t)_mm256_movemask_epi8(_mm256_slli_epi16(value, 7));
+				_mm256_storeu_si256((__m256i*)(flags + i * 32), _mm256_and_si256(value, clearMarked));
+			}
+#elif defined(GCIX_SIMD_SSE2)
+			auto clearMarked = _mm_set1_epi8((char)~(uint8_t)LineFlags::Marked);
+			for (uint32_t i = 0; i < WordCount; i++)
+			{
+				auto low = _mm_loadu_si128((__m128i*)(flags + i * 32));
+				auto high = _mm_loadu_si128((__m128i*)(flags + i * 32 + 16));
+				// Move the marked bit of each byte to its sign bit
+				mask[i] = (uint32_t)_mm_movemask_epi8(_mm_slli_epi16(low, 7)) | 
+					((uint32_t)_mm_movemask_epi8(_mm_slli_epi16(high, 7)) << 16);
+				_mm_storeu_si128((__m128i*)(flags + i * 32), _mm_and_si128(low, clearMarked));
+				_mm_storeu_si128((__m128i*)(flags + i * 32 + 16), _mm_and_si128(high, clearMarked));
+			}
+#else
+			for (uint32_t i = 0; i < WordCount; i++)
+			{
+				uint32_t value = 0;
+				for (uint32_t j = 0; j < 32; j++)
+				{
+					value |= (uint32_t)(flags[i * 32 + j] & (uint8_t)LineFlags::Marked) << j;
+					flags[i * 32 + j] &= ~(uint8_t)LineFlags::Marked;
+				}
+				mask[i] = value;
+			}
+#endif
+		}
+
+		/**
+		Finds the first hole of at least `lineCount` free lines (bits not set), starting at line `fromLine`.
+		@param mask The mask of used lines
+		@param fromLine The index of the first line to check
+		@param lineCount The minimum number of consecutive free lines expected
+		@param holeStart The index of the first free line of the hole found
+		@param holeEnd The index of the first used line after the hole found (or @see Constants::LineCount)
+		@return true if a hole was found
+		*/
+		static inline bool FindHole(const uint32_t* mask, uint32_t fromLine, uint32_t lineCount, uint32_t& holeStart, 
+			uint32_t& holeEnd)
+		{
+			auto line = fromLine;
+			while (line < Constants::LineCount)
+			{
+				line = NextFreeLine(mask, line);
+				if (line == Constants::LineCount)
+				{
+					break;
+				}
+				auto end = NextUsedLine(mask, line);
+				if (end - line >= lineCount)
+				{
+					holeStart = line;
+					holeEnd = end;
+					return true;
+				}
+				line = end;
+			}
+			return false;
+		}
+
+		/**
+		Returns the index of the first used line (bit set) at or after the specified line, or @see Constants::LineCount.
+		*/
+		static inline uint32_t NextUsedLine(const uint32_t* mask, uint32_t line)
+		{
+			auto wordIndex = line >> 5;
+			auto bits = mask[wordIndex] & (~0u << (line & 31));
+			while (bits == 0)
+			{
+				if (++wordIndex == WordCount)
+				{
+					return Constants::LineCount;
+				}
+				bits = mask[wordIndex];
+			}
+			return (wordIndex << 5) + Bits::TrailingZeroCount(bits);
+		}
+
+		/**
+		Returns the index of the first free line (bit not set) at or after the specified line, or @see Constants::LineCount.
+		*/
+		static inline uint32_t NextFreeLine(const uint32_t* mask, uint32_t line)
+		{
+			auto wordIndex = line >> 5;
+			auto bits = ~mask[wordIndex] & (~0u << (line & 31));
+			while (bits == 0)
+			{
+				if (++wordIndex == WordCount)
+				{
+					return Constants::LineCount;
+				}
+				bits = ~mask[wordIndex];
+			}
+			return (wordIndex << 5) + Bits::TrailingZeroCount(bits);
+		}
+
+		/**
+		Returns the number of used lines (bits set) in the specified mask.
+		*/
+		static inline uint32_t CountLines(const uint32_t* mask)
+		{
+			uint32_t count = 0;
+			for (uint32_t i = 0; i < WordCount; i++)
+			{
+				count += Bits::PopCount(mask[i]);
+			}
+			return count;
+		}
+
+		/**
+		Returns the number of used lines that are following another used line in the specified mask.
+		*/
+		static inline uint32_t CountConsecutiveLines(const uint32_t* mask)
+		{
+			uint32_t count = 0;
+			uint32_t carry = 0;
+			for (uint32_t i = 0; i < WordCount; i++)
+			{
+				count += Bits::PopCount(mask[i] & ((mask[i] << 1) | carry));
+				carry = mask[i] >> 31;
+			}
+			return count;
+		}
+
+	private:
+		LineMask() {}
+	};
+}
@@ -0,0 +1,513 @@
+﻿// Copyright (c) 2014, Alexandre Mutel
+// All rights reserved.
+// 
+// Redistribution and use in source and binary forms, with or without modification, are permitted provided that the following  
+// conditions are met:
+// 
+// 1. Redistributions of source code must retain the above copyright notice, this list of conditions and the following 
+//    disclaimer.
+// 
+// 2. Redistributions in binary form must reproduce the above copyright notice, this list of conditions and the following 
+//    disclaimer in the documentation and/or other materials provided with the distribution.
+// 
+// THIS SOFTWARE IS PROVIDED BY THE COPYRIGHT HOLDERS AND CONTRIBUTORS "AS IS" AND ANY EXPRESS OR IMPLIED WARRANTIES, 
+// INCLUDING, BUT NOT LIMITED TO, THE IMPLIED WARRANTIES OF MERCHANTABILITY AND FITNESS FOR A PARTICULAR PURPOSE ARE 
+// DISCLAIMED. IN NO EVENT SHALL THE COPYRIGHT HOLDER OR CONTRIBUTORS BE LIABLE FOR ANY DIRECT, INDIRECT, INCIDENTAL, SPECIAL, 
+// EXEMPLARY, OR CONSEQUENTIAL DAMAGES (INCLUDING, BUT NOT LIMITED TO, PROCUREMENT OF SUBSTITUTE GOODS OR SERVICES; LOSS OF 
+// USE, DATA, OR PROFITS; OR BUSINESS INTERRUPTION) HOWEVER CAUSED AND ON ANY THEORY OF LIABILITY, WHETHER IN CONTRACT, STRICT 
+// LIABILITY, OR TORT (INCLUDING NEGLIGENCE OR OTHERWISE) ARISING IN ANY WAY OUT OF THE USE OF THIS SOFTWARE, EVEN IF ADVISED 
+// OF THE POSSIBILITY OF SUCH DAMAGE.
+
+#include "gcix.h"
+
+#include "Marker.h"
+#include "GlobalAllocator.h"
+#include "Tracer.h"
+
+namespace gcix
+{
+	MarkerWorker::MarkerWorker(Marker* owner, int32_t index, DefaultSequentialStoreBufferAllocator* allocator) :
+		Owner(owner),
+		Index(index),
+		Overflow(allocator),
+		WorkerThread(nullptr),
+		EvacuationBlock(nullptr),
+		EvacuationFailed(false)
+	{
+		Visitor = Marker::Visit;
+	}
+
+	/**
+	Initialize the @see Marker::Instance variable.
+	*/
+	void Marker::Initialize()
+	{
+		if (Instance == nullptr)
+		{
+			int32_t workerCount = GCIX_MARKER_THREAD_COUNT;
+			if (workerCount <= 0)
+			{
+				workerCount = Thread::GetProcessorCount();
+			}
+			Instance = new Marker(workerCount);
+		}
+	}
+
+	Marker::Marker(int32_t workerCountArg) :
+		workerCount(workerCountArg),
+		overflowAllocator(64),
+		activeWorkerCount(0),
+		pendingWorkerCount(0),
+		task(nullptr),
+		taskContext(nullptr),
+		exiting(false),
+		concurrentThread(nullptr)
+	{
+		gcix_assert(workerCount > 0);
+
+		workers = (MarkerWorker**)Memory::Allocate(sizeof(MarkerWorker*) * workerCount);
+		for (int32_t i = 0; i < workerCount; i++)
+		{
+			workers[i] = new MarkerWorker(this, i, &overflowAllocator);
+		}
+
+		// The first worker is running on the collecting thread
+		for (int32_t i = 1; i < workerCount; i++)
+		{
+			workers[i]->WorkerThread = new Thread(WorkerRun, workers[i]);
+		}
+	}
+
+	Marker::~Marker()
+	{
+		exiting = true;
+		if (concurrentThread != nullptr)
+		{
+			concurrentStartEvent.Set();
+			concurrentThread->Join();
+			delete concurrentThread;
+		}
+
+		for (int32_t i = 1; i < workerCount; i++)
+		{
+			workers[i]->StartEvent.Set();
+			workers[i]->WorkerThread->Join();
+			delete workers[i]->WorkerThread;
+		}
+
+		for (int32_t i = 0; i < workerCount; i++)
+		{
+			delete workers[i];
+		}
+		Memory::Free(workers);
+	}
+
+	void Marker::Prepare(bool sticky)
+	{
+		if (!sticky)
+		{
+			ObjectAddress::NextMarkState();
+		}
+
+		// Evacuation blocks of the previous trace have been recycled
+		for (int32_t i = 0; i < workerCount; i++)
+		{
+			workers[i]->EvacuationBlock = nullptr;
+			workers[i]->EvacuationFailed = false;
+		}
+	}
+
+#if (GCIX_ENABLE_RC == 1)
+	void Marker::CountReferences(bool enabled)
+	{
+		countingReferences = enabled;
+		for (int32_t i = 0; i < workerCount; i++)
+		{
+			workers[i]->Visitor = enabled ? VisitCounted : Visit;
+		}
+	}
+#endif
+
+	void Marker::Trace()
+	{
+		activeWorkerCount = workerCount;
+		pendingWorkerCount = workerCount - 1;
+
+		// Wake up worker threads. They will steal objects pushed to the collecting thread worker
+		if (workerCount > 1)
+		{
+			traceCompletedEvent.Reset();
+			for (int32_t i = 1; i < workerCount; i++)
+			{
+				workers[i]->StartEvent.Set();
+			}
+		}
+
+		Drain(workers[0]);
+
+		// Wait for all worker threads to go back to sleep before returning to the collector
+		if (workerCount > 1)
+		{
+			traceCompletedEvent.WaitOne();
+		}
+	}
+
+	void Marker::StartConcurrentTrace()
+	{
+		gcix_assert(!marking);
+
+		marking = true;
+		concurrentCompletedEvent.Reset();
+		if (concurrentThread == nullptr)
+		{
+			concurrentThread = new Thread(ConcurrentRun, this);
+		}
+		concurrentStartEvent.Set();
+	}
+
+	void Marker::CompleteConcurrentTrace()
+	{
+		gcix_assert(marking);
+
+		concurrentCompletedEvent.WaitOne();
+		marking = false;
+	}
+
+	void Marker::RunTask(WorkerTaskDelegate taskArg, void* context)
+	{
+		gcix_assert(taskArg != nullptr);
+
+		task = taskArg;
+		taskContext = context;
+		pendingWorkerCount = workerCount - 1;
+
+		if (workerCount > 1)
+		{
+			traceCompletedEvent.Reset();
+			for (int32_t i = 1; i < workerCount; i++)
+			{
+				workers[i]->StartEvent.Set();
+			}
+		}
+
+		task(context, 0);
+
+		if (workerCount > 1)
+		{
+			traceCompletedEvent.WaitOne();
+		}
+
+		task = nullptr;
+		taskContext = nullptr;
+	}
+
+	void Marker::Evacuate(ObjectAddress* object, intptr_t offset, void** reference, MarkerWorker* worker)
+	{
+		auto flags = (std::atomic<uint32_t>*)&object->ObjectFlags;
+		while (true)
+		{
+			auto value = flags->load(std::memory_order_acquire);
+
+			// Another worker is copying this object
+			if (value == ForwardObjectAddress::BusyFlags)
+			{
+				Thread::YieldExecution();
+				continue;
+			}
+
+			// The object has been copied, update the reference
+			if (value == ForwardObjectAddress::ForwardFlags)
+			{
+				auto newObject = ((ForwardObjectAddress*)object)->ForwardAddress();
+				*reference = (void*)((intptr_t)newObject->ToUserObject() + offset);
+				return;
+			}
+
+			// The object has been marked in place (pinned by a conservative reference, or not copied)
+			if ((value & ObjectFlags::MarkStateMask) == ObjectAddress::MarkState)
+			{
+				return;
+			}
+
+			gcix_assert((ObjectType)(value & ObjectFlags::ObjectTypeMask) == ObjectType::Standard);
+			auto markedValue = (value & ~ObjectFlags::MarkStateMask) | ObjectAddress::MarkState;
+
+			// No free block left, mark the object in place
+			if (worker->EvacuationFailed)
+			{
+				if (flags->compare_exchange_weak(value, markedValue))
+				{
+					Enqueue(object, worker);
+					return;
+				}
+				continue;
+			}
+
+			// Claim the object, other workers wait until it is forwarded
+			if (!flags->compare_exchange_weak(value, ForwardObjectAddress::BusyFlags))
+			{
+				continue;
+			}
+
+			auto size = (value & ObjectFlags::SizeMask) + ObjectConstants::HeaderTotalSizeInBytes;
+			auto copy = AllocateCopy(worker, size);
+			if (copy == nullptr)
+			{
+				flags->store(markedValue, std::memory_order_release);
+				Enqueue(object, worker);
+				return;
+			}
+
+			Memory::CopySmall(copy, object, size);
+			copy->ObjectFlags = markedValue;
+
+			// The original object is not an object anymore for conservative lookups
+			auto blockData = BlockData::FromAddress(object);
+			blockData->ClearObjectStart((uint32_t)((intptr_t)object - (intptr_t)blockData));
+
+			((ForwardObjectAddress*)object)->Initialize(copy);
+			*reference = (void*)((intptr_t)copy->ToUserObject() + offset);
+
+			Enqueue(copy, worker);
+			return;
+		}
+	}
+
+	StandardObjectAddress* Marker::AllocateCopy(MarkerWorker* worker, uint32_t size)
+	{
+		auto blockData = worker->EvacuationBlock;
+		auto copy = blockData != nullptr ? blockData->AllocateCopy(size) : nullptr;
+		while (copy == nullptr)
+		{
+			blockData = GlobalAllocator::Instance->RequestEvacuationBlock();
+			if (blockData == nullptr)
+			{
+				worker->EvacuationFailed = true;
+				return nullptr;
+			}
+			worker->EvacuationBlock = blockData;
+			copy = blockData->AllocateCopy(size);
+		}
+		return copy;
+	}
+
+	bool Marker::Pop(MarkerWorker* worker, ObjectAddress*& object)
+	{
+		if (worker->Queue.Pop(object))
+		{
+			return true;
+		}
+
+		// Move objects from the overflow stack back to the queue, so that they can be stolen by other workers
+		object = (ObjectAddress*)worker->Overflow.Pop();
+		if (object == nullptr)
+		{
+			return false;
+		}
+
+		for (int32_t i = 0; i < WorkStealingQueue<ObjectAddress*>::Capacity / 2; i++)
+		{
+			auto next = (ObjectAddress*)worker->Overflow.Pop();
+			if (next == nullptr || !worker->Queue.Push(next))
+			{
+				if (next != nullptr)
+				{
+					worker->Overflow.Push(next);
+				}
+				break;
+			}
+		}
+		return true;
+	}
+
+	bool Marker::Steal(MarkerWorker* worker, ObjectAddress*& object)
+	{
+		for (int32_t i = 1; i < workerCount; i++)
+		{
+			auto victim = workers[(worker->Index + i) % workerCount];
+			if (victim->Queue.Steal(object))
+			{
+				return true;
+			}
+		}
+		return false;
+	}
+
+	void Marker::Drain(MarkerWorker* worker)
+	{
+		gcix_trace_scope("Drain");
+
+		ObjectAddress* object;
+		while (true)
+		{
+			// Scan objects from the local mark stack first
+			while (Pop(worker, object))
+			{
+				Scan(object, worker);
+			}
+
+			if (Steal(worker, object))
+			{
+				Scan(object, worker);
+				continue;
+			}
+
+			// No more work locally and nothing to steal: this worker becomes idle. Tracing is completed when all workers 
+			// are idle, as only an active worker can push new objects.
+			activeWorkerCount--;
+			while (true)
+			{
+				if (activeWorkerCount.load() == 0)
+				{
+					return;
+				}
+
+				bool hasWork = false;
+				for (int32_t i = 0; i < workerCount; i++)
+				{
+					if (!workers[i]->Queue.IsEmpty())
+					{
+						hasWork = true;
+						break;
+					}
+				}
+
+				if (hasWork)
+				{
+					activeWorkerCount++;
+					if (Steal(worker, object))
+					{
+						Scan(object, worker);
+						break;
+					}
+					activeWorkerCount--;
+				}
+
+				Thread::YieldExecution();
+			}
+		}
+	}
+
+	void Marker::WorkerRun(void* context)
+	{
+		auto worker = (MarkerWorker*)context;
+		auto marker = worker->Owner;
+		while (true)
+		{
+			worker->StartEvent.WaitOne();
+			worker->StartEvent.Reset();
+			if (marker->exiting)
+			{
+				return;
+			}
+
+			if (marker->task != nullptr)
+			{
+				marker->task(marker->taskContext, worker->Index);
+			}
+			else
+			{
+				marker->Drain(worker);
+			}
+
+			if (--marker->pendingWorkerCount == 0)
+			{
+				marker->traceCompletedEvent.Set();
+			}
+		}
+	}
+
+#if (GCIX_ENABLE_CARD_TABLE == 1)
+	/* Context of the visitor of the references stored in the dirty cards of a large object */
+	struct CardVisitorContext : VisitorContext
+	{
+		LargeObjectAddress* Object;
+		uint8_t* Cards;
+	};
+
+	static void gcix_fastcall VisitDirtyCardReference(void** reference, VisitorContext* context)
+	{
+		auto cardContext = (CardVisitorContext*)context;
+		if (cardContext->Cards[cardContext->Object->GetCardIndex(reference)] != 0)
+		{
+			Marker::MarkReference(reference);
+		}
+	}
+
+	void Marker::RescanCards(LargeObjectAddress* object)
+	{
+		gcix_assert(object->IsMarked());
+
+		auto visitor = object->GetVisitor();
+		if (visitor == nullptr)
+		{
+			return;
+		}
+
+		auto cards = object->Cards();
+		auto inlineVisitor = (intptr_t)visitor;
+		if (inlineVisitor & 1)
+		{
+			// Skips the references of the clean cards
+			auto reference = (void**)object->ToUserObject() + 1;
+			auto end = reference + inlineVisitor / 2;
+			while (reference < end)
+			{
+				auto card = object->GetCardIndex(reference);
+				if (cards[card] != 0)
+				{
+					MarkReference(reference);
+					reference++;
+				}
+				else
+				{
+					auto nextCard = (intptr_t)object + ((card + 1) << Constants::CardBits);
+					reference += (nextCard - (intptr_t)reference + sizeof(void*) - 1) / sizeof(void*);
+				}
+			}
+		}
+		else
+		{
+			CardVisitorContext context;
+			context.Visitor = VisitDirtyCardReference;
+			context.Object = object;
+			context.Cards = cards;
+			visitor(object, &context);
+		}
+	}
+#endif
+
+	void Marker::ConcurrentRun(void* context)
+	{
+		auto marker = (Marker*)context;
+		while (true)
+		{
+			marker->concurrentStartEvent.WaitOne();
+			marker->concurrentStartEvent.Reset();
+			if (marker->exiting)
+			{
+				return;
+			}
+
+			{
+				gcix_trace_scope("ConcurrentMark");
+				marker->Trace();
+			}
+
+			// The objects logged and allocated by the mutators in the meantime are marked by the remark pause. The request is 
+			// made first, so that a remark pause already waiting for the trace clears it
+			GlobalAllocator::Instance->RequestCollect();
+			marker->concurrentCompletedEvent.Set();
+		}
+	}
+
+	std::atomic<bool> Marker::marking(false);
+
+#if (GCIX_ENABLE_RC == 1)
+	bool Marker::countingReferences = false;
+#endif
+
+	Marker* Marker::Instance;
+
+	uint32_t ObjectAddress::MarkState = ObjectFlags::MarkStateIncrement;
+}
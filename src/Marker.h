@@ -22,55 +22,334 @@
 #include "Common.h"
 #include "ObjectAddress.h"
 #include "BlockData.h"
+#include "Collections/WorkStealingQueue.h"
+#include "Collections/SequentialStoreBuffer.h"
+#include "Threading/Thread.h"
+#include "Threading/ManualResetEvent.h"
+
+#include <atomic>
 
 namespace gcix
 {
+	class Marker;
+
+	/**
+	A task run by all the workers of the marker, see @see Marker::RunTask.
+	@param context The context passed to @see Marker::RunTask
+	@param workerIndex The index of the worker running the task
+	*/
+	typedef void(*WorkerTaskDelegate)(void* context, int32_t workerIndex);
+
+	/**
+	State of a thread tracing the object graph. This context is passed to the visitor of objects, so that references 
+	visited are pushed to the mark stack of the worker instead of being visited recursively.
+	*/
+	struct MarkerWorker : VisitorContext
+	{
+		MarkerWorker(Marker* owner, int32_t index, DefaultSequentialStoreBufferAllocator* allocator);
+
+		/** The marker owning this worker */
+		Marker* Owner;
+
+		/** Index of this worker in the marker */
+		int32_t Index;
+
+		/** Objects marked but not yet scanned, that can be stolen by other workers */
+		WorkStealingQueue<ObjectAddress*> Queue;
+
+		/** Objects marked but not yet scanned, when the @see Queue is full */
+		DefaultSequentialStoreBufferHandle Overflow;
+
+		/** Event used to wake up the thread of this worker */
+		ManualResetEvent StartEvent;
+
+		/** Thread of this worker, null for the worker running on the collecting thread */
+		Thread* WorkerThread;
+
+		/** Free block receiving the objects evacuated by this worker */
+		BlockData* EvacuationBlock;
+
+		/** True if no free block is left to evacuate objects during the current trace */
+		bool EvacuationFailed;
+
+		gcix_overrides_new_delete();
+	};
+
 	/**
-	Use to mark object and recursively walk through the object graph to mark all objects.
+	Use to mark objects and walk through the object graph to mark all objects.
+	Objects are marked when they are pushed to an explicit mark stack, and their references are scanned later by one of the
+	marker workers. Workers steal objects from each other, so that tracing can use all the processors available and cannot
+	overflow the native stack on deep object graphs.
+	A full trace can run concurrently with the mutators (@see StartConcurrentTrace), on a background thread waking up the
+	workers. The mutators then log the references they overwrite (snapshot-at-the-beginning write barrier), that are 
+	marked during the remark pause, and the objects they allocate are marked by it as well (see 
+	@see GlobalAllocator::MarkAllocatedObjects). Objects are never evacuated by a concurrent trace.
+	Objects stored in blocks selected for evacuation (@see GlobalAllocator::SelectEvacuationBlocks) are copied to free 
+	blocks by the first worker reaching them through a reference, which is updated. The original object is replaced by a 
+	@see ForwardObjectAddress used to update the other references to it. Objects marked without a reference (e.g 
+	conservative references from the stacks) are pinned and never evacuated.
+	In RC mode (GCIX_ENABLE_RC), a trace also counts the references it visits from the objects it scans, and the objects
+	it marks in the lines they use (see @see CountReferences).
 	*/
 	class Marker
 	{
 	public:
 		/**
-		Visits and mark recursively the specified object.
+		Initialize the @see Marker::Instance variable.
+		*/
+		static void Initialize();
+
+		/**
+		Prepares a new trace of the object graph. For a full trace, all objects marked by a previous trace are seen as not 
+		marked after this call, without having to visit them (line marks are cleared while recycling blocks). For a sticky
+		trace, objects marked by a previous trace stay marked and only objects allocated since the last collection are 
+		traced. Must be called from the collecting thread before marking any object.
+		@param sticky true to prepare a sticky trace
+		*/
+		void Prepare(bool sticky);
+
+		/**
+		Marks the specified object and push it to the mark stack of the collecting thread. The references of the object are
+		only visited by a following call to @see Trace. The object is pinned: it is not evacuated by the current trace, so 
+		that objects found by conservative references must be marked before any call to @see MarkReference.
 		@param object A reference to a managed object.
 		*/
 		static inline void Mark(ObjectAddress* object)
 		{
-			VisitorContext context = { Marker::Mark };
-			Mark(object, &context);
+			Push(object, Instance->workers[0]);
 		}
 
+		/**
+		Marks the object stored in the specified reference and push it to the mark stack of the collecting thread. The 
+		object might be evacuated, in which case the reference is updated.
+		@param reference A reference to a user object, or to null.
+		*/
+		static inline void MarkReference(void** reference)
+		{
+			Visit(reference, Instance->workers[0]);
+		}
+
+		/**
+		Pushes an object already marked by a previous trace to the mark stack of the collecting thread, so that its 
+		references are visited again by a following call to @see Trace. Used by sticky traces to visit the old objects 
+		logged by the write barrier.
+		@param object A reference to a marked managed object.
+		*/
+		static inline void Rescan(ObjectAddress* object)
+		{
+			gcix_assert(object->IsMarked());
+			Enqueue(object, Instance->workers[0]);
+		}
+
+#if (GCIX_ENABLE_CARD_TABLE == 1)
+		/**
+		Marks the objects referenced from the dirty cards of a large object already marked by a previous trace, pushing 
+		them to the mark stack of the collecting thread. Used by sticky traces instead of @see Rescan for the large 
+		objects logged by the write barrier. The references of an object with an inline visitor are only read in the dirty
+		cards, the other ones are all visited but only the references stored in the dirty cards are marked.
+		@param object A marked large object.
+		*/
+		static void RescanCards(LargeObjectAddress* object);
+#endif
+
+#if (GCIX_ENABLE_RC == 1)
+		/**
+		Enables or disables the counting of references by the following traces. When enabled, the reference count of a 
+		standard object is incremented for each reference to it visited from a scanned object, and the count of its lines 
+		is incremented when it is marked. Must be called from the collecting thread before marking any object.
+		@param enabled true to count the references
+		*/
+		void CountReferences(bool enabled);
+
+		/**
+		Increments the reference count of the object referenced by the specified user object, if it is a standard object.
+		*/
+		static inline void CountReference(void* userObject)
+		{
+			auto object = ObjectAddress::FromUserObject(userObject);
+			if (object == nullptr)
+			{
+				return;
+			}
+#if (GCIX_ENABLE_INNER_OBJECT == 1)
+			if (object->IsInnerObject())
+			{
+				object = ((InnerObjectAddress*)object)->Parent();
+			}
+#endif
+			if (object->IsStandardObject())
+			{
+				object->IncrementReferenceCount();
+			}
+		}
+#endif
+
+		/**
+		Visits all objects pushed by @see Mark and mark recursively all objects reachable from them. Returns when the object
+		graph is completely marked. Must be called from the collecting thread.
+		*/
+		void Trace();
+
+		/**
+		Starts tracing the objects pushed by @see Mark on a background thread, returning immediately so that the mutators 
+		can be resumed. The write barrier logs the references overwritten by the mutators until 
+		@see CompleteConcurrentTrace, and the end of the trace requests a collection from the @see GlobalAllocator to 
+		perform the remark pause. Must be called from the collecting thread, after the stacks and the roots are marked.
+		*/
+		void StartConcurrentTrace();
+
+		/**
+		Waits for the end of the concurrent trace, and stops the logging of the write barrier. The references logged must 
+		then be marked and traced by @see Trace. Must be called from the collecting thread, while the mutators are stopped.
+		*/
+		void CompleteConcurrentTrace();
+
+		/**
+		Indicates whether a concurrent trace is running, in which case the write barrier must log the references 
+		overwritten by the mutators.
+		*/
+		static inline bool Marking()
+		{
+			return marking.load(std::memory_order_relaxed);
+		}
+
+		/**
+		Runs a task on all the workers, one call per worker, and returns when all the calls are completed. Used to split 
+		the work of a collection other than tracing across the worker threads. Must be called from the collecting thread.
+		@param task The task to run
+		@param context The context passed to the task
+		*/
+		void RunTask(WorkerTaskDelegate task, void* context);
+
+		/**
+		Gets the number of workers used to trace the object graph (including the collecting thread).
+		*/
+		inline int32_t WorkerCount() const
+		{
+			return workerCount;
+		}
+
+		static Marker* Instance;
 	private:
-		Marker() {}
+		gcix_overrides_new_delete();
+		friend struct MarkerWorker;
+
+		Marker(int32_t workerCount);
 
-		static /* gcix_noinline */ void gcix_fastcall Mark(ObjectAddress* object, VisitorContext* context)
+		~Marker();
+
+		/**
+		Visits a reference, marking the object it references and pushing it to the mark stack of the specified worker.
+		Used as the visitor delegate of @see MarkerWorker.
+		*/
+		static void gcix_fastcall Visit(void** reference, VisitorContext* context)
+		{
+			auto userObject = *reference;
+			if (userObject == nullptr)
+			{
+				return;
+			}
+
+			auto object = ObjectAddress::FromUserObject(userObject);
+			intptr_t offset = 0;
+
+#if (GCIX_ENABLE_INNER_OBJECT == 1)
+			// A reference to an inner object is updated relative to its parent object
+			if (object->IsInnerObject())
+			{
+				auto parent = ((InnerObjectAddress*)object)->Parent();
+				offset = (intptr_t)object - (intptr_t)parent;
+				object = parent;
+			}
+#endif
+
+			// Large objects are never moved. The type of an object being evacuated is ObjectType::Forward
+			if (object->IsLargeObject() || !BlockData::FromAddress(object)->Header.Info.Evacuating)
+			{
+				Push(object, (MarkerWorker*)context);
+				return;
+			}
+
+			Evacuate(object, offset, reference, (MarkerWorker*)context);
+		}
+
+#if (GCIX_ENABLE_RC == 1)
+		/**
+		Visits a reference and counts it. Used as the visitor delegate of @see MarkerWorker when counting references.
+		*/
+		static void gcix_fastcall VisitCounted(void** reference, VisitorContext* context)
 		{
-			// If object is null or already marked, return immediately
-			// We are not using any lock when performing IsMarked()/Mark() as immix is optimistically marking objects
-			// This avoid a high cost when marking object, as concurrent marking should not happen very often on the same 
-			// object at the same time
-			if (object == nullptr || object->IsMarked())
+			Visit(reference, context);
+			CountReference(*reference);
+		}
+#endif
+
+		/**
+		Marks the specified object in place and push it to the mark stack of the specified worker.
+		*/
+		static inline void Push(ObjectAddress* object, MarkerWorker* worker)
+		{
+			if (object == nullptr)
 			{
 				return;
 			}
-			// Mark the object
-			object->Mark();
 
 #if (GCIX_ENABLE_INNER_OBJECT == 1)
-			// Handle if it is a inner object, getting the parent object
+			// Handle if it is a inner object, getting the parent object. Inner objects are never marked themselves, as their
+			// mark state would not be advanced consistently with their parent object.
 			if (object->IsInnerObject())
 			{
-				// idem, check if marked/return or mark and process
 				object = ((InnerObjectAddress*)object)->Parent();
-				if (object->IsMarked())
-				{
-					return;
-				}
-				object->Mark();
 			}
 #endif
 
+			// If object is already marked, return immediately
+			// We are checking first without any atomic operation, as most references visited are already marked. The atomic
+			// TryMark() then guarantees that an object is scanned by only one worker.
+			if (object->IsMarked() || !object->TryMark())
+			{
+				return;
+			}
+
+#if (GCIX_ENABLE_RC == 1)
+			if (countingReferences && object->IsStandardObject())
+			{
+				BlockData::FromObject((StandardObjectAddress*)object)->IncrementLineCounts((StandardObjectAddress*)object);
+			}
+#endif
+
+			Enqueue(object, worker);
+		}
+
+		/**
+		Pushes a marked object to the mark stack of the specified worker.
+		*/
+		static inline void Enqueue(ObjectAddress* object, MarkerWorker* worker)
+		{
+			if (!worker->Queue.Push(object))
+			{
+				worker->Overflow.Push(object);
+			}
+		}
+
+		/**
+		Marks an object stored in a block being evacuated, copying it to the evacuation block of the worker if it is not 
+		yet marked, and updates the reference to the object if it has been copied.
+		*/
+		static gcix_noinline void Evacuate(ObjectAddress* object, intptr_t offset, void** reference, MarkerWorker* worker);
+
+		/**
+		Allocates the copy of an evacuated object in the evacuation block of the specified worker, requesting a free block
+		to the @see GlobalAllocator if needed.
+		@return the address of the copy or `nullptr` if there is no free block left
+		*/
+		static StandardObjectAddress* AllocateCopy(MarkerWorker* worker, uint32_t size);
+
+		/**
+		Scans the references of a marked object.
+		*/
+		static inline void Scan(ObjectAddress* object, MarkerWorker* worker)
+		{
 			// If this is a standard object, we need to mark the block.
 			if (object->IsStandardObject())
 			{
@@ -93,17 +372,83 @@ namespace gcix
 			{
 				inlineVisitor /= 2;
 				void** userObject = (void**)object->ToUserObject();
+#if (GCIX_ENABLE_RC == 1)
+				if (countingReferences)
+				{
+					for(int i = 0; i < inlineVisitor; i++)
+					{
+						userObject++;
+						VisitCounted(userObject, worker);
+					}
+					return;
+				}
+#endif
 				for(int i = 0; i < inlineVisitor; i++)
 				{
 					userObject++;
-					Mark(ObjectAddress::FromUserObject(*userObject), context);
+					Visit(userObject, worker);
 				}
 			}
 			else
 			{
-				// Visit recursively objects
-				visitor(object, context);
+				// Visit references, pushing them to the mark stack of the worker
+				visitor(object, worker);
 			}
 		}
+
+		/**
+		Pops the next object to scan from the local mark stack of the specified worker.
+		*/
+		static bool Pop(MarkerWorker* worker, ObjectAddress*& object);
+
+		/**
+		Tries to steal an object to scan from the other workers.
+		*/
+		bool Steal(MarkerWorker* worker, ObjectAddress*& object);
+
+		/**
+		Scans objects until there is no more object to scan in all workers.
+		*/
+		void Drain(MarkerWorker* worker);
+
+		/**
+		Entry point of the threads of workers.
+		*/
+		static void WorkerRun(void* context);
+
+		/**
+		Entry point of the thread running the concurrent traces.
+		*/
+		static void ConcurrentRun(void* context);
+
+		int32_t workerCount;
+		MarkerWorker** workers;
+		DefaultSequentialStoreBufferAllocator overflowAllocator;
+
+		/* Number of workers that are currently scanning or stealing objects */
+		std::atomic<int32_t> activeWorkerCount;
+
+		/* Number of worker threads that have not yet completed the current trace */
+		std::atomic<int32_t> pendingWorkerCount;
+
+		/* Task run by the workers instead of tracing, null while tracing */
+		WorkerTaskDelegate task;
+		void* taskContext;
+
+		ManualResetEvent traceCompletedEvent;
+		bool exiting;
+
+		/* Set from the start of a concurrent trace until its remark pause */
+		static std::atomic<bool> marking;
+
+#if (GCIX_ENABLE_RC == 1)
+		/* True if the current trace counts the references it visits, see @see CountReferences */
+		static bool countingReferences;
+#endif
+
+		/* Thread running the concurrent traces, created by the first one */
+		Thread* concurrentThread;
+		ManualResetEvent concurrentStartEvent;
+		ManualResetEvent concurrentCompletedEvent;
 	};
 }
\ No newline at end of file
@@ -24,6 +24,9 @@
 #include "ObjectConstants.h"
 #include "ObjectType.h"
 
+#include <atomic>
+#include <string.h>
+
 namespace gcix
 {
 	struct ObjectAddress;
@@ -34,9 +37,19 @@ namespace gcix
 	*/
 	typedef void (gcix_fastcall *ObjectVisitorDelegate)(ObjectAddress* object, VisitorContext* context);
 
+	/**
+	Delegate used to visit a reference stored in an object. The reference contains a pointer to a user object (or null), 
+	and is updated by the visitor if the object is moved by the collector.
+	*/
+	typedef void (gcix_fastcall *ReferenceVisitorDelegate)(void** reference, VisitorContext* context);
+
+	/**
+	Context passed to the @see ObjectVisitorDelegate of an object, that must call @see Visitor for each reference stored 
+	in the object.
+	*/
 	struct VisitorContext
 	{
-		ObjectVisitorDelegate Visitor;
+		ReferenceVisitorDelegate Visitor;
 	};
 
 	/**
@@ -46,20 +59,68 @@ namespace gcix
 	{
 		uint32_t ObjectFlags;
 
+		/**
+		Mark state (@see ObjectFlags::MarkStateMask bits) of an object marked by the current collection. This value is 
+		advanced at the beginning of each full collection, so that objects marked by the previous collections are seen as 
+		not marked without having to clear them. It cycles through the three values different from 
+		@see ObjectFlags::MarkStateNew, the state of newly allocated objects. Sticky collections keep the current mark 
+		state, so that objects marked by previous collections are seen as old objects and are not traced again.
+		*/
+		static uint32_t MarkState;
+
+		/**
+		Advances the @see MarkState. Must be called at the beginning of a full collection, before marking any object.
+		*/
+		static inline void NextMarkState()
+		{
+			MarkState += ObjectFlags::MarkStateIncrement;
+			if (MarkState == ObjectFlags::MarkStateNew)
+			{
+				MarkState = ObjectFlags::MarkStateIncrement;
+			}
+		}
+
 		/** 
 		Indicates whether the object is marked by the collector 
 		*/
 		inline bool IsMarked() const
 		{
-			return (int32_t)ObjectFlags < 0;
+			return (ObjectFlags & ObjectFlags::MarkStateMask) == MarkState;
 		}
 
 		/**
-		Indicates whether the object is marked by the collector
+		Indicates whether the object has been logged by the write barrier since the last collection
 		*/
 		inline bool IsStickyLogged() const
 		{
-			return (((uint8_t*)this)[4] & ObjectFlags::StickyLogHigh) != 0;
+			return (ObjectFlags & ObjectFlags::StickyLog) != 0;
+		}
+
+		/**
+		Indicates whether the write barrier must log this object: the object survived a collection (it is marked) and has
+		not been logged yet. Checked with a single comparison on the fast path of the write barrier.
+		*/
+		inline bool RequiresStickyLog() const
+		{
+			return (ObjectFlags & (ObjectFlags::MarkStateMask | ObjectFlags::StickyLog)) == MarkState;
+		}
+
+		/**
+		Atomically sets the sticky log bit of this object.
+		@return true if this object was logged by this call, false if it was already logged
+		*/
+		inline bool TryStickyLog()
+		{
+			auto flags = (std::atomic<uint32_t>*)&ObjectFlags;
+			return (flags->fetch_or(ObjectFlags::StickyLog) & ObjectFlags::StickyLog) == 0;
+		}
+
+		/**
+		Clears the sticky log bit of this object.
+		*/
+		inline void ClearStickyLog()
+		{
+			ObjectFlags &= ~ObjectFlags::StickyLog;
 		}
 
 		/** 
@@ -67,7 +128,7 @@ namespace gcix
 		*/
 		inline void UnMark()
 		{
-			((uint8_t*)this)[4] &= ~ObjectFlags::MarkedHigh;
+			ObjectFlags = (ObjectFlags & ~ObjectFlags::MarkStateMask) | ObjectFlags::MarkStateNew;
 		}
 
 		/** 
@@ -75,9 +136,78 @@ namespace gcix
 		*/
 		inline void Mark()
 		{
-			((uint8_t*)this)[4] |= ObjectFlags::MarkedHigh;
+			ObjectFlags = (ObjectFlags & ~ObjectFlags::MarkStateMask) | MarkState;
+		}
+
+		/**
+		Atomically mark this object.
+		@return true if this object was marked by this call, false if it was already marked
+		*/
+		inline bool TryMark()
+		{
+			auto flags = (std::atomic<uint32_t>*)&ObjectFlags;
+			auto value = flags->load();
+			uint32_t markedValue;
+			do
+			{
+				if ((value & ObjectFlags::MarkStateMask) == MarkState)
+				{
+					return false;
+				}
+				markedValue = (value & ~ObjectFlags::MarkStateMask) | MarkState;
+#if (GCIX_ENABLE_RC == 1)
+				// The references to an object marked by a full trace are counted again
+				if ((value & ObjectFlags::ObjectTypeMask) == (uint32_t)ObjectType::Standard)
+				{
+					markedValue &= ~ObjectFlags::ReferenceCountMask;
+				}
+#endif
+			} while (!flags->compare_exchange_weak(value, markedValue));
+			return true;
+		}
+
+#if (GCIX_ENABLE_RC == 1)
+		/**
+		Gets the number of references to this standard object counted since it has been marked.
+		*/
+		inline uint32_t ReferenceCount() const
+		{
+			return (ObjectFlags & ObjectFlags::ReferenceCountMask) / ObjectFlags::ReferenceCountIncrement;
 		}
 
+		/**
+		Atomically increments the reference count of this standard object, unless it is saturated.
+		*/
+		inline void IncrementReferenceCount()
+		{
+			auto flags = (std::atomic<uint32_t>*)&ObjectFlags;
+			auto value = flags->load();
+			do
+			{
+				if ((value & ObjectFlags::ReferenceCountMask) == ObjectFlags::ReferenceCountMask)
+				{
+					return;
+				}
+			} while (!flags->compare_exchange_weak(value, value + ObjectFlags::ReferenceCountIncrement));
+		}
+
+		/**
+		Decrements the reference count of this standard object, unless it is saturated or zero. Only called by the 
+		collecting thread once the trace is completed.
+		@return true if the count dropped to zero
+		*/
+		inline bool DecrementReferenceCount()
+		{
+			auto count = ObjectFlags & ObjectFlags::ReferenceCountMask;
+			if (count == 0 || count == ObjectFlags::ReferenceCountMask)
+			{
+				return false;
+			}
+			ObjectFlags -= ObjectFlags::ReferenceCountIncrement;
+			return count == ObjectFlags::ReferenceCountIncrement;
+		}
+#endif
+
 		/** 
 		Type of an object 
 		*/
@@ -118,7 +248,7 @@ namespace gcix
 		*/
 		inline bool IsForward() const
 		{
-			return ObjectFlags == (ObjectFlags::Marked | (uint32_t)ObjectType::Forward);
+			return ObjectFlags == (ObjectFlags::MarkStateMask | (uint32_t)ObjectType::Forward);
 		}
 
 		/**
@@ -147,6 +277,45 @@ namespace gcix
 			return *(ObjectVisitorDelegate*)((intptr_t)GetClassDescriptor() + ObjectConstants::OffsetToVisitorFromVTBL);
 		}
 
+		/**
+		Visits the references stored in this object with the visitor of the specified context. An inline visitor (odd 
+		value) is the number of references following the class descriptor, times 2 plus 1. Objects without visitor are
+		pointer free.
+		*/
+		inline void VisitReferences(VisitorContext* context)
+		{
+			auto visitor = GetVisitor();
+			if (visitor == nullptr)
+			{
+				return;
+			}
+
+			auto inlineVisitor = (intptr_t)visitor;
+			if (inlineVisitor & 1)
+			{
+				auto references = (void**)ToUserObject() + 1;
+				for (intptr_t i = 0; i < inlineVisitor / 2; i++)
+				{
+					context->Visitor(&references[i], context);
+				}
+			}
+			else
+			{
+				visitor(this, context);
+			}
+		}
+
+		/**
+		Checks that the visitor of a class descriptor is either a visitor function or an inline visitor whose references 
+		fit into an object of the specified size. A visitor function placed at an odd address (see gcix_visitor) is read
+		as an inline visitor with a huge number of references and fails this check.
+		*/
+		static inline bool IsValidClassDescriptor(void* classDescriptor, uint32_t sizeInBytes)
+		{
+			auto visitor = *(intptr_t*)((intptr_t)classDescriptor + ObjectConstants::OffsetToVisitorFromVTBL);
+			return (visitor & 1) == 0 || (uintptr_t)visitor / 2 < sizeInBytes / sizeof(void*);
+		}
+
 		/**
 		Gets the @see ObjectAddress from a user object reference
 		*/
@@ -167,7 +336,7 @@ namespace gcix
 		*/
 		inline void Initialize(size_t size)
 		{
-			ObjectFlags = (uint32_t)ObjectType::Standard | size;
+			ObjectFlags = (uint32_t)ObjectType::Standard | size | ObjectFlags::MarkStateNew;
 		}
 
 		/** 
@@ -231,7 +400,8 @@ namespace gcix
 		*/
 		inline void Initialize(size_t size)
 		{
-			ObjectFlags = (uint32_t)ObjectType::Large | ((size / 4) & ObjectFlags::LargeSizeAndInnerObjectOffsetMask);
+			ObjectFlags = (uint32_t)ObjectType::Large | ((size / 4) & ObjectFlags::LargeSizeAndInnerObjectOffsetMask) | 
+				ObjectFlags::MarkStateNew;
 		}
 
 		/** 
@@ -253,6 +423,64 @@ namespace gcix
 			auto objectSize = ((ObjectFlags & ObjectFlags::LargeSizeAndInnerObjectOffsetMask) << 2);				
 			return objectSize;
 		}
+
+#if (GCIX_ENABLE_CARD_TABLE == 1)
+		/**
+		Number of cards of this large object. The cards are stored at the end of its memory, one byte per card covering
+		the bytes before them.
+		*/
+		inline uint32_t CardCount() const
+		{
+			return (Size() + Constants::CardSizeInBytes) / (Constants::CardSizeInBytes + 1);
+		}
+
+		/**
+		Gets the cards of this large object, a card is not zero when a reference has been stored into it since the last 
+		collection (see @see DirtyCards).
+		*/
+		inline uint8_t* Cards() const
+		{
+			return (uint8_t*)this + Size() - CardCount();
+		}
+
+		/**
+		Gets the index of the card containing the specified address of this object.
+		*/
+		inline intptr_t GetCardIndex(const void* address) const
+		{
+			return ((intptr_t)address - (intptr_t)this) >> Constants::CardBits;
+		}
+
+		/**
+		Dirties the cards of the specified consecutive slots of this object, or all its cards if the slots are unknown.
+		@param slots The first slot, or null
+		@param count The number of slots
+		*/
+		inline void DirtyCards(void** slots, size_t count)
+		{
+			auto cards = Cards();
+			if (slots == nullptr)
+			{
+				memset(cards, 1, CardCount());
+				return;
+			}
+
+			gcix_assert(count > 0);
+			auto lastCard = GetCardIndex(slots + count - 1);
+			for (auto card = GetCardIndex(slots); card <= lastCard; card++)
+			{
+				cards[card] = 1;
+			}
+		}
+
+		/**
+		Cleans all the cards of this object.
+		*/
+		inline void CleanCards()
+		{
+			memset(Cards(), 0, CardCount());
+		}
+#endif
 	};
 
 #if (GCIX_ENABLE_INNER_OBJECT == 1)
@@ -286,23 +514,34 @@ namespace gcix
 	*/
 	struct ForwardObjectAddress : ObjectAddress
 	{
+		/**
+		Flags of an object forwarded to another object
+		*/
+		static const uint32_t ForwardFlags = ObjectFlags::MarkStateMask | (uint32_t)ObjectType::Forward;
+
+		/**
+		Flags of an object being copied by the collector, until its flags are replaced by @see ForwardFlags
+		*/
+		static const uint32_t BusyFlags = ObjectFlags::StickyLog | (uint32_t)ObjectType::Forward;
+
 		/** 
-		Initialize this object with a forward reference
-		@param size size of this large object
+		Initialize this object with a forward reference. The forward address is published before the flags, so that a
+		thread reading the @see ForwardFlags with an acquire load can read the forward address.
+		@param newObject the object this object has been copied to
 		*/
 		inline void Initialize(ObjectAddress* newObject)
 		{
-			ObjectFlags = (ObjectFlags::Marked | (uint32_t)ObjectType::Forward);
-			ForwardAddress() = newObject;
+			*(ObjectAddress**)ToUserObject() = newObject;
+			((std::atomic<uint32_t>*)&ObjectFlags)->store(ForwardFlags, std::memory_order_release);
 		}
 
 		/**
-		Returns the Forward address for this object 
+		Returns the Forward address for this object, stored at the beginning of the user object
 		*/
 		inline ObjectAddress*& ForwardAddress() const
 		{
 			gcix_assert(IsForward());
-			return ((ObjectAddress**)this)[1];
+			return *(ObjectAddress**)ToUserObject();
 		}
 	};
 }
\ No newline at end of file
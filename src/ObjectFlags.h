@@ -28,7 +28,8 @@ namespace gcix
 	ObjectFlags are stored at ObjectFlags::ObjectHeaderOffset bytes before the address of an object.
 	Unlike original Immix paper that was using only 1 byte, we are using 4 bytes, to leverage on alignment
 	and to store additional information that will avoid to go through a type descriptor for some basic ops:
-	- We store the Marked flag, used by the Mark GC pass
+	- We store the mark state, used by the Mark GC pass
+	- We store the StickyLog flag, used by the write barrier of sticky collections
 	- We store the InnerObject flag, used to identify inner object inside a container object
 	- If InnerObject is set, the InnerObjectOffset contains the offset relative to the start of the container object
 	- We store the size (instead of having to query the object descriptor when we need to move the object)
@@ -42,11 +43,11 @@ namespace gcix
 	For Little Endian:                      0
 	|                                       | <- Object Address
 	|   -4    |   -3    |   -2    |   -1    |
-	|SSSS SSTT|SSSS SSSS|SSSS SSSS|MSSS SSSS|
+	|SSSS SSTT|SSSS SSSS|SSSS SSSS|MMLS SSSS|
 	For Big Endian:                         |
 	|                                       | 
 	|   -4    |   -3    |   -2    |   -1    |
-	|MIWS SSSS|SSSS SSSS|SSSS SSSS|SSSS SSLF|
+	|MMLS SSSS|SSSS SSSS|SSSS SSSS|SSSS SSTT|
 	*/
 	class ObjectFlags
 	{
@@ -58,18 +59,22 @@ namespace gcix
 		static const uint32_t ObjectTypeMask = 0x00000003;
 
 		/** 
-		Marked bit (M) 
+		Mark state bits (M) 
+		An object is marked when its mark state is equal to the current mark state, that is advanced on each full 
+		collection (see @see ObjectAddress::MarkState). Newly allocated objects have the MarkStateNew state, which is never
+		the current mark state, so that they are seen as not marked by both full and sticky collections.
 		*/
-		static const uint8_t  MarkedHigh = 0x80; 
-		static const uint32_t Marked      = 0x80000000; // Caution, the marker bit is always expected to be at this position
-														// as we are relying on the last bit to use a signed comparison
+		static const uint8_t  MarkStateHigh = 0xC0;
+		static const uint32_t MarkStateMask = 0xC0000000;
+		static const uint32_t MarkStateNew = 0x00000000;
+		static const uint32_t MarkStateIncrement = 0x40000000;
 
 		/**
 		Sticky log bit (L) use to mark objects that have their references changes since last small collection, used when
 		generational sticky collection.
 		*/
-		static const uint8_t  StickyLogHigh = 0x40;
-		static const uint32_t StickyLog = 0x40000000;
+		static const uint8_t  StickyLogHigh = 0x20;
+		static const uint32_t StickyLog = 0x20000000;
 
 		/** 
 		Size Mask bits (S)
@@ -78,12 +83,21 @@ namespace gcix
 		*/
 		static const uint32_t SizeMask    = ((Constants::BlockSizeInBytes >> 2) - 1) << 2; // 0x1FFC 
 
+		/**
+		Reference count bits of a standard object, above its size (GCIX_ENABLE_RC)
+		The count of references from old objects saturates at ReferenceCountMask: the object is then only collected by a
+		full collection, that recomputes the counts.
+		*/
+		static const uint32_t ReferenceCountMask = 0x000F0000;
+		static const uint32_t ReferenceCountIncrement = 0x00010000;
+		static_assert((SizeMask & ReferenceCountMask) == 0, "ReferenceCountMask must not overlap SizeMask");
+
 		/**
 		Large Size Mask bits (S)
 		The size is stored as a multiple of 16 bytes 
 		(objects are allocated on a 16 bytes boundary)
 		*/
-		static const uint32_t LargeSizeAndInnerObjectOffsetMask = ~(Marked | StickyLog | ObjectTypeMask);
+		static const uint32_t LargeSizeAndInnerObjectOffsetMask = ~(MarkStateMask | StickyLog | ObjectTypeMask);
 	private:
 		ObjectFlags(){}
 	};
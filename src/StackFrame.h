@@ -20,6 +20,9 @@
 // OF THE POSSIBILITY OF SUCH DAMAGE.
 
 #include "Common.h"
+#include "Threading/Thread.h"
+
+#include <setjmp.h>
 
 namespace gcix
 {
@@ -28,17 +31,42 @@ namespace gcix
 	public:
 		StackFrame() : bottomOfStack(nullptr), topOfStack(nullptr) {}
 
+		/** Size in bytes of the registers of the thread stored by setjmp */
+		static const size_t RegisterSizeInBytes = sizeof(jmp_buf);
+		static_assert(RegisterSizeInBytes % sizeof(void*) == 0, "jmp_buf must be made of pointer sized words");
+
+		/** Number of pointer sized words used to store the registers of the thread */
+		static const size_t RegisterCount = RegisterSizeInBytes / sizeof(void*);
+
+		/**
+		Initialize the bottom of the stack of the calling thread, so that the frames of all its callers are scanned.
+		*/
 		inline void Initialize()
 		{
-			bottomOfStack = GetCurrentStack();
+			bottomOfStack = Thread::GetStackBase();
+			if (bottomOfStack == nullptr)
+			{
+				bottomOfStack = GetCurrentStack();
+			}
 		}
 
 		template<typename T>
 		gcix_noinline void Capture(T* context)
+		{
+			Capture();
+			context->StackCallback();
+		}
+
+		/**
+		Captures the top of the stack and the registers of the calling thread.
+		*/
+		gcix_noinline void Capture()
 		{
 			gcix_assert(bottomOfStack != nullptr);
+
+			// Spill the registers, so that references only held by registers are scanned along the stack
+			setjmp(registers);
 			topOfStack = GetCurrentStack();
-			context->StackCallback();
 		}
 
 		inline void* GetBottomOfStack() const
@@ -50,16 +78,35 @@ namespace gcix
 		{
 			return topOfStack;
 		}
+
+		/**
+		Sets the top of the stack of a thread suspended asynchronously.
+		*/
+		inline void SetTopOfStack(void* top)
+		{
+			topOfStack = top;
+		}
+
+		/**
+		Gets the registers captured with the stack (@see RegisterCount words).
+		*/
+		inline void** GetRegisters()
+		{
+			return (void**)&registers;
+		}
 	private:
 		gcix_disable_new_delete_operator();
 
 		inline void* GetCurrentStack() const
 		{
+			// The address is copied to a volatile, as compilers are allowed to return null for the address of a local
 			volatile int stackHere = 0;
-			return (void*)&stackHere;
+			void* volatile address = (void*)&stackHere;
+			return address;
 		}
 
 		void* bottomOfStack;
 		void* topOfStack;
+		jmp_buf registers;
 	};
 }
\ No newline at end of file
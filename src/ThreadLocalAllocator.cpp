@@ -31,6 +31,9 @@ namespace gcix
 		gcix_assert(GlobalAllocator::Instance != nullptr);
 		gcix_assert(classDescriptor != nullptr);
 		gcix_assert(sizeInBytes > 0 && sizeInBytes <= ObjectConstants::MaxObjectSizePerBlock);
+		gcix_assert(ObjectAddress::IsValidClassDescriptor(classDescriptor, sizeInBytes));
+
+		RuntimeScope scope(this);
 
 		// Align to 4 bytes
 		sizeInBytes = Memory::Align(sizeInBytes, 4);
@@ -41,149 +44,147 @@ namespace gcix
 
 		// Start with current block handler
 		BlockData** pBlockData = &current;
-		bool requestOverflow = false;
 
 		while (true)
 		{
 			BlockData* blockData = *pBlockData;
 
-			// If no block allocated yet, we have to allocate a new one
-			if (!blockData)
-			{
-				goto allocateBlock;
-			}
-
-			// Calculate the line index
-			uint32_t& bumpCursor = blockData->Header.Info.BumpCursor;
-			uint32_t& bumpCursorLimit = blockData->Header.Info.BumpCursorLimit;
-
-			// Next position
-			uint32_t bumpCursorEnd = bumpCursor + totalSizeInBytes;
-
-			// ------------------------------------------------
-			// If we cannot allocate into the current block
-			// we have to allocate into new one
-			// ------------------------------------------------
-			if (bumpCursorEnd & Constants::BlockSizeInBytesInverseMask)
-			{
-				goto allocateBlock;
-			}
-
-			// ------------------------------------------------
-			// Recyclable block, try to find a hole
-			// ------------------------------------------------
-			if (blockData->IsRecyclable() && bumpCursorEnd > bumpCursorLimit)
+			// If no block allocated yet, we have to allocate a new one. The allocation into the current block is 
+			// scoped, so that jumping to the allocation of a new block doesn't skip the initialization of its variables
+			if (blockData != nullptr)
 			{
-				// If we are trying to allocate a medium object and a current hole exist but is not enough large,
-				// then switch to overflow block handler
-				if (isMediumSizedObject && bumpCursorLimit)
+				// Calculate the line index
+				uint32_t& bumpCursor = blockData->Header.Info.BumpCursor;
+				uint32_t& bumpCursorLimit = blockData->Header.Info.BumpCursorLimit;
+
+				// Next position
+				uint32_t bumpCursorEnd = bumpCursor + totalSizeInBytes;
+
+				// ------------------------------------------------
+				// If we cannot allocate into the current block
+				// we have to allocate into new one
+				// ------------------------------------------------
+				if (bumpCursorEnd & Constants::BlockSizeInBytesInverseMask)
 				{
-					pBlockData = &overflow;
-					continue;
+					// A medium object that doesn't fit at the end of a recyclable block goes to the overflow block 
+					// handler, instead of skipping the next recyclable blocks
+					if (isMediumSizedObject && pBlockData != &overflow)
+					{
+						pBlockData = &overflow;
+						continue;
+					}
+					goto allocateBlock;
 				}
 
-				uint32_t newCursorLineIndex = 0;
-				uint32_t newCursorLimitLineIndex = 0;
-
-				// Number of lines we are expecting to find
-				uint32_t expectedLineCounts = (totalSizeInBytes + Constants::LineSizeInBytes - 1) >> Constants::LineBits;
-
-				// The indexo of the first line we are going to try to find a range of free lines
-				uint32_t newLineIndex = (bumpCursorLimit ?
-					(bumpCursorLimit + 1) :
-					bumpCursor) >> Constants::LineBits;
-
-				// Find a hole
-				auto pFlags = blockData->Header.LineFlags;
-				for (uint32_t i = newLineIndex; i < Constants::LineCount; i++)
+				// ------------------------------------------------
+				// Recyclable block, try to find a hole
+				// ------------------------------------------------
+				if (blockData->IsRecyclable() && bumpCursorEnd > bumpCursorLimit)
 				{
-					LineFlags& lineFlags = pFlags[i];
-					if ((lineFlags & LineFlags::Marked) != 0)
+					// If we are trying to allocate a medium object and a current hole exist but is not enough large,
+					// then switch to overflow block handler
+					if (isMediumSizedObject && bumpCursorLimit)
 					{
-						if (newCursorLineIndex > 0 && expectedLineCounts <= (i - newCursorLineIndex))
-						{
-							newCursorLimitLineIndex = i;
-							goto holeFound;
-						}
-						newCursorLineIndex = 0;
+						pBlockData = &overflow;
+						continue;
 					}
-					else
+
+					uint32_t newCursorLineIndex;
+					uint32_t newCursorLimitLineIndex;
+
+					// Number of lines we are expecting to find
+					uint32_t expectedLineCounts = 
+						(totalSizeInBytes + Constants::LineSizeInBytes - 1) >> Constants::LineBits;
+
+					// The indexo of the first line we are going to try to find a range of free lines
+					uint32_t newLineIndex = (bumpCursorLimit ?
+						(bumpCursorLimit + 1) :
+						bumpCursor) >> Constants::LineBits;
+
+					// Find a hole
+					if (!LineMask::FindHole(blockData->Header.Info.UsedLines, newLineIndex, expectedLineCounts, 
+						newCursorLineIndex, newCursorLimitLineIndex))
 					{
-						if (newCursorLineIndex == 0)
+						// For Medium Object, If first allocation into a hole fails, switch to overflow block handler
+						if (isMediumSizedObject)
 						{
-							newCursorLineIndex = i;
+							pBlockData = &overflow;
+							continue;
 						}
-						// Clear line flags
-						lineFlags = LineFlags::Empty;
-					}
-				}
-				// If we can fit 
-				if (newCursorLineIndex > 0 &&
-					(expectedLineCounts <= (Constants::LineCount - newCursorLineIndex)))
-				{
-					newCursorLimitLineIndex = Constants::LineCount;
-				}
-				else
-				{
-					// For Medium Object, If first allocation into a hole fails, switch to overflow block handler
-					if (isMediumSizedObject)
-					{
-						pBlockData = &overflow;
-						continue;
+
+						// If we can't find a hole into the current block, we have to allocate a new block
+						goto allocateBlock;
 					}
 
-					// If we can't find a hole into the current block, we have to allocate a new block
-					goto allocateBlock;
+					bumpCursor = newCursorLineIndex << Constants::LineBits;
+					bumpCursorLimit = newCursorLimitLineIndex << Constants::LineBits;
 				}
-			holeFound:
-				bumpCursor = newCursorLineIndex << Constants::LineBits;
-				bumpCursorLimit = newCursorLimitLineIndex << Constants::LineBits;
-			}
 
-			// ------------------------------------------------
-			//  Bump allocation
-			// ------------------------------------------------
-			StandardObjectAddress* object = (StandardObjectAddress*)((intptr_t)blockData->Lines + bumpCursor);
-			uint8_t offsetInLine = bumpCursor & Constants::LineSizeInBytesMask;
-			uint32_t lineIndex = bumpCursor >> Constants::LineBits;
-			LineFlags& lineFlags = blockData->Header.LineFlags[lineIndex];
+				// ------------------------------------------------
+				//  Bump allocation
+				// ------------------------------------------------
+				StandardObjectAddress* object = (StandardObjectAddress*)((intptr_t)blockData->Lines + bumpCursor);
+				uint8_t offsetInLine = bumpCursor & Constants::LineSizeInBytesMask;
+				uint32_t lineIndex = bumpCursor >> Constants::LineBits;
+				LineFlags& lineFlags = blockData->Header.LineFlags[lineIndex];
+
+				// Set the object header + add the hashcode
+				// uint32_t hashCode = (((uint32_t)lineData) + (((uint32_t)lineData) >> 15)) * 16807;
+				object->Initialize(sizeInBytes);
+				object->SetClassDescriptor(classDescriptor);
+				blockData->SetObjectStart(bumpCursor);
+
+				if ((lineFlags & LineFlags::ContainsObject) == 0)
+				{
+					lineFlags = (LineFlags)(offsetInLine | (uint8_t)LineFlags::ContainsObject);
+				}
 
-			// Set the object header + add the hashcode
-			// uint32_t hashCode = (((uint32_t)lineData) + (((uint32_t)lineData) >> 15)) * 16807;
-			object->Initialize(sizeInBytes);
-			object->SetClassDescriptor(classDescriptor);
+				// Advance the current position to the next memory slot
+				bumpCursor += totalSizeInBytes;
+				allocatedBytes += totalSizeInBytes;
 
-			if ((lineFlags & LineFlags::ContainsObject) == 0)
-			{
-				lineFlags = (LineFlags)(offsetInLine | (uint8_t)LineFlags::ContainsObject);
+				return object;
 			}
 
-			// Advance the current position to the next memory slot
-			bumpCursor += totalSizeInBytes;
-
-			return object;
-
 			// ------------------------------------------------
 			//  Get or create the next block
 			// ------------------------------------------------
 		allocateBlock:
-			if (GlobalAllocator::Instance->CollectRequested())
+#if (GCIX_ENABLE_NURSERY == 1)
+			// A full nursery is collected before allocating into another block
+			if (Collector::NurseryEnabled() && nurseryBlockCount == Constants::NurseryBlockCount)
 			{
-				stackFrame.Capture(this);
+				GlobalAllocator::Instance->RequestCollect();
+			}
+#endif
 
-				// Reset this allocator current block in order to fetch a new block
-				current = nullptr;
-				overflow = nullptr;
+			// Safepoint: the collector resets the current blocks of all allocators
+			if (GlobalAllocator::Instance->CollectRequested() || Collector::SafepointRequested())
+			{
+				stackFrame.Capture(this);
 			}
 
-			// Gets a new block for the current handler
-			*pBlockData = GlobalAllocator::Instance->RequestBlock(pBlockData == &overflow);
+			// Gets a new block for the current handler. The nursery only bump allocates into free blocks, leaving the holes 
+			// of the recyclable blocks to the objects copied out of it
+			*pBlockData = pBlockData == &overflow || Collector::NurseryEnabled() ? 
+				freeBlockCache.RequestBlock(true) : blockCache.RequestBlock(false);
 
 			// If new block is null, then we are running out of space, return nullptr
 			if (*pBlockData == nullptr)
 			{
 				return nullptr;
 			}
+
+#if (GCIX_ENABLE_NURSERY == 1)
+			// The blocks allocated into after a collection failed to empty the nursery are not part of it
+			if (Collector::NurseryEnabled() && nurseryBlockCount < Constants::NurseryBlockCount)
+			{
+				nursery[nurseryBlockCount++] = *pBlockData;
+			}
+#endif
+
+			// Clear the lines left dirty by the last recycle
+			(*pBlockData)->ClearFreeLines();
 		}
 	}
 
@@ -192,51 +193,120 @@ namespace gcix
 		gcix_assert(ThreadLocalAllocator::Instance != nullptr);
 		gcix_assert(GlobalAllocator::Instance != nullptr);
 		gcix_assert(classDescriptor != nullptr);
-		gcix_assert(sizeInBytes > 0 && sizeInBytes <= ObjectConstants::MaxObjectSizePerBlock);
+		gcix_assert(sizeInBytes > ObjectConstants::MaxObjectSizePerBlock);
+		gcix_assert(ObjectAddress::IsValidClassDescriptor(classDescriptor, sizeInBytes));
+
 
+		RuntimeScope scope(this);
 
-		if (GlobalAllocator::Instance->CollectRequested())
+		if (GlobalAllocator::Instance->CollectRequested() || Collector::SafepointRequested())
 		{
 			stackFrame.Capture(this);
 		}
 
-		return GlobalAllocator::Instance->AllocateLargeObject(sizeInBytes, classDescriptor);
+		auto object = GlobalAllocator::Instance->AllocateLargeObject(sizeInBytes, classDescriptor);
+		if (object != nullptr)
+		{
+			allocatedBytes += object->Size();
+		}
+		return object;
 	}
 
-	gcix_noinline void ThreadLocalAllocator::StackCallback()
+	gcix_noinline void ThreadLocalAllocator::LogObject(ObjectAddress* object)
 	{
-		gcix_assert(ThreadLocalAllocator::Instance != nullptr);
-		gcix_assert(GlobalAllocator::Instance != nullptr);
+		// The log bit and the remembered set must be updated before the thread can be suspended by a collection
+		RuntimeScope scope(this);
 
-		// printf("StackFrame base:%p, top %p\n", stack.GetBottomOfStack(), stack.GetToOfStack());
+#if (GCIX_ENABLE_RC == 1)
+		if (Collector::RcEnabled())
+		{
+			// The references are read before setting the log bit: a thread storing into the object in the meantime goes 
+			// through this slow path as well, and only the first one setting the bit keeps its log
+			DecrementLogContext context;
+			context.Visitor = LogDecrementedReference;
+			context.Count = 0;
+			object->VisitReferences(&context);
+
+			if (object->TryStickyLog())
+			{
+				rememberedSet.Push(object);
+				return;
+			}
 
-		auto startPointer = (uint32_t*)stackFrame.GetToOfStack();
-		auto endPointer = (uint32_t*)stackFrame.GetBottomOfStack();
-		// TODO: Add statistics
+			for (size_t i = 0; i < context.Count; i++)
+			{
+				decrementLog.Pop();
+			}
+			return;
+		}
+#endif
 
-		GlobalAllocator::Instance->ClearMarked();
+		if (object->TryStickyLog())
+		{
+			rememberedSet.Push(object);
+		}
+	}
 
-		// First mark roots
-		GlobalAllocator::Instance->MarkRoots();
+	gcix_noinline void ThreadLocalAllocator::LogReference(void* reference)
+	{
+		// The log must be updated before the thread can be suspended by the remark pause
+		RuntimeScope scope(this);
+		LogSnapshotReference(reference);
+	}
+
+	gcix_noinline void ThreadLocalAllocator::LogReferences(ObjectAddress* object)
+	{
+		RuntimeScope scope(this);
 
-		// Conservative mark of the current stack
-		auto globalAllocator = GlobalAllocator::Instance;
-		int marked = 0;
-		while (startPointer < endPointer)
+#if (GCIX_ENABLE_INNER_OBJECT == 1)
+		if (object->IsInnerObject())
 		{
-			auto pointerToCheck = *(void**)startPointer;
+			object = ((InnerObjectAddress*)object)->Parent();
+		}
+#endif
+		VisitorContext context;
+		context.Visitor = LogVisitedReference;
+		object->VisitReferences(&context);
+	}
 
-			auto object = globalAllocator->FindObjectConservative(pointerToCheck);
+	gcix_noinline void ThreadLocalAllocator::LogReferences(void** slots, size_t count)
+	{
+		RuntimeScope scope(this);
 
-			if (object != nullptr)
+		for (size_t i = 0; i < count; i++)
+		{
+			if (slots[i] != nullptr)
 			{
-				Marker::Mark(object);
-				marked++;
+				LogSnapshotReference(slots[i]);
 			}
-			startPointer++;
 		}
+	}
+
+	void gcix_fastcall ThreadLocalAllocator::LogVisitedReference(void** reference, VisitorContext*)
+	{
+		if (*reference != nullptr)
+		{
+			Instance->LogSnapshotReference(*reference);
+		}
+	}
+
+#if (GCIX_ENABLE_RC == 1)
+	void gcix_fastcall ThreadLocalAllocator::LogDecrementedReference(void** reference, VisitorContext* context)
+	{
+		if (*reference != nullptr)
+		{
+			Instance->decrementLog.Push(ObjectAddress::FromUserObject(*reference));
+			((DecrementLogContext*)context)->Count++;
+		}
+	}
+#endif
+
+	gcix_noinline void ThreadLocalAllocator::StackCallback()
+	{
+		gcix_assert(ThreadLocalAllocator::Instance != nullptr);
+		gcix_assert(GlobalAllocator::Instance != nullptr);
 
-		GlobalAllocator::Instance->Recycle();
+		Collector::Instance->Safepoint(this);
 	}
 }
 
@@ -25,10 +25,16 @@
 #include "LineFlags.h"
 #include "Constants.h"
 #include "BlockData.h"
-#include "Utility\Memory.h"
+#include "BlockCache.h"
+#include "Utility/Memory.h"
 #include "StackFrame.h"
 #include "ObjectAddress.h"
 #include "Marker.h"
+#include "Collector.h"
+#include "MutatorState.h"
+#include "Tracer.h"
+
+#include <atomic>
 
 namespace gcix
 {
@@ -39,6 +45,82 @@ namespace gcix
 
 		LargeObjectAddress* AllocateLargeObject(uint32_t sizeInBytes, void* classDescriptor);
 
+		/**
+		Parks the calling thread if a collection is waiting for mutator threads to reach a safepoint.
+		*/
+		inline void Safepoint()
+		{
+			if (Collector::SafepointRequested())
+			{
+				RuntimeScope scope(this);
+				stackFrame.Capture(this);
+			}
+		}
+
+		/**
+		Write barrier, must be called before storing a reference into the specified object. The first store into an 
+		object that survived a collection logs it into the remembered set of this thread, so that sticky collections visit
+		the objects it references without tracing all the old objects. While a concurrent trace is running, all the 
+		references of the object are logged, as the reference about to be overwritten is unknown (see 
+		@see WriteBarrier(ObjectAddress*, void**)).
+		*/
+		inline void WriteBarrier(ObjectAddress* object)
+		{
+			if (Marker::Marking())
+			{
+				LogReferences(object);
+			}
+			RememberObject(object, nullptr, 0);
+		}
+
+		/**
+		Write barrier, must be called before storing a reference into the specified slot of the specified object. While a 
+		concurrent trace is running, the reference about to be overwritten is logged (snapshot-at-the-beginning barrier), 
+		so that all the objects reachable when the trace started are marked even if the mutator moves the last reference
+		to them into an object already traced.
+		*/
+		inline void WriteBarrier(ObjectAddress* object, void** slot)
+		{
+			if (Marker::Marking() && *slot != nullptr)
+			{
+				LogReference(*slot);
+			}
+			RememberObject(object, slot, 1);
+		}
+
+		/**
+		Write barrier, must be called before storing references into the specified consecutive slots of the specified 
+		object. While a concurrent trace is running, the references about to be overwritten are logged.
+		*/
+		inline void WriteBarrier(ObjectAddress* object, void** slots, size_t count)
+		{
+			if (Marker::Marking())
+			{
+				LogReferences(slots, count);
+			}
+			RememberObject(object, slots, count);
+		}
+
+		/**
+		Declares that the calling thread is going to run native code without accessing managed objects. Collections can 
+		run concurrently with native code.
+		*/
+		inline void EnterNativeCode()
+		{
+			RuntimeScope scope(this);
+			stackFrame.Capture();
+			Collector::Instance->EnterNativeCode(this);
+		}
+
+		/**
+		Declares that the calling thread is leaving native code. Waits for the end of the current collection if any.
+		*/
+		inline void LeaveNativeCode()
+		{
+			RuntimeScope scope(this);
+			Collector::Instance->LeaveNativeCode(this);
+		}
+
 		BlockData* current;
 		BlockData* overflow;
 
@@ -47,6 +129,22 @@ namespace gcix
 			if (Instance == nullptr)
 			{
 				Instance = new ThreadLocalAllocator();
+				Collector::Instance->Register(Instance);
+			}
+		}
+
+		/**
+		Unregisters the calling thread from the collector and deletes its allocator.
+		*/
+		inline static void Shutdown()
+		{
+			if (Instance != nullptr)
+			{
+				Instance->EnterNativeCode();
+				Collector::Instance->Unregister(Instance);
+				delete Instance;
+				Instance = nullptr;
+				Tracer::ReleaseThreadBuffer();
 			}
 		}
 
@@ -54,15 +152,184 @@ namespace gcix
 	private:
 		gcix_overrides_new_delete();
 			
-		inline ThreadLocalAllocator() : current(nullptr), overflow(nullptr)
+		inline ThreadLocalAllocator() : current(nullptr), overflow(nullptr), state(MutatorState::Running), inRuntime(false),
+			threadHandle(0), allocatedBytes(0), rememberedSet(&Collector::Instance->rememberedSetAllocator),
+			satbLog(&Collector::Instance->rememberedSetAllocator)
+#if (GCIX_ENABLE_RC == 1)
+			, decrementLog(&Collector::Instance->rememberedSetAllocator)
+#endif
+#if (GCIX_ENABLE_NURSERY == 1)
+			, nurseryBlockCount(0)
+#endif
 		{
 			stackFrame.Initialize();
+#ifdef GCIX_PLATFORM_WINDOWS
+			inWriteBarrier = &InWriteBarrier;
+#endif
 		}
 
+		/**
+		Marks the calling thread as running gcix code, where it cannot be suspended asynchronously by the collector.
+		*/
+		class RuntimeScope
+		{
+		public:
+			inline RuntimeScope(ThreadLocalAllocator* allocator) : allocator(allocator)
+			{
+				allocator->inRuntime = true;
+				std::atomic_signal_fence(std::memory_order_seq_cst);
+			}
+
+			inline ~RuntimeScope()
+			{
+				std::atomic_signal_fence(std::memory_order_seq_cst);
+				allocator->inRuntime = false;
+			}
+		private:
+			ThreadLocalAllocator* allocator;
+		};
+
 		gcix_noinline void StackCallback();
 
+		/* 
+		Logs the specified object into the remembered set if it is an old object not yet logged. The cards of the slots 
+		modified in an old large object are dirtied, all its cards if the slots are unknown (null).
+		*/
+#if (GCIX_ENABLE_CARD_TABLE == 1)
+		inline void RememberObject(ObjectAddress* object, void** slots, size_t count)
+#else
+		inline void RememberObject(ObjectAddress* object, void**, size_t)
+#endif
+		{
+#if (GCIX_ENABLE_INNER_OBJECT == 1)
+			if (object->IsInnerObject())
+			{
+				object = ((InnerObjectAddress*)object)->Parent();
+			}
+#endif
+			if (!Collector::StickyEnabled())
+			{
+				return;
+			}
+
+#if (GCIX_ENABLE_CARD_TABLE == 1)
+			// Young objects are entirely traced by the next collection
+			if (object->IsLargeObject() && object->IsMarked())
+			{
+				((LargeObjectAddress*)object)->DirtyCards(slots, count);
+			}
+#endif
+			if (object->RequiresStickyLog())
+			{
+				LogObject(object);
+			}
+		}
+
+		/* 
+		Slow path of the write barrier, logs an old object into the remembered set. When counting references, the 
+		references of the object are logged first, to be decremented by the next collection (coalescing barrier: the 
+		references stored until then are counted by the next collection when it rescans the object).
+		*/
+		gcix_noinline void LogObject(ObjectAddress* object);
+
+		/* Slow path of the write barrier during a concurrent trace, logs a reference about to be overwritten */
+		gcix_noinline void LogReference(void* reference);
+
+		/* Slow path of the write barrier during a concurrent trace, logs all the references of an object */
+		gcix_noinline void LogReferences(ObjectAddress* object);
+
+		/* Slow path of the write barrier during a concurrent trace, logs the references of consecutive slots */
+		gcix_noinline void LogReferences(void** slots, size_t count);
+
+		/* Logs the object of a reference overwritten during a concurrent trace, unless it is already marked */
+		inline void LogSnapshotReference(void* reference)
+		{
+			auto object = ObjectAddress::FromUserObject(reference);
+#if (GCIX_ENABLE_INNER_OBJECT == 1)
+			if (object->IsInnerObject())
+			{
+				object = ((InnerObjectAddress*)object)->Parent();
+			}
+#endif
+			if (!object->IsMarked())
+			{
+				satbLog.Push(object);
+			}
+		}
+
+		/* Visitor of @see LogReferences */
+		static void gcix_fastcall LogVisitedReference(void** reference, VisitorContext* context);
+
+#if (GCIX_ENABLE_RC == 1)
+		/* Context of the visitor of the references logged by @see LogObject */
+		struct DecrementLogContext : VisitorContext
+		{
+			size_t Count;
+		};
+
+		/* Visitor of the references logged by @see LogObject */
+		static void gcix_fastcall LogDecrementedReference(void** reference, VisitorContext* context);
+#endif
+
+		/**
+		Discards the blocks used by this allocator, as they have been recycled by a collection.
+		*/
+		inline void ResetBlocks()
+		{
+			current = nullptr;
+			overflow = nullptr;
+			blockCache.Clear();
+			freeBlockCache.Clear();
+#if (GCIX_ENABLE_NURSERY == 1)
+			nurseryBlockCount = 0;
+#endif
+		}
+
 		friend class StackFrame;
+		friend class Collector;
 
 		StackFrame stackFrame;
+
+		/* Cache of blocks used to refill the current block handler */
+		BlockCache blockCache;
+
+		/* Cache of free blocks used to refill the overflow block handler */
+		BlockCache freeBlockCache;
+
+		/* State of this thread regarding collections */
+		std::atomic<MutatorState> state;
+
+		/* True while this thread is running gcix code */
+		volatile bool inRuntime;
+
+		/* Platform handle of this thread, used to suspend it asynchronously */
+		uintptr_t threadHandle;
+
+#ifdef GCIX_PLATFORM_WINDOWS
+		/* gcix::InWriteBarrier of this thread, read by the collector after suspending it */
+		volatile bool* inWriteBarrier;
+#endif
+
+		/* Bytes allocated by this thread since the last collection, accounted by the collector */
+		size_t allocatedBytes;
+
+		/* Old objects logged by the write barrier since the last collection */
+		DefaultSequentialStoreBufferHandle rememberedSet;
+
+		/* Objects of the references overwritten during the current concurrent trace, marked by its remark pause */
+		DefaultSequentialStoreBufferHandle satbLog;
+
+#if (GCIX_ENABLE_RC == 1)
+		/* Objects referenced by old objects when they were logged, decremented by the next collection */
+		DefaultSequentialStoreBufferHandle decrementLog;
+#endif
+
+#if (GCIX_ENABLE_NURSERY == 1)
+		/* Free blocks allocated into since the last collection, whose surviving objects are copied by the next one */
+		BlockData* nursery[Constants::NurseryBlockCount];
+
+		/* Number of blocks of the nursery */
+		int32_t nurseryBlockCount;
+#endif
 	};
 }
\ No newline at end of file
@@ -18,7 +18,7 @@
 // LIABILITY, OR TORT (INCLUDING NEGLIGENCE OR OTHERWISE) ARISING IN ANY WAY OUT OF THE USE OF THIS SOFTWARE, EVEN IF ADVISED 
 // OF THE POSSIBILITY OF SUCH DAMAGE.
 
-#include "Threading\ManualResetEvent.h"
+#include "Threading/ManualResetEvent.h"
 #ifdef GCIX_PLATFORM_WINDOWS
 #define WIN32_LEAN_AND_MEAN 1
 #include <Windows.h>
@@ -40,12 +40,14 @@ namespace gcix
 
 	void ManualResetEvent::Reset()
 	{
-		gcix_assert(::ResetEvent(eventHandle));
+		auto result = ::ResetEvent(eventHandle);
+		gcix_assert(result);
 	}
 
 	void ManualResetEvent::Set()
 	{
-		gcix_assert(::SetEvent(eventHandle));
+		auto result = ::SetEvent(eventHandle);
+		gcix_assert(result);
 	}
 
 	void ManualResetEvent::WaitOne()
@@ -20,7 +20,7 @@
 // OF THE POSSIBILITY OF SUCH DAMAGE.
 
 #include "Common.h"
-#include "Utility\Memory.h"
+#include "Utility/Memory.h"
 #ifndef GCIX_PLATFORM_WINDOWS
 #include <condition_variable>
 #include <mutex>
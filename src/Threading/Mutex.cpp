@@ -18,8 +18,8 @@
 // LIABILITY, OR TORT (INCLUDING NEGLIGENCE OR OTHERWISE) ARISING IN ANY WAY OUT OF THE USE OF THIS SOFTWARE, EVEN IF ADVISED 
 // OF THE POSSIBILITY OF SUCH DAMAGE.
 
-#include "Threading\Mutex.h"
-#include "Utility\Memory.h"
+#include "Threading/Mutex.h"
+#include "Utility/Memory.h"
 #ifdef GCIX_PLATFORM_WINDOWS
 #define WIN32_LEAN_AND_MEAN 1
 #include <Windows.h>
@@ -18,16 +18,16 @@
 // LIABILITY, OR TORT (INCLUDING NEGLIGENCE OR OTHERWISE) ARISING IN ANY WAY OUT OF THE USE OF THIS SOFTWARE, EVEN IF ADVISED 
 // OF THE POSSIBILITY OF SUCH DAMAGE.
 
-#include "Threading\Thread.h"
+#include "Threading/Thread.h"
 #ifdef GCIX_PLATFORM_WINDOWS
 #define WIN32_LEAN_AND_MEAN 1
 #include <Windows.h>
+#else
+#include <pthread.h>
 #endif
 
 namespace gcix
 {
-
-#ifdef GCIX_PLATFORM_WINDOWS
 	Thread::Thread(ThreadRunDelegate task, void *context) : thread(task, context)
 	{
 	}
@@ -37,31 +37,49 @@ namespace gcix
 	}
 
 	/**
-	Locks this mutex.
+	Blocks the caller of this method until this thread instance is terminated.
 	*/
 	void Thread::Join()
 	{
 		thread.join();
 	}
 
-#else
-	Thread::Thread()
+	void Thread::YieldExecution()
 	{
+		std::this_thread::yield();
 	}
 
-	Thread::~Thread()
+	void Thread::Sleep(uint32_t milliseconds)
 	{
+		std::this_thread::sleep_for(std::chrono::milliseconds(milliseconds));
 	}
 
-	/**
-	Locks this mutex.
-	*/
-	void Thread::Join()
+	int32_t Thread::GetProcessorCount()
 	{
-		mutex.lock();
+		auto count = (int32_t)std::thread::hardware_concurrency();
+		return count > 0 ? count : 1;
 	}
 
+	void* Thread::GetStackBase()
+	{
+#if defined(GCIX_PLATFORM_WINDOWS)
+		return ((NT_TIB*)::NtCurrentTeb())->StackBase;
+#elif defined(__APPLE__)
+		return pthread_get_stackaddr_np(pthread_self());
+#elif defined(__linux__)
+		pthread_attr_t attributes;
+		if (pthread_getattr_np(pthread_self(), &attributes) != 0)
+		{
+			return nullptr;
+		}
+		void* stackAddress = nullptr;
+		size_t stackSize = 0;
+		pthread_attr_getstack(&attributes, &stackAddress, &stackSize);
+		pthread_attr_destroy(&attributes);
+		return stackAddress == nullptr ? nullptr : (void*)((intptr_t)stackAddress + stackSize);
+#else
+		return nullptr;
 #endif
-
+	}
 }
 
@@ -20,10 +20,8 @@
 // OF THE POSSIBILITY OF SUCH DAMAGE.
 
 #include "Common.h"
-#include "Utility\Memory.h"
-#ifdef GCIX_PLATFORM_WINDOWS
+#include "Utility/Memory.h"
 #include <thread>
-#endif
 
 namespace gcix
 {
@@ -31,7 +29,7 @@ namespace gcix
 
 	/**
 	A Thread.
-	Using directly OS functions on Windows platform and C++11 on other platforms.
+	Using C++11 threads on all platforms.
 	*/
 	class Thread
 	{
@@ -44,15 +42,30 @@ namespace gcix
 		*/
 		void Join();
 
+		/**
+		Yields the execution of the calling thread to another thread.
+		*/
+		static void YieldExecution();
+
+		/**
+		Suspends the execution of the calling thread for the specified time.
+		*/
+		static void Sleep(uint32_t milliseconds);
+
+		/**
+		Returns the number of hardware threads available on this machine (at least 1).
+		*/
+		static int32_t GetProcessorCount();
+
+		/**
+		Returns the highest address of the stack of the calling thread, or `nullptr` if it cannot be determined.
+		*/
+		static void* GetStackBase();
+
 		gcix_overrides_new_delete();
 
 	private:
-
-#ifdef GCIX_PLATFORM_WINDOWS
 		std::thread thread;
-#else
-		void* privateThread;
-#endif
 	};
 
 }
\ No newline at end of file
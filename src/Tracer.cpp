@@ -0,0 +1,166 @@
+﻿// Copyright (c) 2014, Alexandre Mutel
+// All rights reserved.
+// 
+// Redistribution and use in source and binary forms, with or without modification, are permitted provided that the following  
+// conditions are met:
+// 
+// 1. Redistributions of source code must retain the above copyright notice, this list of conditions and the following 
+//    disclaimer.
+// 
+// 2. Redistributions in binary form must reproduce the above copyright notice, this list of conditions and the following 
+//    disclaimer in the documentation and/or other materials provided with the distribution.
+// 
+// THIS SOFTWARE IS PROVIDED BY THE COPYRIGHT HOLDERS AND CONTRIBUTORS "AS IS" AND ANY EXPRESS OR IMPLIED WARRANTIES, 
+// INCLUDING, BUT NOT LIMITED TO, THE IMPLIED WARRANTIES OF MERCHANTABILITY AND FITNESS FOR A PARTICULAR PURPOSE ARE 
+// DISCLAIMED. IN NO EVENT SHALL THE COPYRIGHT HOLDER OR CONTRIBUTORS BE LIABLE FOR ANY DIRECT, INDIRECT, INCIDENTAL, SPECIAL, 
+// EXEMPLARY, OR CONSEQUENTIAL DAMAGES (INCLUDING, BUT NOT LIMITED TO, PROCUREMENT OF SUBSTITUTE GOODS OR SERVICES; LOSS OF 
+// USE, DATA, OR PROFITS; OR BUSINESS INTERRUPTION) HOWEVER CAUSED AND ON ANY THEORY OF LIABILITY, WHETHER IN CONTRACT, STRICT 
+// LIABILITY, OR TORT (INCLUDING NEGLIGENCE OR OTHERWISE) ARISING IN ANY WAY OUT OF THE USE OF THIS SOFTWARE, EVEN IF ADVISED 
+// OF THE POSSIBILITY OF SUCH DAMAGE.
+
+#include "Tracer.h"
+
+#include <stdio.h>
+
+#ifdef GCIX_PLATFORM_WINDOWS
+#define WIN32_LEAN_AND_MEAN 1
+#include <Windows.h>
+#endif
+
+namespace gcix
+{
+	void Tracer::Initialize()
+	{
+		if (Instance == nullptr)
+		{
+			Instance = new Tracer();
+		}
+	}
+
+	Tracer::Tracer() : startTime(std::chrono::steady_clock::now()), nextThreadId(1), buffers(BufferCount)
+	{
+	}
+
+	void Tracer::Start()
+	{
+		gcix_assert(Instance != nullptr);
+		enabled = true;
+	}
+
+	void Tracer::Stop()
+	{
+		enabled = false;
+	}
+
+	gcix_noinline void Tracer::Record(const char* name, char phase)
+	{
+		auto buffer = threadBuffer;
+		if (buffer == nullptr)
+		{
+			buffer = threadBuffer = Instance->AcquireBuffer();
+		}
+
+		// The writer moves the tail after reading the events, they can then be overwritten
+		auto head = buffer->Head.load(std::memory_order_relaxed);
+		if (head - buffer->Tail.load(std::memory_order_acquire) >= TraceBuffer::EventCount)
+		{
+			buffer->DroppedCount++;
+			return;
+		}
+
+		auto& event = buffer->Events[head & (TraceBuffer::EventCount - 1)];
+		event.Name = name;
+		event.Timestamp = (uint64_t)std::chrono::duration_cast<std::chrono::nanoseconds>(
+			std::chrono::steady_clock::now() - Instance->startTime).count();
+		event.ThreadId = buffer->ThreadId;
+		event.Phase = phase;
+		buffer->Head.store(head + 1, std::memory_order_release);
+	}
+
+	TraceBuffer* Tracer::AcquireBuffer()
+	{
+		gcix_lock(mutexBuffers);
+
+		TraceBuffer* buffer = nullptr;
+		for (int32_t i = 0; i < buffers.Count(); i++)
+		{
+			if (!buffers[i]->Owned)
+			{
+				buffer = buffers[i];
+				break;
+			}
+		}
+
+		if (buffer == nullptr)
+		{
+			buffer = new TraceBuffer();
+			buffer->Head = 0;
+			buffer->Tail = 0;
+			buffer->DroppedCount = 0;
+			buffers.Add(buffer);
+		}
+
+		buffer->Owned = true;
+		buffer->ThreadId = nextThreadId++;
+		return buffer;
+	}
+
+	void Tracer::ReleaseThreadBuffer()
+	{
+		if (threadBuffer != nullptr)
+		{
+			threadBuffer->Owned = false;
+			threadBuffer = nullptr;
+		}
+	}
+
+	bool Tracer::Write(const char* path)
+	{
+		gcix_assert(path != nullptr);
+
+		FILE* file;
+#ifdef GCIX_PLATFORM_WINDOWS
+		if (fopen_s(&file, path, "w") != 0)
+		{
+			file = nullptr;
+		}
+#else
+		file = fopen(path, "w");
+#endif
+		if (file == nullptr)
+		{
+			return false;
+		}
+
+		gcix_lock(mutexBuffers);
+
+		// Chrome trace event format, timestamps are in microseconds
+		uint32_t droppedCount = 0;
+		const char* separator = "";
+		fprintf(file, "{\"traceEvents\":[");
+		for (int32_t i = 0; i < buffers.Count(); i++)
+		{
+			auto buffer = buffers[i];
+			auto head = buffer->Head.load(std::memory_order_acquire);
+			auto tail = buffer->Tail.load(std::memory_order_relaxed);
+			for (; tail != head; tail++)
+			{
+				auto& event = buffer->Events[tail & (TraceBuffer::EventCount - 1)];
+				fprintf(file, "%s\n{\"name\":\"%s\",\"cat\":\"gc\",\"ph\":\"%c\",\"ts\":%llu.%03u,\"pid\":1,\"tid\":%u}", 
+					separator, event.Name, event.Phase, (unsigned long long)(event.Timestamp / 1000), 
+					(uint32_t)(event.Timestamp % 1000), event.ThreadId);
+				separator = ",";
+			}
+			buffer->Tail.store(tail, std::memory_order_release);
+			droppedCount += buffer->DroppedCount.exchange(0);
+		}
+		fprintf(file, "\n],\"displayTimeUnit\":\"ms\",\"otherData\":{\"droppedEvents\":%u}}\n", droppedCount);
+
+		auto succeeded = ferror(file) == 0;
+		return fclose(file) == 0 && succeeded;
+	}
+
+	std::atomic<bool> Tracer::enabled(false);
+	gcix_thread_local TraceBuffer* Tracer::threadBuffer;
+	Tracer* Tracer::Instance;
+}
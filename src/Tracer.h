@@ -0,0 +1,215 @@
+﻿#pragma once
+// Copyright (c) 2014, Alexandre Mutel
+// All rights reserved.
+// 
+// Redistribution and use in source and binary forms, with or without modification, are permitted provided that the following 
+// conditions are met:
+// 
+// 1. Redistributions of source code must retain the above copyright notice, this list of conditions and the following 
+//    disclaimer.
+// 
+// 2. Redistributions in binary form must reproduce the above copyright notice, this list of conditions and the following 
+//    disclaimer in the documentation and/or other materials provided with the distribution.
+// 
+// THIS SOFTWARE IS PROVIDED BY THE COPYRIGHT HOLDERS AND CONTRIBUTORS "AS IS" AND ANY EXPRESS OR IMPLIED WARRANTIES, 
+// INCLUDING, BUT NOT LIMITED TO, THE IMPLIED WARRANTIES OF MERCHANTABILITY AND FITNESS FOR A PARTICULAR PURPOSE ARE 
+// DISCLAIMED. IN NO EVENT SHALL THE COPYRIGHT HOLDER OR CONTRIBUTORS BE LIABLE FOR ANY DIRECT, INDIRECT, INCIDENTAL, SPECIAL, 
+// EXEMPLARY, OR CONSEQUENTIAL DAMAGES (INCLUDING, BUT NOT LIMITED TO, PROCUREMENT OF SUBSTITUTE GOODS OR SERVICES; LOSS OF 
+// USE, DATA, OR PROFITS; OR BUSINESS INTERRUPTION) HOWEVER CAUSED AND ON ANY THEORY OF LIABILITY, WHETHER IN CONTRACT, STRICT 
+// LIABILITY, OR TORT (INCLUDING NEGLIGENCE OR OTHERWISE) ARISING IN ANY WAY OUT OF THE USE OF THIS SOFTWARE, EVEN IF ADVISED 
+// OF THE POSSIBILITY OF SUCH DAMAGE.
+
+
+#include "Common.h"
+#include "Collections/List.h"
+#include "Threading/Mutex.h"
+#include "Utility/Memory.h"
+
+#include <atomic>
+#include <chrono>
+
+#if (GCIX_ENABLE_TRACE == 1)
+#define gcix_trace_concat_inner(a, b) a ## b
+#define gcix_trace_concat(a, b) gcix_trace_concat_inner(a, b)
+
+/** Records the begin event of a phase on the calling thread */
+#define gcix_trace_begin(name) Tracer::Begin(name)
+
+/** Records the end event of a phase on the calling thread */
+#define gcix_trace_end(name) Tracer::End(name)
+
+/** Records the begin and end events of a phase spanning the current scope */
+#define gcix_trace_scope(name) TraceScope gcix_trace_concat(traceScope, __LINE__)(name)
+#else
+#define gcix_trace_begin(name)
+#define gcix_trace_end(name)
+#define gcix_trace_scope(name)
+#endif
+
+namespace gcix
+{
+	/**
+	An event recorded by the @see Tracer.
+	*/
+	struct TraceEvent
+	{
+		/** Name of the phase, a string literal */
+		const char* Name;
+
+		/** Time of the event in nanoseconds since the initialization of the tracer */
+		uint64_t Timestamp;
+
+		/** Identifier of the thread recording the event */
+		uint32_t ThreadId;
+
+		/** Type of the event, 'B' (begin) or 'E' (end) */
+		char Phase;
+	};
+
+	/**
+	Ring of events recorded by a single thread and consumed by @see Tracer::Write. The recording thread and the writer 
+	don't share any lock: the recording thread only moves the head and the writer only moves the tail. Events are dropped
+	while the ring is full.
+	*/
+	struct TraceBuffer
+	{
+		static const uint32_t EventCount = 1 << 13;
+
+		TraceEvent Events[EventCount];
+
+		/** Index of the next event to record, only modified by the owner thread */
+		std::atomic<uint32_t> Head;
+
+		/** Index of the next event to write, only modified by the writer */
+		std::atomic<uint32_t> Tail;
+
+		/** True while this buffer is used by a thread */
+		std::atomic<bool> Owned;
+
+		/** Identifier of the thread owning this buffer */
+		uint32_t ThreadId;
+
+		/** Number of events dropped because the ring was full */
+		std::atomic<uint32_t> DroppedCount;
+
+		gcix_overrides_new_delete();
+	};
+
+	/**
+	Records the begin and end events of the phases of the collections and of the stalls of the mutator threads, when 
+	enabled by @see Start. Events are buffered per thread and written on demand to a Chrome trace event JSON file, that can
+	be loaded in chrome://tracing or Perfetto. The recording macros (gcix_trace_begin, gcix_trace_end, gcix_trace_scope)
+	are compiled only if GCIX_ENABLE_TRACE is set, and only test a flag while the tracer is not started.
+	*/
+	class Tracer
+	{
+	public:
+		/**
+		Initialize the @see Tracer::Instance variable.
+		*/
+		static void Initialize();
+
+		/**
+		Starts recording events.
+		*/
+		static void Start();
+
+		/**
+		Stops recording events. Events already recorded are kept until the next @see Write.
+		*/
+		static void Stop();
+
+		/**
+		Indicates whether events are recorded.
+		*/
+		static inline bool Enabled()
+		{
+			return enabled.load(std::memory_order_relaxed);
+		}
+
+		/**
+		Records the begin event of a phase on the calling thread.
+		@param name Name of the phase, must be a string literal
+		*/
+		static inline void Begin(const char* name)
+		{
+			if (Enabled())
+			{
+				Record(name, 'B');
+			}
+		}
+
+		/**
+		Records the end event of a phase on the calling thread.
+		@param name Name of the phase, must be a string literal
+		*/
+		static inline void End(const char* name)
+		{
+			if (Enabled())
+			{
+				Record(name, 'E');
+			}
+		}
+
+		/**
+		Releases the buffer of the calling thread, that can be reused by another thread. Must be called before a thread 
+		recording events terminates.
+		*/
+		static void ReleaseThreadBuffer();
+
+		/**
+		Writes the events recorded so far to a Chrome trace event JSON file, and removes them from the buffers.
+		@param path Path of the file to write
+		@return false if the file cannot be written
+		*/
+		bool Write(const char* path);
+
+		static Tracer* Instance;
+	private:
+		gcix_overrides_new_delete();
+
+		Tracer();
+
+		static const int BufferCount = 64;
+
+		/* Records an event into the buffer of the calling thread, slow path of @see Begin and @see End */
+		static gcix_noinline void Record(const char* name, char phase);
+
+		/* Gets a buffer not owned by any thread, or allocates a new one */
+		TraceBuffer* AcquireBuffer();
+
+		/* Set while events are recorded */
+		static std::atomic<bool> enabled;
+
+		/* Buffer of the calling thread */
+		gcix_thread_local static TraceBuffer* threadBuffer;
+
+		/* Origin of the timestamps of the events */
+		std::chrono::steady_clock::time_point startTime;
+
+		/* Identifier of the next thread acquiring a buffer */
+		uint32_t nextThreadId;
+
+		Mutex mutexBuffers;
+		List<TraceBuffer*> buffers;
+	};
+
+	/**
+	Records the begin and end events of a phase spanning the lifetime of this instance, see gcix_trace_scope.
+	*/
+	class TraceScope
+	{
+	public:
+		inline TraceScope(const char* name) : name(name)
+		{
+			Tracer::Begin(name);
+		}
+
+		inline ~TraceScope()
+		{
+			Tracer::End(name);
+		}
+	private:
+		const char* name;
+	};
+}
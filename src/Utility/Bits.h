@@ -0,0 +1,84 @@
+﻿#pragma once
+// Copyright (c) 2014, Alexandre Mutel
+// All rights reserved.
+// 
+// Redistribution and use in source and binary forms, with or without modification, are permitted provided that the following 
+// conditions are met:
+// 
+// 1. Redistributions of source code must retain the above copyright notice, this list of conditions and the following 
+//    disclaimer.
+// 
+// 2. Redistributions in binary form must reproduce the above copyright notice, this list of conditions and the following 
+//    disclaimer in the documentation and/or other materials provided with the distribution.
+// 
+// THIS SOFTWARE IS PROVIDED BY THE COPYRIGHT HOLDERS AND CONTRIBUTORS "AS IS" AND ANY EXPRESS OR IMPLIED WARRANTIES, 
+// INCLUDING, BUT NOT LIMITED TO, THE IMPLIED WARRANTIES OF MERCHANTABILITY AND FITNESS FOR A PARTICULAR PURPOSE ARE 
+// DISCLAIMED. IN NO EVENT SHALL THE COPYRIGHT HOLDER OR CONTRIBUTORS BE LIABLE FOR ANY DIRECT, INDIRECT, INCIDENTAL, SPECIAL, 
+// EXEMPLARY, OR CONSEQUENTIAL DAMAGES (INCLUDING, BUT NOT LIMITED TO, PROCUREMENT OF SUBSTITUTE GOODS OR SERVICES; LOSS OF 
+// USE, DATA, OR PROFITS; OR BUSINESS INTERRUPTION) HOWEVER CAUSED AND ON ANY THEORY OF LIABILITY, WHETHER IN CONTRACT, STRICT 
+// LIABILITY, OR TORT (INCLUDING NEGLIGENCE OR OTHERWISE) ARISING IN ANY WAY OUT OF THE USE OF THIS SOFTWARE, EVEN IF ADVISED 
+// OF THE POSSIBILITY OF SUCH DAMAGE.
+
+
+#include "Common.h"
+
+#ifdef _MSC_VER
+#include <intrin.h>
+#endif
+
+namespace gcix
+{
+	/**
+	Bit manipulation helpers mapped to compiler intrinsics (tzcnt/bsf, popcnt).
+	*/
+	class Bits
+	{
+	public:
+		/**
+		Returns the index of the lowest bit set. Value must not be 0.
+		*/
+		static inline uint32_t TrailingZeroCount(uint32_t value)
+		{
+			gcix_assert(value != 0);
+#ifdef _MSC_VER
+			unsigned long index;
+			_BitScanForward(&index, value);
+			return (uint32_t)index;
+#else
+			return (uint32_t)__builtin_ctz(value);
+#endif
+		}
+
+		/**
+		Returns the index of the highest bit set. Value must not be 0.
+		*/
+		static inline uint32_t HighestBitIndex(uint32_t value)
+		{
+			gcix_assert(value != 0);
+#ifdef _MSC_VER
+			unsigned long index;
+			_BitScanReverse(&index, value);
+			return (uint32_t)index;
+#else
+			return 31 - (uint32_t)__builtin_clz(value);
+#endif
+		}
+
+		/**
+		Returns the number of bits set.
+		*/
+		static inline uint32_t PopCount(uint32_t value)
+		{
+#ifdef _MSC_VER
+			// __popcnt requires SSE4.2, use the portable version
+			value = value - ((value >> 1) & 0x55555555);
+			value = (value & 0x33333333) + ((value >> 2) & 0x33333333);
+			return (((value + (value >> 4)) & 0x0F0F0F0F) * 0x01010101) >> 24;
+#else
+			return (uint32_t)__builtin_popcount(value);
+#endif
+		}
+	private:
+		Bits() {}
+	};
+}
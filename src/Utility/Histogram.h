@@ -0,0 +1,79 @@
+﻿#pragma once
+// Copyright (c) 2014, Alexandre Mutel
+// All rights reserved.
+// 
+// Redistribution and use in source and binary forms, with or without modification, are permitted provided that the following 
+// conditions are met:
+// 
+// 1. Redistributions of source code must retain the above copyright notice, this list of conditions and the following 
+//    disclaimer.
+// 
+// 2. Redistributions in binary form must reproduce the above copyright notice, this list of conditions and the following 
+//    disclaimer in the documentation and/or other materials provided with the distribution.
+// 
+// THIS SOFTWARE IS PROVIDED BY THE COPYRIGHT HOLDERS AND CONTRIBUTORS "AS IS" AND ANY EXPRESS OR IMPLIED WARRANTIES, 
+// INCLUDING, BUT NOT LIMITED TO, THE IMPLIED WARRANTIES OF MERCHANTABILITY AND FITNESS FOR A PARTICULAR PURPOSE ARE 
+// DISCLAIMED. IN NO EVENT SHALL THE COPYRIGHT HOLDER OR CONTRIBUTORS BE LIABLE FOR ANY DIRECT, INDIRECT, INCIDENTAL, SPECIAL, 
+// EXEMPLARY, OR CONSEQUENTIAL DAMAGES (INCLUDING, BUT NOT LIMITED TO, PROCUREMENT OF SUBSTITUTE GOODS OR SERVICES; LOSS OF 
+// USE, DATA, OR PROFITS; OR BUSINESS INTERRUPTION) HOWEVER CAUSED AND ON ANY THEORY OF LIABILITY, WHETHER IN CONTRACT, STRICT 
+// LIABILITY, OR TORT (INCLUDING NEGLIGENCE OR OTHERWISE) ARISING IN ANY WAY OUT OF THE USE OF THIS SOFTWARE, EVEN IF ADVISED 
+// OF THE POSSIBILITY OF SUCH DAMAGE.
+
+
+#include "Common.h"
+#include "Bits.h"
+
+namespace gcix
+{
+	/**
+	Log-linear histogram buckets (HDR histogram like): each power of two range of values is split in 4 buckets of equal 
+	width, so that 128 buckets cover 32 bits values with a relative error below 25%.
+	*/
+	class Histogram
+	{
+	public:
+		/** Number of bits of the sub-buckets of a power of two range */
+		static const uint32_t SubBucketBits = 2;
+
+		/** Number of sub-buckets of a power of two range */
+		static const uint32_t SubBucketCount = 1 << SubBucketBits;
+
+		/** Number of buckets covering 32 bits values */
+		static const uint32_t BucketCount = (32 - SubBucketBits + 1) << SubBucketBits;
+
+		/**
+		Returns the index of the bucket counting the specified value.
+		*/
+		static inline uint32_t GetBucketIndex(uint32_t value)
+		{
+			if (value < SubBucketCount)
+			{
+				return value;
+			}
+
+			auto highestBit = Bits::HighestBitIndex(value);
+			auto subBucket = (value >> (highestBit - SubBucketBits)) & (SubBucketCount - 1);
+			return ((highestBit - SubBucketBits + 1) << SubBucketBits) + subBucket;
+		}
+
+		/**
+		Returns the lowest value counted by the specified bucket. Index can be equal to @see BucketCount to get the end
+		of the last bucket.
+		*/
+		static inline uint64_t GetBucketStart(uint32_t index)
+		{
+			gcix_assert(index <= BucketCount);
+
+			if (index < SubBucketCount)
+			{
+				return index;
+			}
+
+			auto shift = (index >> SubBucketBits) - 1;
+			auto subBucket = index & (SubBucketCount - 1);
+			return (uint64_t)(SubBucketCount + subBucket) << shift;
+		}
+	private:
+		Histogram() {}
+	};
+}
@@ -18,12 +18,13 @@
 // LIABILITY, OR TORT (INCLUDING NEGLIGENCE OR OTHERWISE) ARISING IN ANY WAY OUT OF THE USE OF THIS SOFTWARE, EVEN IF ADVISED 
 // OF THE POSSIBILITY OF SUCH DAMAGE.
 
-#include "Utility\Memory.h"
+#include "Utility/Memory.h"
 #ifdef GCIX_PLATFORM_WINDOWS
 #define WIN32_LEAN_AND_MEAN 1
 #include <Windows.h>
 #else
 #include <algorithm>
+#include <sys/mman.h>
 #endif
 
 namespace gcix
@@ -62,6 +63,42 @@ namespace gcix
 		gcix_assert(processHeapHandle != nullptr);
 		return ptr == nullptr ? ::HeapAlloc(processHeapHandle, 0, size) : ::HeapReAlloc(processHeapHandle, 0, ptr, size);
 	}
+
+	void* Memory::Reserve(size_t size, size_t alignment)
+	{
+		// The range is over-reserved to be aligned, the unaligned parts are never committed
+		auto raw = ::VirtualAlloc(nullptr, size + alignment, MEM_RESERVE, PAGE_NOACCESS);
+		if (raw == nullptr)
+		{
+			return nullptr;
+		}
+		return (void*)(((intptr_t)raw + alignment - 1) & ~(intptr_t)(alignment - 1));
+	}
+
+	bool Memory::Commit(void* address, size_t size)
+	{
+		return ::VirtualAlloc(address, size, MEM_COMMIT, PAGE_READWRITE) != nullptr;
+	}
+
+	void Memory::Decommit(void* address, size_t size)
+	{
+		::VirtualFree(address, size, MEM_DECOMMIT);
+	}
+
+	void Memory::AdviseHugePages(void* address, size_t size)
+	{
+		// Large pages require the SeLockMemoryPrivilege and cannot be decommitted on Windows
+	}
+
+	void* Memory::AllocatePages(size_t size)
+	{
+		return ::VirtualAlloc(nullptr, size, MEM_RESERVE | MEM_COMMIT, PAGE_READWRITE);
+	}
+
+	void Memory::FreePages(void* address, size_t size)
+	{
+		::VirtualFree(address, 0, MEM_RELEASE);
+	}
 #else
 	void Memory::Initialize()
 	{
@@ -79,18 +116,65 @@ namespace gcix
 
 	void* Memory::AllocateZero(size_t size)
 	{
-		void* ptr = malloc(size);
-		if (ptr == nullptr)
-		{
-			return ptr;
-		}
-		memset(ptr, 0, size);
-		return ptr;
+		// calloc gets large blocks straight from the OS already zeroed, without touching their pages
+		return calloc(1, size);
 	}
 
 	void* Memory::ReAllocate(void* ptr, size_t size)
 	{
 		return realloc(ptr, size);
 	}
+
+	void* Memory::Reserve(size_t size, size_t alignment)
+	{
+		auto raw = mmap(nullptr, size + alignment, PROT_NONE, MAP_PRIVATE | MAP_ANONYMOUS | MAP_NORESERVE, -1, 0);
+		if (raw == MAP_FAILED)
+		{
+			return nullptr;
+		}
+
+		// Release the unaligned parts of the range
+		auto start = ((intptr_t)raw + (intptr_t)alignment - 1) & ~(intptr_t)(alignment - 1);
+		if (start != (intptr_t)raw)
+		{
+			munmap(raw, start - (intptr_t)raw);
+		}
+		auto end = (intptr_t)raw + (intptr_t)(size + alignment);
+		if (end != start + (intptr_t)size)
+		{
+			munmap((void*)(start + size), end - (start + size));
+		}
+		return (void*)start;
+	}
+
+	bool Memory::Commit(void* address, size_t size)
+	{
+		return mprotect(address, size, PROT_READ | PROT_WRITE) == 0;
+	}
+
+	void Memory::Decommit(void* address, size_t size)
+	{
+		// Private anonymous pages are zero-filled when touched again
+		madvise(address, size, MADV_DONTNEED);
+		mprotect(address, size, PROT_NONE);
+	}
+
+	void Memory::AdviseHugePages(void* address, size_t size)
+	{
+#ifdef MADV_HUGEPAGE
+		madvise(address, size, MADV_HUGEPAGE);
+#endif
+	}
+
+	void* Memory::AllocatePages(size_t size)
+	{
+		auto address = mmap(nullptr, size, PROT_READ | PROT_WRITE, MAP_PRIVATE | MAP_ANONYMOUS, -1, 0);
+		return address == MAP_FAILED ? nullptr : address;
+	}
+
+	void Memory::FreePages(void* address, size_t size)
+	{
+		munmap(address, size);
+	}
 #endif
 }
\ No newline at end of file
@@ -20,6 +20,10 @@
 // OF THE POSSIBILITY OF SUCH DAMAGE.
 
 #include "Common.h"
+#include <string.h>
+#if defined(GCIX_SIMD_SSE2)
+#include <emmintrin.h>
+#endif
 
 namespace gcix
 {
@@ -52,6 +56,42 @@ namespace gcix
 
 		static void Initialize();
 
+		/**
+		Reserves a range of virtual memory without committing it.
+		@param size Size in bytes of the range, multiple of the page size
+		@param alignment Alignment of the range, power of two multiple of the page size
+		@return the address of the range or `nullptr` in case of an out of memory
+		*/
+		static void* Reserve(size_t size, size_t alignment);
+
+		/**
+		Commits a range of reserved memory. The memory is zeroed by the OS when it is first touched.
+		@return false in case of an out of memory
+		*/
+		static bool Commit(void* address, size_t size);
+
+		/**
+		Decommits a range of committed memory, returning its physical pages to the OS. The range can be committed again.
+		*/
+		static void Decommit(void* address, size_t size);
+
+		/**
+		Advises the OS to back a range of reserved memory with huge pages, if supported.
+		*/
+		static void AdviseHugePages(void* address, size_t size);
+
+		/**
+		Maps a range of committed memory directly from the OS, zeroed and aligned on the page size.
+		@param size Size in bytes of the range, multiple of the page size
+		@return the address of the range or `nullptr` in case of an out of memory
+		*/
+		static void* AllocatePages(size_t size);
+
+		/**
+		Unmaps a range of memory allocated by @see AllocatePages.
+		*/
+		static void FreePages(void* address, size_t size);
+
 		static inline bool IsPowerOfTwoOrZero(uint32_t value)
 		{
 			return (value & (value - 1)) == 0;
@@ -78,6 +118,47 @@ namespace gcix
 				((uint32_t*)from)[i] = 0;
 			}
 		}
+
+		/**
+		Clear/zero a large region of memory
+		*/
+		static inline void ClearLarge(void* from, size_t size)
+		{
+			memset(from, 0, size);
+		}
+
+		/**
+		Clear/zero a large region of memory, aligned on 16 bytes, with stores bypassing the cache when supported
+		*/
+		static inline void ClearNonTemporal(void* from, size_t size)
+		{
+			gcix_assert(((intptr_t)from & 15) == 0 && (size & 15) == 0);
+
+#if defined(GCIX_SIMD_SSE2)
+			auto zero = _mm_setzero_si128();
+			auto to = (__m128i*)from;
+			for (size_t i = 0; i < size / 16; i++)
+			{
+				_mm_stream_si128(to + i, zero);
+			}
+			_mm_sfence();
+#else
+			memset(from, 0, size);
+#endif
+		}
+
+		/**
+		Copy a small region of memory, aligned on 4 bytes and not overlapping
+		*/
+		static inline void CopySmall(void* to, const void* from, int size)
+		{
+			gcix_assert((size & 3) == 0);
+
+			for(int i = 0; i < size/4; i++)
+			{
+				((uint32_t*)to)[i] = ((const uint32_t*)from)[i];
+			}
+		}
 	private:
 		Memory() {}
 	};
@@ -23,6 +23,9 @@
 #include "ObjectConstants.h"
 #include "GlobalAllocator.h"
 #include "ThreadLocalAllocator.h"
+#include "Collector.h"
+#include "Utility/Histogram.h"
+#include "Tracer.h"
 
 namespace gcix
 {
@@ -44,6 +47,85 @@ namespace gcix
 		ThreadLocalAllocator::Initialize();
 	}
 
+	/**
+	Shutdown the current mutator thread. Must be called by any thread initialized with InitializeMutatorThread before it
+	terminates.
+	*/
+	void ShutdownMutatorThread()
+	{
+		gcix_assert(GlobalAllocator::Instance != nullptr);
+		ThreadLocalAllocator::Shutdown();
+	}
+
+	/**
+	Parks the current mutator thread if another thread is waiting to perform a collection. Should be called regularly by 
+	threads running long loops without allocating.
+	*/
+	void Safepoint()
+	{
+		gcix_assert(ThreadLocalAllocator::Instance != nullptr);
+		ThreadLocalAllocator::Instance->Safepoint();
+	}
+
+	/**
+	Declares that the current mutator thread is going to run native code (blocking IO, long computations...) without 
+	accessing any managed object. Collections can run concurrently with native code.
+	*/
+	void EnterNativeCode()
+	{
+		gcix_assert(ThreadLocalAllocator::Instance != nullptr);
+		ThreadLocalAllocator::Instance->EnterNativeCode();
+	}
+
+	/**
+	Declares that the current mutator thread is leaving native code. Waits for the end of the current collection if any.
+	*/
+	void LeaveNativeCode()
+	{
+		gcix_assert(ThreadLocalAllocator::Instance != nullptr);
+		ThreadLocalAllocator::Instance->LeaveNativeCode();
+	}
+
+	/**
+	Write barrier of sticky collections and concurrent marking. Must be called by the current mutator thread before storing
+	a reference into a field of a managed object.
+	@param object The managed object being modified. Cannot be null.
+	*/
+	void WriteBarrier(void* object)
+	{
+		gcix_assert(ThreadLocalAllocator::Instance != nullptr);
+		gcix_assert(object != nullptr);
+		ThreadLocalAllocator::Instance->WriteBarrier(ObjectAddress::FromUserObject(object));
+	}
+
+	/**
+	Write barrier of sticky collections and concurrent marking. Must be called by the current mutator thread before 
+	storing a reference into the specified field of a managed object.
+	@param object The managed object being modified. Cannot be null.
+	@param slot The field of the object receiving the reference. Cannot be null.
+	*/
+	void WriteBarrier(void* object, void** slot)
+	{
+		gcix_assert(ThreadLocalAllocator::Instance != nullptr);
+		gcix_assert(object != nullptr);
+		gcix_assert(slot != nullptr);
+		ThreadLocalAllocator::Instance->WriteBarrier(ObjectAddress::FromUserObject(object), slot);
+	}
+
+	/**
+	Slow path of WriteReference and WriteReferences, logs the object and the references about to be overwritten.
+	@param object The managed object being modified. Cannot be null.
+	@param slots The fields of the object receiving the references.
+	@param count The number of fields.
+	*/
+	void WriteReferencesSlow(void* object, void** slots, size_t count)
+	{
+		gcix_assert(ThreadLocalAllocator::Instance != nullptr);
+		gcix_assert(object != nullptr);
+		gcix_assert(slots != nullptr);
+		ThreadLocalAllocator::Instance->WriteBarrier(ObjectAddress::FromUserObject(object), slots, count);
+	}
+
 	/**
 	Allocates a standard size managed object.
 	@param size Size in bytes of the object. Must be > 0 and <= StandardObjectMaxSizeInBytes
@@ -60,13 +142,70 @@ namespace gcix
 
 	/**
 	Allocates a large size managed object.
-	@param size Size in bytes of the object. Must be > StandardObjectMaxSizeInBytes
+	@param size Size in bytes of the object. Must be > StandardObjectMaxSizeInBytes and <= LargeObjectMaxSizeInBytes
 	@param userClassDescriptor Pointer to the object class descriptor that will be setup on the header of the object. Cannot be
+	null.
+	@return the object or `nullptr` in case of an out of memory or if the size is above LargeObjectMaxSizeInBytes
 	*/
 	void* AllocateLargeObject(uint32_t size, void* userClassDescriptor)
 	{
 		gcix_assert(GlobalAllocator::Instance != nullptr);
 		auto objectAddress = ThreadLocalAllocator::Instance->AllocateLargeObject(size, userClassDescriptor);
-		return objectAddress->ToUserObject();
+		return objectAddress != nullptr ? objectAddress->ToUserObject() : nullptr;
+	}
+
+	/**
+	Gets the statistics of the collector. Can be called from any thread.
+	@param statistics The statistics to fill. Cannot be null.
+	*/
+	void GetStatistics(Statistics* statistics)
+	{
+		gcix_assert(Collector::Instance != nullptr);
+		gcix_assert(statistics != nullptr);
+		Collector::Instance->GetStatistics(*statistics);
+	}
+
+	/**
+	Gets the lowest duration in microseconds of a pause counted by a bucket of the pause histogram.
+	@param index Index of the bucket, lower or equal to PauseHistogramBucketCount
+	*/
+	uint64_t GetPauseHistogramBucketStart(uint32_t index)
+	{
+		return Histogram::GetBucketStart(index);
+	}
+
+	/**
+	Starts recording the events of the collections. Requires GCIX_ENABLE_TRACE.
+	@return false if the tracer is not compiled
+	*/
+	bool StartTrace()
+	{
+		gcix_assert(Tracer::Instance != nullptr);
+#if (GCIX_ENABLE_TRACE == 1)
+		Tracer::Start();
+		return true;
+#else
+		return false;
+#endif
+	}
+
+	/**
+	Stops recording the events of the collections.
+	*/
+	void StopTrace()
+	{
+		Tracer::Stop();
+	}
+
+	/**
+	Writes the events recorded so far to a Chrome trace event JSON file, and removes them from the buffers.
+	@param path Path of the file to write. Cannot be null.
+	@return false if the file cannot be written
+	*/
+	bool WriteTrace(const char* path)
+	{
+		gcix_assert(Tracer::Instance != nullptr);
+		gcix_assert(path != nullptr);
+		return Tracer::Instance->Write(path);
 	}
 }
@@ -0,0 +1,81 @@
+// Copyright (c) 2014, Alexandre Mutel
+// All rights reserved.
+// 
+// Redistribution and use in source and binary forms, with or without modification, are permitted provided that the following
+// conditions are met:
+// 
+// 1. Redistributions of source code must retain the above copyright notice, this list of conditions and the following 
+//    disclaimer.
+// 
+// 2. Redistributions in binary form must reproduce the above copyright notice, this list of conditions and the following 
+//    disclaimer in the documentation and/or other materials provided with the distribution.
+// 
+// THIS SOFTWARE IS PROVIDED BY THE COPYRIGHT HOLDERS AND CONTRIBUTORS "AS IS" AND ANY EXPRESS OR IMPLIED WARRANTIES, 
+// INCLUDING, BUT NOT LIMITED TO, THE IMPLIED WARRANTIES OF MERCHANTABILITY AND FITNESS FOR A PARTICULAR PURPOSE ARE 
+// DISCLAIMED. IN NO EVENT SHALL THE COPYRIGHT HOLDER OR CONTRIBUTORS BE LIABLE FOR ANY DIRECT, INDIRECT, INCIDENTAL, SPECIAL, 
+// EXEMPLARY, OR CONSEQUENTIAL DAMAGES (INCLUDING, BUT NOT LIMITED TO, PROCUREMENT OF SUBSTITUTE GOODS OR SERVICES; LOSS OF 
+// USE, DATA, OR PROFITS; OR BUSINESS INTERRUPTION) HOWEVER CAUSED AND ON ANY THEORY OF LIABILITY, WHETHER IN CONTRACT, STRICT 
+// LIABILITY, OR TORT (INCLUDING NEGLIGENCE OR OTHERWISE) ARISING IN ANY WAY OUT OF THE USE OF THIS SOFTWARE, EVEN IF ADVISED 
+// OF THE POSSIBILITY OF SUCH DAMAGE.
+
+#include "gcix-bench.h"
+
+namespace gcix
+{
+	/**
+	Node of the lists allocated by the churn benchmark, with one reference.
+	*/
+	struct ChurnNode
+	{
+		void* ClassDescriptor;
+		ChurnNode* Next;
+		uint32_t Value;
+	};
+
+	static void* ChurnNodeClass[1] = { (void*)(intptr_t)(1 * 2 + 1) };
+
+	static const uint32_t ChurnWindowCount = 256;
+
+	/** A window of the last lists allocated by a thread */
+	static void* ChurnWindowClass[1] = { (void*)(intptr_t)(ChurnWindowCount * 2 + 1) };
+
+	static void RunChurn(uint32_t threadIndex, void* context)
+	{
+		const uint32_t ListCount = 200000;
+		auto scale = *(uint32_t*)context;
+
+		Random random(threadIndex + 1);
+		auto volatile window = (void**)NewObject((ChurnWindowCount + 1) * sizeof(void*), ChurnWindowClass);
+		auto lists = (ChurnNode**)(window + 1);
+
+		for (uint32_t i = 0; i < ListCount * scale; i++)
+		{
+			// Short lists of small objects, like the temporaries of a request
+			ChurnNode* list = nullptr;
+			auto length = 1 + random.Next(32);
+			for (uint32_t j = 0; j < length; j++)
+			{
+				auto node = (ChurnNode*)NewObject(sizeof(ChurnNode) + random.Next(64), ChurnNodeClass);
+				node->Next = list;
+				node->Value = j;
+				list = node;
+			}
+
+			// Most lists die immediately, a few stay alive until replaced in the window
+			if ((i & 7) == 0)
+			{
+				SetReference(window, lists[random.Next(ChurnWindowCount)], list);
+			}
+		}
+	}
+
+	/**
+	Multi-threaded allocation churn: each thread allocates short lived lists, keeping a small window of them alive, so 
+	that collections are triggered by all the threads and must stop all of them.
+	*/
+	GCIX_BENCHMARK(AllocationChurn)
+	{
+		auto scale = options.Scale;
+		RunThreads(options.ThreadCount, RunChurn, &scale);
+	}
+}
@@ -0,0 +1,77 @@
+// Copyright (c) 2014, Alexandre Mutel
+// All rights reserved.
+// 
+// Redistribution and use in source and binary forms, with or without modification, are permitted provided that the following
+// conditions are met:
+// 
+// 1. Redistributions of source code must retain the above copyright notice, this list of conditions and the following 
+//    disclaimer.
+// 
+// 2. Redistributions in binary form must reproduce the above copyright notice, this list of conditions and the following 
+//    disclaimer in the documentation and/or other materials provided with the distribution.
+// 
+// THIS SOFTWARE IS PROVIDED BY THE COPYRIGHT HOLDERS AND CONTRIBUTORS "AS IS" AND ANY EXPRESS OR IMPLIED WARRANTIES, 
+// INCLUDING, BUT NOT LIMITED TO, THE IMPLIED WARRANTIES OF MERCHANTABILITY AND FITNESS FOR A PARTICULAR PURPOSE ARE 
+// DISCLAIMED. IN NO EVENT SHALL THE COPYRIGHT HOLDER OR CONTRIBUTORS BE LIABLE FOR ANY DIRECT, INDIRECT, INCIDENTAL, SPECIAL, 
+// EXEMPLARY, OR CONSEQUENTIAL DAMAGES (INCLUDING, BUT NOT LIMITED TO, PROCUREMENT OF SUBSTITUTE GOODS OR SERVICES; LOSS OF 
+// USE, DATA, OR PROFITS; OR BUSINESS INTERRUPTION) HOWEVER CAUSED AND ON ANY THEORY OF LIABILITY, WHETHER IN CONTRACT, STRICT 
+// LIABILITY, OR TORT (INCLUDING NEGLIGENCE OR OTHERWISE) ARISING IN ANY WAY OUT OF THE USE OF THIS SOFTWARE, EVEN IF ADVISED 
+// OF THE POSSIBILITY OF SUCH DAMAGE.
+
+#include "gcix-bench.h"
+
+namespace gcix
+{
+	/**
+	Node of the binary trees benchmark (Computer Language Benchmarks Game).
+	*/
+	struct TreeNode
+	{
+		void* ClassDescriptor;
+		TreeNode* Left;
+		TreeNode* Right;
+	};
+
+	static void* TreeNodeClass[1] = { (void*)(intptr_t)(2 * 2 + 1) };
+
+	static const int32_t BinaryTreesMaxDepth = 16;
+
+	static TreeNode* BottomUpTree(int32_t depth)
+	{
+		auto node = (TreeNode*)NewObject(sizeof(TreeNode), TreeNodeClass);
+		if (depth > 0)
+		{
+			// The node may have survived a collection while allocating its children
+			SetReference(node, node->Left, BottomUpTree(depth - 1));
+			SetReference(node, node->Right, BottomUpTree(depth - 1));
+		}
+		return node;
+	}
+
+	static int32_t ItemCheck(TreeNode* node)
+	{
+		return node->Left == nullptr ? 1 : 1 + ItemCheck(node->Left) + ItemCheck(node->Right);
+	}
+
+	/**
+	Binary trees: many short lived complete trees of increasing depths, while a long lived tree stays alive.
+	*/
+	GCIX_BENCHMARK(BinaryTrees)
+	{
+		auto maxDepth = BinaryTreesMaxDepth + (int32_t)options.Scale - 1;
+		int64_t check = ItemCheck(BottomUpTree(maxDepth + 1));
+
+		auto volatile longLivedTree = BottomUpTree(maxDepth);
+		for (int32_t depth = 4; depth <= maxDepth; depth += 2)
+		{
+			auto iterationCount = 1 << (maxDepth - depth + 4);
+			for (int32_t i = 0; i < iterationCount; i++)
+			{
+				check += ItemCheck(BottomUpTree(depth));
+			}
+		}
+		check += ItemCheck(longLivedTree);
+
+		AddMetric("check", (double)check);
+	}
+}
@@ -0,0 +1,76 @@
+// Copyright (c) 2014, Alexandre Mutel
+// All rights reserved.
+// 
+// Redistribution and use in source and binary forms, with or without modification, are permitted provided that the following
+// conditions are met:
+// 
+// 1. Redistributions of source code must retain the above copyright notice, this list of conditions and the following 
+//    disclaimer.
+// 
+// 2. Redistributions in binary form must reproduce the above copyright notice, this list of conditions and the following 
+//    disclaimer in the documentation and/or other materials provided with the distribution.
+// 
+// THIS SOFTWARE IS PROVIDED BY THE COPYRIGHT HOLDERS AND CONTRIBUTORS "AS IS" AND ANY EXPRESS OR IMPLIED WARRANTIES, 
+// INCLUDING, BUT NOT LIMITED TO, THE IMPLIED WARRANTIES OF MERCHANTABILITY AND FITNESS FOR A PARTICULAR PURPOSE ARE 
+// DISCLAIMED. IN NO EVENT SHALL THE COPYRIGHT HOLDER OR CONTRIBUTORS BE LIABLE FOR ANY DIRECT, INDIRECT, INCIDENTAL, SPECIAL, 
+// EXEMPLARY, OR CONSEQUENTIAL DAMAGES (INCLUDING, BUT NOT LIMITED TO, PROCUREMENT OF SUBSTITUTE GOODS OR SERVICES; LOSS OF 
+// USE, DATA, OR PROFITS; OR BUSINESS INTERRUPTION) HOWEVER CAUSED AND ON ANY THEORY OF LIABILITY, WHETHER IN CONTRACT, STRICT 
+// LIABILITY, OR TORT (INCLUDING NEGLIGENCE OR OTHERWISE) ARISING IN ANY WAY OUT OF THE USE OF THIS SOFTWARE, EVEN IF ADVISED 
+// OF THE POSSIBILITY OF SUCH DAMAGE.
+
+#include "gcix-bench.h"
+
+namespace gcix
+{
+	/**
+	An object of a random size referenced by the slots of the fragmentation benchmark, without any reference.
+	*/
+	struct FragmentationObject
+	{
+		void* ClassDescriptor;
+		uint32_t Size;
+	};
+
+	static void* FragmentationObjectClass[1] = { nullptr };
+
+	static const uint32_t FragmentationSlotCount = 1 << 16;
+
+	/** A large object holding FragmentationSlotCount references */
+	static void* FragmentationSlotsClass[1] = { (void*)(intptr_t)(FragmentationSlotCount * 2 + 1) };
+
+	/**
+	Fragmentation stress: a table of objects of random sizes (16 bytes to 2 KB) where random slots are replaced, so that 
+	surviving objects are scattered across the lines of all the blocks and allocation has to fill small holes.
+	*/
+	GCIX_BENCHMARK(Fragmentation)
+	{
+		const uint32_t ReplaceCount = 4000000;
+
+		Random random(12345);
+		auto volatile table = (void**)NewObject((FragmentationSlotCount + 1) * sizeof(void*), FragmentationSlotsClass);
+		auto slots = table + 1;
+
+		for (uint32_t i = 0; i < FragmentationSlotCount; i++)
+		{
+			auto size = 16 + random.Next(2048 - 16);
+			auto object = (FragmentationObject*)NewObject(size, FragmentationObjectClass);
+			object->Size = size;
+			SetReference(table, slots[i], (void*)object);
+		}
+
+		uint64_t checkedSize = 0;
+		for (uint32_t i = 0; i < ReplaceCount * options.Scale; i++)
+		{
+			// Mostly small objects, with a few medium ones overflowing the holes
+			auto size = (random.Next() & 15) == 0 ? 256 + random.Next(2048 - 256) : 16 + random.Next(128 - 16);
+			auto object = (FragmentationObject*)NewObject(size, FragmentationObjectClass);
+			object->Size = size;
+
+			auto slot = random.Next(FragmentationSlotCount);
+			checkedSize += ((FragmentationObject*)slots[slot])->Size;
+			SetReference(table, slots[slot], (void*)object);
+		}
+
+		AddMetric("check", (double)checkedSize);
+	}
+}
@@ -0,0 +1,140 @@
+// Copyright (c) 2014, Alexandre Mutel
+// All rights reserved.
+// 
+// Redistribution and use in source and binary forms, with or without modification, are permitted provided that the following
+// conditions are met:
+// 
+// 1. Redistributions of source code must retain the above copyright notice, this list of conditions and the following 
+//    disclaimer.
+// 
+// 2. Redistributions in binary form must reproduce the above copyright notice, this list of conditions and the following 
+//    disclaimer in the documentation and/or other materials provided with the distribution.
+// 
+// THIS SOFTWARE IS PROVIDED BY THE COPYRIGHT HOLDERS AND CONTRIBUTORS "AS IS" AND ANY EXPRESS OR IMPLIED WARRANTIES, 
+// INCLUDING, BUT NOT LIMITED TO, THE IMPLIED WARRANTIES OF MERCHANTABILITY AND FITNESS FOR A PARTICULAR PURPOSE ARE 
+// DISCLAIMED. IN NO EVENT SHALL THE COPYRIGHT HOLDER OR CONTRIBUTORS BE LIABLE FOR ANY DIRECT, INDIRECT, INCIDENTAL, SPECIAL, 
+// EXEMPLARY, OR CONSEQUENTIAL DAMAGES (INCLUDING, BUT NOT LIMITED TO, PROCUREMENT OF SUBSTITUTE GOODS OR SERVICES; LOSS OF 
+// USE, DATA, OR PROFITS; OR BUSINESS INTERRUPTION) HOWEVER CAUSED AND ON ANY THEORY OF LIABILITY, WHETHER IN CONTRACT, STRICT 
+// LIABILITY, OR TORT (INCLUDING NEGLIGENCE OR OTHERWISE) ARISING IN ANY WAY OUT OF THE USE OF THIS SOFTWARE, EVEN IF ADVISED 
+// OF THE POSSIBILITY OF SUCH DAMAGE.
+
+#include "gcix-bench.h"
+
+namespace gcix
+{
+	/**
+	Node of the trees of GCBench (Boehm, Demers, Ellis), with two references.
+	*/
+	struct GCBenchNode
+	{
+		void* ClassDescriptor;
+		GCBenchNode* Left;
+		GCBenchNode* Right;
+		int32_t I;
+		int32_t J;
+	};
+
+	static void* GCBenchNodeClass[1] = { (void*)(intptr_t)(2 * 2 + 1) };
+
+	/** An array of doubles, without any reference */
+	static void* GCBenchArrayClass[1] = { nullptr };
+
+	static const int32_t StretchTreeDepth = 18;
+	static const int32_t LongLivedTreeDepth = 16;
+	static const int32_t ArraySize = 500000;
+	static const int32_t MinTreeDepth = 4;
+	static const int32_t MaxTreeDepth = 16;
+
+	static GCBenchNode* NewGCBenchNode(GCBenchNode* left, GCBenchNode* right)
+	{
+		auto node = (GCBenchNode*)NewObject(sizeof(GCBenchNode), GCBenchNodeClass);
+		node->Left = left;
+		node->Right = right;
+		return node;
+	}
+
+	/** Number of nodes of a complete binary tree of the specified depth */
+	static int32_t TreeSize(int32_t depth)
+	{
+		return (1 << (depth + 1)) - 1;
+	}
+
+	/** Number of trees of the specified depth allocated by an iteration */
+	static int32_t IterationCount(int32_t depth)
+	{
+		return 2 * TreeSize(StretchTreeDepth) / TreeSize(depth);
+	}
+
+	/** Builds a tree top down, storing references into nodes already allocated */
+	static void Populate(int32_t depth, GCBenchNode* node)
+	{
+		if (depth <= 0)
+		{
+			return;
+		}
+
+		depth--;
+		SetReference(node, node->Left, NewGCBenchNode(nullptr, nullptr));
+		SetReference(node, node->Right, NewGCBenchNode(nullptr, nullptr));
+		Populate(depth, node->Left);
+		Populate(depth, node->Right);
+	}
+
+	/** Builds a tree bottom up, only storing references into new nodes */
+	static GCBenchNode* MakeTree(int32_t depth)
+	{
+		if (depth <= 0)
+		{
+			return NewGCBenchNode(nullptr, nullptr);
+		}
+		return NewGCBenchNode(MakeTree(depth - 1), MakeTree(depth - 1));
+	}
+
+	static void TimeConstruction(int32_t depth)
+	{
+		auto iterationCount = IterationCount(depth);
+		for (int32_t i = 0; i < iterationCount; i++)
+		{
+			auto tempTree = NewGCBenchNode(nullptr, nullptr);
+			Populate(depth, tempTree);
+		}
+		for (int32_t i = 0; i < iterationCount; i++)
+		{
+			MakeTree(depth);
+		}
+	}
+
+	/**
+	GCBench: temporary trees of increasing depths built top down and bottom up, while a long lived tree and a large 
+	array of doubles stay alive.
+	*/
+	GCIX_BENCHMARK(GCBench)
+	{
+		for (uint32_t run = 0; run < options.Scale; run++)
+		{
+			// Stretch the heap
+			MakeTree(StretchTreeDepth);
+
+			// Long lived objects, referenced from the stack
+			auto volatile longLivedTree = NewGCBenchNode(nullptr, nullptr);
+			Populate(LongLivedTreeDepth, longLivedTree);
+			auto volatile array = (double*)NewObject(sizeof(void*) + ArraySize * sizeof(double), GCBenchArrayClass);
+			auto values = (double*)((intptr_t)array + sizeof(void*));
+			for (int32_t i = 0; i < ArraySize / 2; i++)
+			{
+				values[i] = 1.0 / i;
+			}
+
+			for (int32_t depth = MinTreeDepth; depth <= MaxTreeDepth; depth += 2)
+			{
+				TimeConstruction(depth);
+			}
+
+			// Keep the long lived objects alive until the end
+			if (longLivedTree->Left == nullptr || values[1000] != 1.0 / 1000)
+			{
+				AddMetric("failed", 1);
+			}
+		}
+	}
+}
@@ -0,0 +1,59 @@
+// Copyright (c) 2014, Alexandre Mutel
+// All rights reserved.
+// 
+// Redistribution and use in source and binary forms, with or without modification, are permitted provided that the following
+// conditions are met:
+// 
+// 1. Redistributions of source code must retain the above copyright notice, this list of conditions and the following 
+//    disclaimer.
+// 
+// 2. Redistributions in binary form must reproduce the above copyright notice, this list of conditions and the following 
+//    disclaimer in the documentation and/or other materials provided with the distribution.
+// 
+// THIS SOFTWARE IS PROVIDED BY THE COPYRIGHT HOLDERS AND CONTRIBUTORS "AS IS" AND ANY EXPRESS OR IMPLIED WARRANTIES, 
+// INCLUDING, BUT NOT LIMITED TO, THE IMPLIED WARRANTIES OF MERCHANTABILITY AND FITNESS FOR A PARTICULAR PURPOSE ARE 
+// DISCLAIMED. IN NO EVENT SHALL THE COPYRIGHT HOLDER OR CONTRIBUTORS BE LIABLE FOR ANY DIRECT, INDIRECT, INCIDENTAL, SPECIAL, 
+// EXEMPLARY, OR CONSEQUENTIAL DAMAGES (INCLUDING, BUT NOT LIMITED TO, PROCUREMENT OF SUBSTITUTE GOODS OR SERVICES; LOSS OF 
+// USE, DATA, OR PROFITS; OR BUSINESS INTERRUPTION) HOWEVER CAUSED AND ON ANY THEORY OF LIABILITY, WHETHER IN CONTRACT, STRICT 
+// LIABILITY, OR TORT (INCLUDING NEGLIGENCE OR OTHERWISE) ARISING IN ANY WAY OUT OF THE USE OF THIS SOFTWARE, EVEN IF ADVISED 
+// OF THE POSSIBILITY OF SUCH DAMAGE.
+
+#include "gcix-bench.h"
+
+namespace gcix
+{
+	/** A large object without any reference */
+	static void* LargeChurnObjectClass[1] = { nullptr };
+
+	static const uint32_t LargeChurnWindowCount = 16;
+
+	/** A window of the last large objects allocated */
+	static void* LargeChurnWindowClass[1] = { (void*)(intptr_t)(LargeChurnWindowCount * 2 + 1) };
+
+	/**
+	Large object churn: large objects of random sizes (16 KB to 4 MB, most of them below 256 KB) allocated and freed, 
+	with a small window of them staying alive.
+	*/
+	GCIX_BENCHMARK(LargeObjectChurn)
+	{
+		const uint32_t ObjectCount = 10000;
+
+		Random random(4321);
+		auto volatile window = (void**)NewObject((LargeChurnWindowCount + 1) * sizeof(void*), LargeChurnWindowClass);
+		auto objects = window + 1;
+
+		for (uint32_t i = 0; i < ObjectCount * options.Scale; i++)
+		{
+			auto size = (random.Next() & 31) == 0 ? (1 << 20) + random.Next(3 << 20) : 
+				StandardObjectMaxSizeInBytes + 1 + random.Next(256 << 10);
+			auto object = (void**)NewObject(size, LargeChurnObjectClass);
+
+			// Touch the object like a buffer being filled, after its class descriptor
+			auto values = (uint32_t*)(object + 1);
+			values[0] = i;
+			values[(size - sizeof(void*)) / sizeof(uint32_t) - 1] = i;
+
+			SetReference(window, objects[random.Next(LargeChurnWindowCount)], (void*)object);
+		}
+	}
+}
@@ -0,0 +1,166 @@
+// Copyright (c) 2014, Alexandre Mutel
+// All rights reserved.
+// 
+// Redistribution and use in source and binary forms, with or without modification, are permitted provided that the following
+// conditions are met:
+// 
+// 1. Redistributions of source code must retain the above copyright notice, this list of conditions and the following 
+//    disclaimer.
+// 
+// 2. Redistributions in binary form must reproduce the above copyright notice, this list of conditions and the following 
+//    disclaimer in the documentation and/or other materials provided with the distribution.
+// 
+// THIS SOFTWARE IS PROVIDED BY THE COPYRIGHT HOLDERS AND CONTRIBUTORS "AS IS" AND ANY EXPRESS OR IMPLIED WARRANTIES, 
+// INCLUDING, BUT NOT LIMITED TO, THE IMPLIED WARRANTIES OF MERCHANTABILITY AND FITNESS FOR A PARTICULAR PURPOSE ARE 
+// DISCLAIMED. IN NO EVENT SHALL THE COPYRIGHT HOLDER OR CONTRIBUTORS BE LIABLE FOR ANY DIRECT, INDIRECT, INCIDENTAL, SPECIAL, 
+// EXEMPLARY, OR CONSEQUENTIAL DAMAGES (INCLUDING, BUT NOT LIMITED TO, PROCUREMENT OF SUBSTITUTE GOODS OR SERVICES; LOSS OF 
+// USE, DATA, OR PROFITS; OR BUSINESS INTERRUPTION) HOWEVER CAUSED AND ON ANY THEORY OF LIABILITY, WHETHER IN CONTRACT, STRICT 
+// LIABILITY, OR TORT (INCLUDING NEGLIGENCE OR OTHERWISE) ARISING IN ANY WAY OUT OF THE USE OF THIS SOFTWARE, EVEN IF ADVISED 
+// OF THE POSSIBILITY OF SUCH DAMAGE.
+
+#include "gcix-bench.h"
+
+#include "LineMask.h"
+
+#include <chrono>
+#include <string.h>
+
+namespace gcix
+{
+	static const int32_t LineMaskBlockCount = 1024;
+
+	static LineFlags LineMaskFragmentedFlags[LineMaskBlockCount][Constants::LineCount];
+	static LineFlags LineMaskFlags[LineMaskBlockCount][Constants::LineCount];
+	static uint32_t LineMaskMasks[LineMaskBlockCount][LineMask::WordCount];
+
+	/**
+	Scalar line mask extraction, visiting the line flags one by one.
+	*/
+	static void ExtractMarkedLinesScalar(LineFlags* lineFlags, uint32_t* mask)
+	{
+		auto flags = (uint8_t*)lineFlags;
+		for (uint32_t i = 0; i < LineMask::WordCount; i++)
+		{
+			uint32_t value = 0;
+			for (uint32_t j = 0; j < 32; j++)
+			{
+				value |= (uint32_t)(flags[i * 32 + j] & (uint8_t)LineFlags::Marked) << j;
+				flags[i * 32 + j] &= ~(uint8_t)LineFlags::Marked;
+			}
+			mask[i] = value;
+		}
+	}
+
+	/**
+	Scalar hole search, visiting the bits of the line mask one by one.
+	*/
+	static bool FindHoleScalar(const uint32_t* mask, uint32_t fromLine, uint32_t lineCount, uint32_t& holeStart, 
+		uint32_t& holeEnd)
+	{
+		uint32_t start = Constants::LineCount;
+		for (uint32_t i = fromLine; i <= Constants::LineCount; i++)
+		{
+			if (i == Constants::LineCount || (mask[i >> 5] & (1u << (i & 31))) != 0)
+			{
+				if (start != Constants::LineCount && (i - start) >= lineCount)
+				{
+					holeStart = start;
+					holeEnd = i;
+					return true;
+				}
+				start = Constants::LineCount;
+			}
+			else if (start == Constants::LineCount)
+			{
+				start = i;
+			}
+		}
+		return false;
+	}
+
+	static double ElapsedMilliseconds(std::chrono::steady_clock::time_point start)
+	{
+		return std::chrono::duration<double, std::milli>(std::chrono::steady_clock::now() - start).count();
+	}
+
+	/**
+	Line mask operations of the recycle and the allocation on fragmented blocks (half of the lines marked at random): 
+	extraction of the marked lines and search of all the holes, scalar versus @see LineMask (SSE2/AVX2 extraction, bit 
+	scan hole search). Reports the time of each variant in milliseconds.
+	*/
+	GCIX_BENCHMARK(LineMask)
+	{
+		const uint32_t IterationCount = 200;
+
+		Random random(4321);
+		for (int32_t block = 0; block < LineMaskBlockCount; block++)
+		{
+			for (uint32_t i = 0; i < Constants::LineCount; i++)
+			{
+				auto isUsed = i < Constants::HeaderLineCount || random.Next(100) < 50;
+				LineMaskFragmentedFlags[block][i] = isUsed ? 
+					(LineFlags)((uint8_t)LineFlags::Marked | (uint8_t)LineFlags::ContainsObject) : LineFlags::Empty;
+			}
+		}
+
+		uint64_t scalarCheck = 0;
+		uint64_t check = 0;
+		double scalarExtractMs = 0;
+		double extractMs = 0;
+		double scalarFindHoleMs = 0;
+		double findHoleMs = 0;
+		uint32_t holeStart;
+		uint32_t holeEnd;
+
+		for (uint32_t iteration = 0; iteration < IterationCount * options.Scale; iteration++)
+		{
+			memcpy(LineMaskFlags, LineMaskFragmentedFlags, sizeof(LineMaskFlags));
+			auto start = std::chrono::steady_clock::now();
+			for (int32_t block = 0; block < LineMaskBlockCount; block++)
+			{
+				ExtractMarkedLinesScalar(LineMaskFlags[block], LineMaskMasks[block]);
+			}
+			scalarExtractMs += ElapsedMilliseconds(start);
+
+			start = std::chrono::steady_clock::now();
+			for (int32_t block = 0; block < LineMaskBlockCount; block++)
+			{
+				for (uint32_t line = Constants::HeaderLineCount; 
+					FindHoleScalar(LineMaskMasks[block], line, 1, holeStart, holeEnd); line = holeEnd)
+				{
+					scalarCheck += holeStart;
+				}
+			}
+			scalarFindHoleMs += ElapsedMilliseconds(start);
+
+			memcpy(LineMaskFlags, LineMaskFragmentedFlags, sizeof(LineMaskFlags));
+			start = std::chrono::steady_clock::now();
+			for (int32_t block = 0; block < LineMaskBlockCount; block++)
+			{
+				LineMask::ExtractMarkedLines(LineMaskFlags[block], LineMaskMasks[block]);
+			}
+			extractMs += ElapsedMilliseconds(start);
+
+			start = std::chrono::steady_clock::now();
+			for (int32_t block = 0; block < LineMaskBlockCount; block++)
+			{
+				for (uint32_t line = Constants::HeaderLineCount; 
+					LineMask::FindHole(LineMaskMasks[block], line, 1, holeStart, holeEnd); line = holeEnd)
+				{
+					check += holeStart;
+				}
+			}
+			findHoleMs += ElapsedMilliseconds(start);
+		}
+
+		if (check != scalarCheck)
+		{
+			AddMetric("failed", 1);
+		}
+		AddMetric("scalarExtractMs", scalarExtractMs);
+		AddMetric("extractMs", extractMs);
+		AddMetric("scalarFindHoleMs", scalarFindHoleMs);
+		AddMetric("findHoleMs", findHoleMs);
+		AddMetric("check", (double)check);
+	}
+}
@@ -0,0 +1,93 @@
+// Copyright (c) 2014, Alexandre Mutel
+// All rights reserved.
+// 
+// Redistribution and use in source and binary forms, with or without modification, are permitted provided that the following
+// conditions are met:
+// 
+// 1. Redistributions of source code must retain the above copyright notice, this list of conditions and the following 
+//    disclaimer.
+// 
+// 2. Redistributions in binary form must reproduce the above copyright notice, this list of conditions and the following 
+//    disclaimer in the documentation and/or other materials provided with the distribution.
+// 
+// THIS SOFTWARE IS PROVIDED BY THE COPYRIGHT HOLDERS AND CONTRIBUTORS "AS IS" AND ANY EXPRESS OR IMPLIED WARRANTIES, 
+// INCLUDING, BUT NOT LIMITED TO, THE IMPLIED WARRANTIES OF MERCHANTABILITY AND FITNESS FOR A PARTICULAR PURPOSE ARE 
+// DISCLAIMED. IN NO EVENT SHALL THE COPYRIGHT HOLDER OR CONTRIBUTORS BE LIABLE FOR ANY DIRECT, INDIRECT, INCIDENTAL, SPECIAL, 
+// EXEMPLARY, OR CONSEQUENTIAL DAMAGES (INCLUDING, BUT NOT LIMITED TO, PROCUREMENT OF SUBSTITUTE GOODS OR SERVICES; LOSS OF 
+// USE, DATA, OR PROFITS; OR BUSINESS INTERRUPTION) HOWEVER CAUSED AND ON ANY THEORY OF LIABILITY, WHETHER IN CONTRACT, STRICT 
+// LIABILITY, OR TORT (INCLUDING NEGLIGENCE OR OTHERWISE) ARISING IN ANY WAY OUT OF THE USE OF THIS SOFTWARE, EVEN IF ADVISED 
+// OF THE POSSIBILITY OF SUCH DAMAGE.
+
+#include "gcix-bench.h"
+
+namespace gcix
+{
+	/**
+	An object referenced from the stack by the stack scan benchmark, without any reference.
+	*/
+	struct StackObject
+	{
+		void* ClassDescriptor;
+		uint32_t Depth;
+	};
+
+	static void* StackObjectClass[1] = { nullptr };
+
+	static const int32_t StackDepth = 2000;
+	static const int32_t StackObjectCountPerFrame = 8;
+
+	/** Allocates garbage until the specified number of collections have been performed */
+	static gcix_bench_noinline void Collect(uint64_t collectionCount)
+	{
+		auto target = GetCollectionCount() + collectionCount;
+		while (GetCollectionCount() < target)
+		{
+			for (int32_t i = 0; i < 4096; i++)
+			{
+				NewObject(64, StackObjectClass);
+			}
+		}
+	}
+
+	/** Recurses with frames holding references to objects and values that are not references */
+	static gcix_bench_noinline uint32_t Recurse(int32_t depth, uint64_t collectionCount)
+	{
+		void* volatile objects[StackObjectCountPerFrame];
+		volatile intptr_t values[StackObjectCountPerFrame];
+		for (int32_t i = 0; i < StackObjectCountPerFrame; i++)
+		{
+			auto object = (StackObject*)NewObject(sizeof(StackObject), StackObjectClass);
+			object->Depth = depth;
+			objects[i] = object;
+			values[i] = (intptr_t)object ^ 0x5555;
+		}
+
+		uint32_t check = 0;
+		if (depth > 0)
+		{
+			check += Recurse(depth - 1, collectionCount);
+		}
+		else
+		{
+			Collect(collectionCount);
+		}
+
+		for (int32_t i = 0; i < StackObjectCountPerFrame; i++)
+		{
+			check += ((StackObject*)objects[i])->Depth == (uint32_t)depth ? 1 : 0;
+			check += values[i] != 0 ? 1 : 0;
+		}
+		return check;
+	}
+
+	/**
+	Conservative stack scan: collections of a small heap while the stack is deep (2000 frames holding references and
+	integers). See the average stack scan time of the collections.
+	*/
+	GCIX_BENCHMARK(StackScan)
+	{
+		const uint64_t CollectionCount = 50;
+		auto check = Recurse(StackDepth, CollectionCount * options.Scale);
+		AddMetric("check", check);
+	}
+}
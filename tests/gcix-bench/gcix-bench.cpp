@@ -0,0 +1,299 @@
+// Copyright (c) 2014, Alexandre Mutel
+// All rights reserved.
+// 
+// Redistribution and use in source and binary forms, with or without modification, are permitted provided that the following
+// conditions are met:
+// 
+// 1. Redistributions of source code must retain the above copyright notice, this list of conditions and the following 
+//    disclaimer.
+// 
+// 2. Redistributions in binary form must reproduce the above copyright notice, this list of conditions and the following 
+//    disclaimer in the documentation and/or other materials provided with the distribution.
+// 
+// THIS SOFTWARE IS PROVIDED BY THE COPYRIGHT HOLDERS AND CONTRIBUTORS "AS IS" AND ANY EXPRESS OR IMPLIED WARRANTIES, 
+// INCLUDING, BUT NOT LIMITED TO, THE IMPLIED WARRANTIES OF MERCHANTABILITY AND FITNESS FOR A PARTICULAR PURPOSE ARE 
+// DISCLAIMED. IN NO EVENT SHALL THE COPYRIGHT HOLDER OR CONTRIBUTORS BE LIABLE FOR ANY DIRECT, INDIRECT, INCIDENTAL, SPECIAL, 
+// EXEMPLARY, OR CONSEQUENTIAL DAMAGES (INCLUDING, BUT NOT LIMITED TO, PROCUREMENT OF SUBSTITUTE GOODS OR SERVICES; LOSS OF 
+// USE, DATA, OR PROFITS; OR BUSINESS INTERRUPTION) HOWEVER CAUSED AND ON ANY THEORY OF LIABILITY, WHETHER IN CONTRACT, STRICT 
+// LIABILITY, OR TORT (INCLUDING NEGLIGENCE OR OTHERWISE) ARISING IN ANY WAY OUT OF THE USE OF THIS SOFTWARE, EVEN IF ADVISED 
+// OF THE POSSIBILITY OF SUCH DAMAGE.
+
+#include "gcix-bench.h"
+
+#include <algorithm>
+#include <atomic>
+#include <chrono>
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+#include <thread>
+#include <vector>
+
+#ifdef _WIN32
+#define WIN32_LEAN_AND_MEAN 1
+#include <Windows.h>
+#include <Psapi.h>
+#pragma comment(lib, "psapi.lib")
+#define bench_thread_local __declspec(thread)
+#else
+#include <sys/resource.h>
+#define bench_thread_local thread_local
+#endif
+
+namespace gcix
+{
+	struct BenchmarkEntry
+	{
+		const char* Name;
+		BenchmarkDelegate Run;
+	};
+
+	struct Metric
+	{
+		const char* Name;
+		double Value;
+	};
+
+	static std::vector<BenchmarkEntry>& GetBenchmarks()
+	{
+		static std::vector<BenchmarkEntry> benchmarks;
+		return benchmarks;
+	}
+
+	BenchmarkRegistration::BenchmarkRegistration(const char* name, BenchmarkDelegate run)
+	{
+		BenchmarkEntry entry = { name, run };
+		GetBenchmarks().push_back(entry);
+	}
+
+	/* Bytes allocated by the calling thread, not yet added to allocatedBytes */
+	static bench_thread_local uint64_t threadAllocatedBytes;
+
+	/* Bytes allocated by all the threads of the running benchmark */
+	static std::atomic<uint64_t> allocatedBytes;
+
+	/* Metrics specific to the running benchmark */
+	static std::vector<Metric> metrics;
+
+	void AddAllocatedBytes(uint64_t size)
+	{
+		threadAllocatedBytes += size;
+	}
+
+	static void FlushAllocatedBytes()
+	{
+		allocatedBytes += threadAllocatedBytes;
+		threadAllocatedBytes = 0;
+	}
+
+	void AddMetric(const char* name, double value)
+	{
+		Metric metric = { name, value };
+		metrics.push_back(metric);
+	}
+
+	void RunThreads(uint32_t threadCount, ThreadDelegate run, void* context)
+	{
+		std::vector<std::thread> threads;
+		for (uint32_t i = 0; i < threadCount; i++)
+		{
+			threads.push_back(std::thread([=]()
+			{
+				InitializeMutatorThread();
+				run(i, context);
+				FlushAllocatedBytes();
+				ShutdownMutatorThread();
+			}));
+		}
+
+		EnterNativeCode();
+		for (auto& thread : threads)
+		{
+			thread.join();
+		}
+		LeaveNativeCode();
+	}
+
+	/**
+	Returns the peak resident set size of the process in bytes.
+	*/
+	static uint64_t GetPeakResidentSetSize()
+	{
+#ifdef _WIN32
+		PROCESS_MEMORY_COUNTERS counters;
+		if (::GetProcessMemoryInfo(::GetCurrentProcess(), &counters, sizeof(counters)))
+		{
+			return counters.PeakWorkingSetSize;
+		}
+		return 0;
+#else
+		struct rusage usage;
+		if (getrusage(RUSAGE_SELF, &usage) != 0)
+		{
+			return 0;
+		}
+#if defined(__APPLE__)
+		return (uint64_t)usage.ru_maxrss;
+#else
+		return (uint64_t)usage.ru_maxrss * 1024;
+#endif
+#endif
+	}
+
+	/**
+	Returns the upper bound in microseconds of the pauses below the specified percentile, from the buckets of the pause
+	histogram counting the pauses of a run.
+	*/
+	static uint64_t GetPausePercentile(const uint64_t* histogram, uint64_t pauseCount, double percentile)
+	{
+		if (pauseCount == 0)
+		{
+			return 0;
+		}
+
+		auto target = (uint64_t)(percentile * pauseCount + 0.999999);
+		uint64_t count = 0;
+		for (uint32_t i = 0; i < PauseHistogramBucketCount; i++)
+		{
+			count += histogram[i];
+			if (count >= std::max(target, (uint64_t)1))
+			{
+				return GetPauseHistogramBucketStart(i + 1);
+			}
+		}
+		return GetPauseHistogramBucketStart(PauseHistogramBucketCount);
+	}
+
+	/**
+	Runs a benchmark and writes its results as a single line JSON object.
+	*/
+	static void RunBenchmark(const BenchmarkEntry& benchmark, const BenchmarkOptions& options)
+	{
+		Statistics before;
+		Statistics after;
+
+		allocatedBytes = 0;
+		threadAllocatedBytes = 0;
+		metrics.clear();
+
+		GetStatistics(&before);
+		auto start = std::chrono::steady_clock::now();
+
+		benchmark.Run(options);
+
+		auto end = std::chrono::steady_clock::now();
+		FlushAllocatedBytes();
+		GetStatistics(&after);
+
+		// A concurrent collection has two pauses
+		uint64_t histogram[PauseHistogramBucketCount];
+		uint64_t pauseCount = 0;
+		for (uint32_t i = 0; i < PauseHistogramBucketCount; i++)
+		{
+			histogram[i] = after.PauseHistogram[i] - before.PauseHistogram[i];
+			pauseCount += histogram[i];
+		}
+
+		auto seconds = std::chrono::duration<double>(end - start).count();
+		auto collectionCount = after.CollectionCount - before.CollectionCount;
+		auto pauseMilliseconds = (after.TotalPauseTime - before.TotalPauseTime) / 1e6;
+
+		printf("{\"benchmark\":\"%s\",\"scale\":%u,\"threads\":%u,\"seconds\":%.6f,\"allocatedBytes\":%llu,"
+			"\"throughputMBps\":%.2f,\"collections\":%llu,\"stickyCollections\":%llu,\"concurrentCollections\":%llu,"
+			"\"pauseTotalMs\":%.3f,\"pauseP50Us\":%llu,\"pauseP90Us\":%llu,\"pauseP99Us\":%llu,\"pauseMaxUs\":%llu,"
+			"\"stopMutatorsMs\":%.3f,\"clearMs\":%.3f,\"stackScanMs\":%.3f,\"rootsMs\":%.3f,\"markMs\":%.3f,\"sweepMs\":%.3f,"
+			"\"concurrentMarkMs\":%.3f,\"peakRssBytes\":%llu",
+			benchmark.Name, options.Scale, options.ThreadCount, seconds, (unsigned long long)allocatedBytes.load(),
+			seconds > 0 ? allocatedBytes.load() / seconds / (1024 * 1024) : 0.0, (unsigned long long)collectionCount,
+			(unsigned long long)(after.StickyCollectionCount - before.StickyCollectionCount), 
+			(unsigned long long)(after.ConcurrentCollectionCount - before.ConcurrentCollectionCount), pauseMilliseconds,
+			(unsigned long long)GetPausePercentile(histogram, pauseCount, 0.50),
+			(unsigned long long)GetPausePercentile(histogram, pauseCount, 0.90),
+			(unsigned long long)GetPausePercentile(histogram, pauseCount, 0.99),
+			(unsigned long long)GetPausePercentile(histogram, pauseCount, 1.0),
+			(after.StopMutatorsTime - before.StopMutatorsTime) / 1e6, (after.ClearTime - before.ClearTime) / 1e6, 
+			(after.StackScanTime - before.StackScanTime) / 1e6, (after.RootsTime - before.RootsTime) / 1e6, 
+			(after.MarkTime - before.MarkTime) / 1e6, (after.SweepTime - before.SweepTime) / 1e6, 
+			(after.ConcurrentMarkTime - before.ConcurrentMarkTime) / 1e6, (unsigned long long)GetPeakResidentSetSize());
+		for (auto& metric : metrics)
+		{
+			printf(",\"%s\":%.3f", metric.Name, metric.Value);
+		}
+		printf("}\n");
+		fflush(stdout);
+	}
+}
+
+using namespace gcix;
+
+/**
+Runs the benchmarks and writes one JSON object per line and per benchmark to the standard output. 
+Usage: gcix-bench [--filter=name] [--scale=N] [--threads=N] [--list]
+Pauses are percentiles of the pause histogram of gcix (upper bounds of its buckets). The peak resident set size is the one
+of the process: run a single benchmark per process (--filter) to compare it across runs.
+*/
+int main(int argc, char* argv[])
+{
+	const char* filter = nullptr;
+	bool list = false;
+	BenchmarkOptions options;
+	options.Scale = 1;
+	options.ThreadCount = std::min(std::max(std::thread::hardware_concurrency(), 1u), 8u);
+
+	for (int i = 1; i < argc; i++)
+	{
+		auto argument = argv[i];
+		if (strncmp(argument, "--filter=", 9) == 0)
+		{
+			filter = argument + 9;
+		}
+		else if (strncmp(argument, "--scale=", 8) == 0)
+		{
+			options.Scale = std::max(atoi(argument + 8), 1);
+		}
+		else if (strncmp(argument, "--threads=", 10) == 0)
+		{
+			options.ThreadCount = std::max(atoi(argument + 10), 1);
+		}
+		else if (strcmp(argument, "--list") == 0)
+		{
+			list = true;
+		}
+		else
+		{
+			fprintf(stderr, "Usage: gcix-bench [--filter=name] [--scale=N] [--threads=N] [--list]\n");
+			return 1;
+		}
+	}
+
+	gcix::Initialize();
+	gcix::InitializeMutatorThread();
+
+	int32_t runCount = 0;
+	for (auto& benchmark : GetBenchmarks())
+	{
+		if (filter != nullptr && strstr(benchmark.Name, filter) == nullptr)
+		{
+			continue;
+		}
+
+		if (list)
+		{
+			printf("%s\n", benchmark.Name);
+		}
+		else
+		{
+			RunBenchmark(benchmark, options);
+		}
+		runCount++;
+	}
+
+	gcix::ShutdownMutatorThread();
+
+	if (runCount == 0)
+	{
+		fprintf(stderr, "No benchmark matching [%s]\n", filter);
+		return 1;
+	}
+	return 0;
+}
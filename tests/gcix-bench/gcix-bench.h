@@ -0,0 +1,148 @@
+// Copyright (c) 2014, Alexandre Mutel
+// All rights reserved.
+// 
+// Redistribution and use in source and binary forms, with or without modification, are permitted provided that the following
+// conditions are met:
+// 
+// 1. Redistributions of source code must retain the above copyright notice, this list of conditions and the following 
+//    disclaimer.
+// 
+// 2. Redistributions in binary form must reproduce the above copyright notice, this list of conditions and the following 
+//    disclaimer in the documentation and/or other materials provided with the distribution.
+// 
+// THIS SOFTWARE IS PROVIDED BY THE COPYRIGHT HOLDERS AND CONTRIBUTORS "AS IS" AND ANY EXPRESS OR IMPLIED WARRANTIES, 
+// INCLUDING, BUT NOT LIMITED TO, THE IMPLIED WARRANTIES OF MERCHANTABILITY AND FITNESS FOR A PARTICULAR PURPOSE ARE 
+// DISCLAIMED. IN NO EVENT SHALL THE COPYRIGHT HOLDER OR CONTRIBUTORS BE LIABLE FOR ANY DIRECT, INDIRECT, INCIDENTAL, SPECIAL, 
+// EXEMPLARY, OR CONSEQUENTIAL DAMAGES (INCLUDING, BUT NOT LIMITED TO, PROCUREMENT OF SUBSTITUTE GOODS OR SERVICES; LOSS OF 
+// USE, DATA, OR PROFITS; OR BUSINESS INTERRUPTION) HOWEVER CAUSED AND ON ANY THEORY OF LIABILITY, WHETHER IN CONTRACT, STRICT 
+// LIABILITY, OR TORT (INCLUDING NEGLIGENCE OR OTHERWISE) ARISING IN ANY WAY OUT OF THE USE OF THIS SOFTWARE, EVEN IF ADVISED 
+// OF THE POSSIBILITY OF SUCH DAMAGE.
+
+#pragma once
+
+#include "gcix.h"
+
+#include <stdint.h>
+
+#ifdef _MSC_VER
+#define gcix_bench_noinline __declspec(noinline)
+#else
+#define gcix_bench_noinline __attribute__((noinline))
+#endif
+
+namespace gcix
+{
+	/**
+	Options of a benchmark run, parsed from the command line.
+	*/
+	struct BenchmarkOptions
+	{
+		/** Multiplier of the work done by each benchmark (--scale=N) */
+		uint32_t Scale;
+
+		/** Number of mutator threads of the multi-threaded benchmarks (--threads=N) */
+		uint32_t ThreadCount;
+	};
+
+	/**
+	Signature of a benchmark. The calling thread is a registered mutator thread.
+	*/
+	typedef void(*BenchmarkDelegate)(const BenchmarkOptions& options);
+
+	/**
+	Registers a benchmark, see GCIX_BENCHMARK.
+	*/
+	class BenchmarkRegistration
+	{
+	public:
+		BenchmarkRegistration(const char* name, BenchmarkDelegate run);
+	};
+
+	/**
+	Declares a benchmark run by gcix-bench, in the same way as a gtest TEST.
+	*/
+#define GCIX_BENCHMARK(name) \
+	static void name##Benchmark(const BenchmarkOptions& options); \
+	static BenchmarkRegistration name##Registration(#name, name##Benchmark); \
+	static void name##Benchmark(const BenchmarkOptions& options)
+
+	/**
+	Accounts bytes allocated by the calling thread, reported as the allocation throughput of the benchmark.
+	*/
+	void AddAllocatedBytes(uint64_t size);
+
+	/**
+	Records a metric specific to the running benchmark, reported along the standard ones.
+	@param name Name of the metric, a string literal
+	*/
+	void AddMetric(const char* name, double value);
+
+	/**
+	Signature of a function run by @see RunThreads.
+	@param threadIndex Index of the thread running the function
+	@param context The context passed to @see RunThreads
+	*/
+	typedef void(*ThreadDelegate)(uint32_t threadIndex, void* context);
+
+	/**
+	Runs a function on several new mutator threads and waits for them. The calling thread runs native code meanwhile, so 
+	that collections don't wait for it.
+	*/
+	void RunThreads(uint32_t threadCount, ThreadDelegate run, void* context);
+
+	/**
+	Allocates a managed object from a benchmark and accounts its size.
+	*/
+	inline void* NewObject(uint32_t size, void* classDescriptor)
+	{
+		AddAllocatedBytes(size);
+		return size <= StandardObjectMaxSizeInBytes ? AllocateStandardObject(size, classDescriptor) : 
+			AllocateLargeObject(size, classDescriptor);
+	}
+
+	/**
+	Stores a reference into a field of a managed object, through the inlined write barrier.
+	*/
+	template <typename T>
+	inline void SetReference(void* object, T*& field, T* value)
+	{
+		WriteReference(object, (void**)&field, value);
+	}
+
+	/**
+	Returns the number of collections performed so far.
+	*/
+	inline uint64_t GetCollectionCount()
+	{
+		Statistics statistics;
+		GetStatistics(&statistics);
+		return statistics.CollectionCount;
+	}
+
+	/**
+	A simple pseudo random generator (xorshift), deterministic across runs and platforms.
+	*/
+	class Random
+	{
+	public:
+		inline Random(uint32_t seed) : state(seed != 0 ? seed : 1)
+		{
+		}
+
+		inline uint32_t Next()
+		{
+			state ^= state << 13;
+			state ^= state >> 17;
+			state ^= state << 5;
+			return state;
+		}
+
+		/** Returns a value in [0, max) */
+		inline uint32_t Next(uint32_t max)
+		{
+			return Next() % max;
+		}
+	private:
+		uint32_t state;
+	};
+}
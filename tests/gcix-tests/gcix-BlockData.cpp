@@ -0,0 +1,113 @@
+// Copyright (c) 2014, Alexandre Mutel
+// All rights reserved.
+// 
+// Redistribution and use in source and binary forms, with or without modification, are permitted provided that the following
+// conditions are met:
+// 
+// 1. Redistributions of source code must retain the above copyright notice, this list of conditions and the following 
+//    disclaimer.
+// 
+// 2. Redistributions in binary form must reproduce the above copyright notice, this list of conditions and the following 
+//    disclaimer in the documentation and/or other materials provided with the distribution.
+// 
+// THIS SOFTWARE IS PROVIDED BY THE COPYRIGHT HOLDERS AND CONTRIBUTORS "AS IS" AND ANY EXPRESS OR IMPLIED WARRANTIES, 
+// INCLUDING, BUT NOT LIMITED TO, THE IMPLIED WARRANTIES OF MERCHANTABILITY AND FITNESS FOR A PARTICULAR PURPOSE ARE 
+// DISCLAIMED. IN NO EVENT SHALL THE COPYRIGHT HOLDER OR CONTRIBUTORS BE LIABLE FOR ANY DIRECT, INDIRECT, INCIDENTAL, SPECIAL, 
+// EXEMPLARY, OR CONSEQUENTIAL DAMAGES (INCLUDING, BUT NOT LIMITED TO, PROCUREMENT OF SUBSTITUTE GOODS OR SERVICES; LOSS OF 
+// USE, DATA, OR PROFITS; OR BUSINESS INTERRUPTION) HOWEVER CAUSED AND ON ANY THEORY OF LIABILITY, WHETHER IN CONTRACT, STRICT 
+// LIABILITY, OR TORT (INCLUDING NEGLIGENCE OR OTHERWISE) ARISING IN ANY WAY OUT OF THE USE OF THIS SOFTWARE, EVEN IF ADVISED 
+// OF THE POSSIBILITY OF SUCH DAMAGE.
+
+#include "gtest/gtest.h"
+
+#include "BlockData.h"
+
+namespace gcix
+{
+	class BlockDataTest : public ::testing::Test
+	{
+	public:
+		virtual void SetUp() 
+		{
+			Memory::Initialize();
+			rawBlock = Memory::AllocateZero(Constants::BlockSizeInBytes * 2);
+			block = (BlockData*)(((intptr_t)rawBlock + Constants::BlockSizeInBytesMask) & Constants::BlockSizeInBytesInverseMask);
+		}
+
+		virtual void TearDown() 
+		{
+			Memory::Free(rawBlock);
+		}
+
+	protected:
+		void* rawBlock;
+		BlockData* block;
+
+		inline void* AtOffset(uint32_t offset)
+		{
+			return (void*)((intptr_t)block + offset);
+		}
+	};
+
+	/**
+	Check that the object start bitmap resolves an interior pointer to the last object starting before it
+	*/
+	TEST_F(BlockDataTest, FindObjectStart)
+	{
+		// No objects
+		ASSERT_EQ(nullptr, block->FindObjectStart(AtOffset(Constants::HeaderSizeInBytes)));
+		ASSERT_EQ(nullptr, block->FindObjectStart(AtOffset(Constants::BlockSizeInBytes - 4)));
+
+		const uint32_t first = Constants::HeaderSizeInBytes;
+		const uint32_t second = first + 12;
+		const uint32_t third = second + 4096;
+		block->SetObjectStart(first);
+		block->SetObjectStart(second);
+		block->SetObjectStart(third);
+
+		// Pointers in the header never resolve to an object
+		ASSERT_EQ(nullptr, block->FindObjectStart(AtOffset(0)));
+		ASSERT_EQ(nullptr, block->FindObjectStart(AtOffset(first - 1)));
+
+		ASSERT_EQ(AtOffset(first), block->FindObjectStart(AtOffset(first)));
+		ASSERT_EQ(AtOffset(first), block->FindObjectStart(AtOffset(second - 1)));
+		ASSERT_EQ(AtOffset(second), block->FindObjectStart(AtOffset(second)));
+		ASSERT_EQ(AtOffset(second), block->FindObjectStart(AtOffset(third - 1)));
+		ASSERT_EQ(AtOffset(third), block->FindObjectStart(AtOffset(third + 3)));
+		ASSERT_EQ(AtOffset(third), block->FindObjectStart(AtOffset(Constants::BlockSizeInBytes - 1)));
+	}
+
+	/**
+	Check that the lines freed by a recycle are only cleared when the block is claimed for allocation
+	*/
+	TEST_F(BlockDataTest, ClearFreeLines)
+	{
+		const uint32_t usedLine = 20;
+		const uint32_t freeLine = 30;
+
+		// A block allocated into, with one line marked by the last trace
+		block->SetFlags(BlockFlags::Unavailable);
+		block->Header.Info.Marked = 1;
+		block->Header.LineFlags[usedLine] = LineFlags::Marked;
+		block->Lines[usedLine][0] = 0xAB;
+		block->Lines[freeLine][0] = 0xCD;
+
+		block->Recycle(false);
+		ASSERT_TRUE(block->IsRecyclable());
+		ASSERT_EQ(0xCD, block->Lines[freeLine][0]);
+
+		block->ClearFreeLines();
+		ASSERT_EQ(0xAB, block->Lines[usedLine][0]);
+		ASSERT_EQ(0, block->Lines[freeLine][0]);
+
+		// Nothing survives the next trace, the whole block is cleared
+		block->Lines[freeLine][0] = 0xCD;
+		block->Recycle(false);
+		ASSERT_TRUE(block->IsFree());
+		ASSERT_EQ(0xAB, block->Lines[usedLine][0]);
+
+		block->ClearFreeLines();
+		ASSERT_EQ(0, block->Lines[usedLine][0]);
+		ASSERT_EQ(0, block->Lines[freeLine][0]);
+	}
+}
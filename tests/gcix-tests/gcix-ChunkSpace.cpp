@@ -0,0 +1,107 @@
+// Copyright (c) 2014, Alexandre Mutel
+// All rights reserved.
+// 
+// Redistribution and use in source and binary forms, with or without modification, are permitted provided that the following
+// conditions are met:
+// 
+// 1. Redistributions of source code must retain the above copyright notice, this list of conditions and the following 
+//    disclaimer.
+// 
+// 2. Redistributions in binary form must reproduce the above copyright notice, this list of conditions and the following 
+//    disclaimer in the documentation and/or other materials provided with the distribution.
+// 
+// THIS SOFTWARE IS PROVIDED BY THE COPYRIGHT HOLDERS AND CONTRIBUTORS "AS IS" AND ANY EXPRESS OR IMPLIED WARRANTIES, 
+// INCLUDING, BUT NOT LIMITED TO, THE IMPLIED WARRANTIES OF MERCHANTABILITY AND FITNESS FOR A PARTICULAR PURPOSE ARE 
+// DISCLAIMED. IN NO EVENT SHALL THE COPYRIGHT HOLDER OR CONTRIBUTORS BE LIABLE FOR ANY DIRECT, INDIRECT, INCIDENTAL, SPECIAL, 
+// EXEMPLARY, OR CONSEQUENTIAL DAMAGES (INCLUDING, BUT NOT LIMITED TO, PROCUREMENT OF SUBSTITUTE GOODS OR SERVICES; LOSS OF 
+// USE, DATA, OR PROFITS; OR BUSINESS INTERRUPTION) HOWEVER CAUSED AND ON ANY THEORY OF LIABILITY, WHETHER IN CONTRACT, STRICT 
+// LIABILITY, OR TORT (INCLUDING NEGLIGENCE OR OTHERWISE) ARISING IN ANY WAY OUT OF THE USE OF THIS SOFTWARE, EVEN IF ADVISED 
+// OF THE POSSIBILITY OF SUCH DAMAGE.
+
+#include "gtest/gtest.h"
+
+#include "ChunkSpace.h"
+
+namespace gcix
+{
+	class ChunkSpaceTest : public ::testing::Test
+	{
+	public:
+		virtual void SetUp() 
+		{
+			Memory::Initialize();
+			ChunkSpace::Initialize();
+		}
+		virtual void TearDown() {}
+	};
+
+	/**
+	Check that chunks are aligned and zeroed, including chunks reused after being freed
+	*/
+	TEST_F(ChunkSpaceTest, AllocateFree)
+	{
+		const int ChunkCount = 4;
+		auto chunkSpace = ChunkSpace::Instance;
+
+		uint8_t* chunks[ChunkCount];
+		for (int i = 0; i < ChunkCount; i++)
+		{
+			chunks[i] = (uint8_t*)chunkSpace->Allocate();
+			ASSERT_NE(nullptr, chunks[i]);
+			ASSERT_EQ(0, (intptr_t)chunks[i] & (Constants::ChunkSizeInBytes - 1));
+			for (uint32_t j = 0; j < Constants::ChunkSizeInBytes; j += 4096)
+			{
+				ASSERT_EQ(0, chunks[i][j]);
+			}
+			chunks[i][0] = 1;
+			chunks[i][Constants::ChunkSizeInBytes - 1] = 1;
+		}
+
+		// Chunks freed by previous tests are reused first
+		chunkSpace->Free(chunks[1]);
+		const int MaxOtherChunkCount = 1024;
+		uint8_t* otherChunks[MaxOtherChunkCount];
+		int otherChunkCount = 0;
+		auto chunk = (uint8_t*)chunkSpace->Allocate();
+		while (chunk != chunks[1] && otherChunkCount < MaxOtherChunkCount)
+		{
+			otherChunks[otherChunkCount++] = chunk;
+			chunk = (uint8_t*)chunkSpace->Allocate();
+		}
+		ASSERT_EQ(chunks[1], chunk);
+		ASSERT_EQ(0, chunk[0]);
+		ASSERT_EQ(0, chunk[Constants::ChunkSizeInBytes - 1]);
+
+		for (int i = 0; i < otherChunkCount; i++)
+		{
+			chunkSpace->Free(otherChunks[i]);
+		}
+
+		for (int i = 0; i < ChunkCount; i++)
+		{
+			chunkSpace->Free(chunks[i]);
+		}
+	}
+
+#if (GCIX_HEAP_RESERVATION_SIZE > 0)
+	/**
+	Check that the chunks are found arithmetically inside the reserved heap range, only while they are allocated
+	*/
+	TEST_F(ChunkSpaceTest, FindChunk)
+	{
+		auto chunkSpace = ChunkSpace::Instance;
+
+		auto chunk = (uint8_t*)chunkSpace->Allocate();
+		ASSERT_NE(nullptr, chunk);
+		ASSERT_TRUE(chunkSpace->Contains(chunk));
+		ASSERT_FALSE(chunkSpace->Contains(&chunkSpace));
+		ASSERT_EQ(chunk, chunkSpace->FindChunk(chunk));
+		ASSERT_EQ(chunk, chunkSpace->FindChunk(chunk + Constants::ChunkSizeInBytes - 1));
+		ASSERT_EQ(nullptr, chunkSpace->FindChunk(&chunkSpace));
+
+		chunkSpace->Free(chunk);
+		ASSERT_TRUE(chunkSpace->Contains(chunk));
+		ASSERT_EQ(nullptr, chunkSpace->FindChunk(chunk));
+	}
+#endif
+}
@@ -0,0 +1,1143 @@
+// Copyright (c) 2014, Alexandre Mutel
+// All rights reserved.
+// 
+// Redistribution and use in source and binary forms, with or without modification, are permitted provided that the following
+// conditions are met:
+// 
+// 1. Redistributions of source code must retain the above copyright notice, this list of conditions and the following 
+//    disclaimer.
+// 
+// 2. Redistributions in binary form must reproduce the above copyright notice, this list of conditions and the following 
+//    disclaimer in the documentation and/or other materials provided with the distribution.
+// 
+// THIS SOFTWARE IS PROVIDED BY THE COPYRIGHT HOLDERS AND CONTRIBUTORS "AS IS" AND ANY EXPRESS OR IMPLIED WARRANTIES, 
+// INCLUDING, BUT NOT LIMITED TO, THE IMPLIED WARRANTIES OF MERCHANTABILITY AND FITNESS FOR A PARTICULAR PURPOSE ARE 
+// DISCLAIMED. IN NO EVENT SHALL THE COPYRIGHT HOLDER OR CONTRIBUTORS BE LIABLE FOR ANY DIRECT, INDIRECT, INCIDENTAL, SPECIAL, 
+// EXEMPLARY, OR CONSEQUENTIAL DAMAGES (INCLUDING, BUT NOT LIMITED TO, PROCUREMENT OF SUBSTITUTE GOODS OR SERVICES; LOSS OF 
+// USE, DATA, OR PROFITS; OR BUSINESS INTERRUPTION) HOWEVER CAUSED AND ON ANY THEORY OF LIABILITY, WHETHER IN CONTRACT, STRICT 
+// LIABILITY, OR TORT (INCLUDING NEGLIGENCE OR OTHERWISE) ARISING IN ANY WAY OUT OF THE USE OF THIS SOFTWARE, EVEN IF ADVISED 
+// OF THE POSSIBILITY OF SUCH DAMAGE.
+
+#include "gtest/gtest.h"
+
+#include "gcix.h"
+#include "GlobalAllocator.h"
+#include "Collector.h"
+#include "Marker.h"
+
+#include <algorithm>
+#include <atomic>
+#include <thread>
+#include <vector>
+
+namespace gcix
+{
+	class CollectorTest : public ::testing::Test
+	{
+	public:
+		virtual void SetUp() 
+		{
+			gcix::Initialize();
+		}
+		virtual void TearDown() {}
+	};
+
+	/**
+	A managed linked list node. The class descriptor is using an inline visitor with one reference following it.
+	*/
+	struct Node
+	{
+		void* ClassDescriptor;
+		Node* Next;
+		uint32_t Value;
+	};
+
+	static void* NodeClass[1] = { (void*)(intptr_t)(1 * 2 + 1) };
+
+	static Node* NewNode(Node* next, uint32_t value)
+	{
+		auto node = (Node*)gcix::AllocateStandardObject(sizeof(Node), NodeClass);
+		node->Next = next;
+		node->Value = value;
+		return node;
+	}
+
+	/**
+	A managed node referencing another list of nodes.
+	*/
+	struct ParentNode
+	{
+		void* ClassDescriptor;
+		ParentNode* Next;
+		Node* Child;
+		uint32_t Value;
+	};
+
+	static void* ParentNodeClass[1] = { (void*)(intptr_t)(2 * 2 + 1) };
+
+	/**
+	A managed array of nodes.
+	*/
+	const uint32_t NodeArrayLength = 64;
+
+	struct NodeArray
+	{
+		void* ClassDescriptor;
+		Node* Items[NodeArrayLength];
+	};
+
+	static void* NodeArrayClass[1] = { (void*)(intptr_t)(NodeArrayLength * 2 + 1) };
+
+	/**
+	Check that collections triggered by any thread stop all mutators and scan all their stacks: lists only referenced 
+	from the stacks of the allocating threads must survive, while other threads are either running native code or 
+	spinning without reaching a safepoint.
+	*/
+	TEST_F(CollectorTest, StopTheWorld)
+	{
+		const int ThreadCount = 4;
+		const uint32_t ListLength = 1000;
+		const int GarbageCount = 200000;
+
+		auto collectionCount = GlobalAllocator::Instance->CollectionCount();
+		std::atomic<int32_t> runningCount(ThreadCount);
+		std::atomic<int32_t> failedCount(0);
+
+		std::vector<std::thread> threads;
+		for (int t = 0; t < ThreadCount; t++)
+		{
+			threads.push_back(std::thread([&, t]()
+			{
+				gcix::InitializeMutatorThread();
+
+				Node* volatile list = nullptr;
+				for (uint32_t i = 0; i < ListLength; i++)
+				{
+					list = NewNode(list, t * ListLength + i);
+				}
+
+				for (int i = 0; i < GarbageCount; i++)
+				{
+					NewNode(nullptr, i);
+				}
+
+				uint32_t expected = t * ListLength + ListLength;
+				for (auto node = list; node != nullptr; node = node->Next)
+				{
+					if (node->Value != --expected)
+					{
+						failedCount++;
+						break;
+					}
+				}
+
+				gcix::ShutdownMutatorThread();
+				runningCount--;
+			}));
+		}
+
+		// A thread running native code, not stopped by collections
+		threads.push_back(std::thread([&]()
+		{
+			gcix::InitializeMutatorThread();
+			Node* volatile list = NewNode(nullptr, 1);
+			gcix::EnterNativeCode();
+			while (runningCount > 0)
+			{
+				std::this_thread::yield();
+			}
+			gcix::LeaveNativeCode();
+			if (list->Value != 1)
+			{
+				failedCount++;
+			}
+			gcix::ShutdownMutatorThread();
+		}));
+
+		// A thread spinning without reaching a safepoint, suspended asynchronously by collections
+		threads.push_back(std::thread([&]()
+		{
+			gcix::InitializeMutatorThread();
+			Node* volatile list = NewNode(nullptr, 2);
+			while (runningCount > 0)
+			{
+			}
+			if (list->Value != 2)
+			{
+				failedCount++;
+			}
+			gcix::ShutdownMutatorThread();
+		}));
+
+		for (auto& thread : threads)
+		{
+			thread.join();
+		}
+
+		ASSERT_EQ(0, failedCount.load());
+		ASSERT_LT(collectionCount, GlobalAllocator::Instance->CollectionCount());
+	}
+
+	/**
+	Check that sticky collections keep old objects without tracing them, and keep the young objects only referenced by 
+	old objects logged by the write barrier.
+	*/
+	TEST_F(CollectorTest, StickyCollections)
+	{
+		const uint32_t ListLength = 1000;
+		const int RoundCount = 4;
+
+		Collector::stickyEnabled = true;
+		Collector::Instance->fullCollectionRequested = true;
+
+		int32_t failedCount = 0;
+		int32_t stickyCount = 0;
+
+		std::thread thread([&]()
+		{
+			gcix::InitializeMutatorThread();
+
+			ParentNode* volatile list = nullptr;
+			for (uint32_t i = 0; i < ListLength; i++)
+			{
+				auto parent = (ParentNode*)gcix::AllocateStandardObject(sizeof(ParentNode), ParentNodeClass);
+				parent->Next = list;
+				parent->Value = i;
+				list = parent;
+			}
+
+			for (int round = 0; round <= RoundCount; round++)
+			{
+				// Collect until the list is old
+				auto markState = ObjectAddress::MarkState;
+				auto collectionCount = GlobalAllocator::Instance->CollectionCount();
+				for (int i = 0; GlobalAllocator::Instance->CollectionCount() == collectionCount; i++)
+				{
+					NewNode(nullptr, i);
+				}
+				if (round > 0 && markState == ObjectAddress::MarkState)
+				{
+					stickyCount++;
+				}
+
+				if (round == RoundCount)
+				{
+					break;
+				}
+
+				// Young objects only referenced by old objects
+				for (auto parent = list; parent != nullptr; parent = parent->Next)
+				{
+					gcix::WriteBarrier(parent);
+					parent->Child = NewNode(parent->Child, round * ListLength + parent->Value);
+				}
+			}
+
+			for (auto parent = list; parent != nullptr; parent = parent->Next)
+			{
+				auto round = RoundCount;
+				for (auto node = parent->Child; node != nullptr; node = node->Next)
+				{
+					if (node->Value != --round * ListLength + parent->Value)
+					{
+						failedCount++;
+						break;
+					}
+				}
+				if (round != 0)
+				{
+					failedCount++;
+				}
+			}
+
+			gcix::ShutdownMutatorThread();
+		});
+		thread.join();
+
+		Collector::stickyEnabled = GCIX_ENABLE_STICKY == 1;
+
+		ASSERT_EQ(0, failedCount);
+		ASSERT_EQ(RoundCount, stickyCount);
+	}
+
+	/**
+	Check that the inlined write barrier of WriteReference and WriteReferences logs the old objects they modify, so that 
+	sticky collections keep the young objects only referenced by them.
+	*/
+	TEST_F(CollectorTest, WriteReference)
+	{
+		const int RoundCount = 8;
+
+		Collector::stickyEnabled = true;
+		Collector::Instance->fullCollectionRequested = true;
+
+		int32_t failedCount = 0;
+		int32_t stickyCount = 0;
+
+		std::thread thread([&]()
+		{
+			gcix::InitializeMutatorThread();
+
+			NodeArray* volatile arrays = (NodeArray*)gcix::AllocateStandardObject(sizeof(NodeArray), NodeArrayClass);
+			for (uint32_t i = 0; i < NodeArrayLength; i++)
+			{
+				auto array = (NodeArray*)gcix::AllocateStandardObject(sizeof(NodeArray), NodeArrayClass);
+				gcix::WriteReference(arrays, (void**)&arrays->Items[i], array);
+			}
+
+			for (int round = 0; round <= RoundCount; round++)
+			{
+				// Collect until the arrays are old
+				auto markState = ObjectAddress::MarkState;
+				auto collectionCount = GlobalAllocator::Instance->CollectionCount();
+				for (int i = 0; GlobalAllocator::Instance->CollectionCount() == collectionCount; i++)
+				{
+					NewNode(nullptr, i);
+				}
+				if (round > 0 && markState == ObjectAddress::MarkState)
+				{
+					stickyCount++;
+				}
+
+				if (round == RoundCount)
+				{
+					break;
+				}
+
+				// Shift the items of the old arrays, inserting a young node only referenced by them
+				for (uint32_t i = 0; i < NodeArrayLength; i++)
+				{
+					auto array = (NodeArray*)arrays->Items[i];
+					gcix::WriteReferences(array, (void**)&array->Items[1], (void**)&array->Items[0], NodeArrayLength - 1);
+					gcix::WriteReference(array, (void**)&array->Items[0], NewNode(nullptr, round * NodeArrayLength + i));
+				}
+			}
+
+			for (uint32_t i = 0; i < NodeArrayLength; i++)
+			{
+				auto array = (NodeArray*)arrays->Items[i];
+				for (uint32_t j = 0; j < NodeArrayLength; j++)
+				{
+					auto node = array->Items[j];
+					auto round = RoundCount - 1 - (int)j;
+					if (round >= 0 ? node == nullptr || node->Value != round * NodeArrayLength + i : node != nullptr)
+					{
+						failedCount++;
+					}
+				}
+			}
+
+			gcix::ShutdownMutatorThread();
+		});
+		thread.join();
+
+		Collector::stickyEnabled = GCIX_ENABLE_STICKY == 1;
+
+		ASSERT_EQ(0, failedCount);
+		ASSERT_EQ(RoundCount, stickyCount);
+	}
+
+	/**
+	Check that a thread between the check of the write barrier state and the store of @see gcix::WriteReference is not 
+	suspended asynchronously: a collection waits for the thread to leave this window, then suspends it.
+	*/
+	TEST_F(CollectorTest, WriteBarrierWindow)
+	{
+		std::atomic<int32_t> step(0);
+		std::atomic<bool> collected(false);
+		int32_t failedCount = 0;
+		uint64_t collectionCount = 0;
+
+		// A thread spinning without reaching a safepoint, stopped inside the window of the write barrier
+		std::thread spinning([&]()
+		{
+			gcix::InitializeMutatorThread();
+			Node* volatile list = NewNode(nullptr, 3);
+
+			gcix::InWriteBarrier = true;
+			step = 1;
+			while (step < 2)
+			{
+			}
+			gcix::InWriteBarrier = false;
+
+			while (!collected)
+			{
+			}
+			if (list->Value != 3)
+			{
+				failedCount++;
+			}
+			gcix::ShutdownMutatorThread();
+		});
+
+		std::thread collecting([&]()
+		{
+			gcix::InitializeMutatorThread();
+			while (step < 1)
+			{
+				std::this_thread::yield();
+			}
+
+			collectionCount = GlobalAllocator::Instance->CollectionCount();
+			GlobalAllocator::Instance->RequestCollect();
+			for (int i = 0; GlobalAllocator::Instance->CollectionCount() == collectionCount; i++)
+			{
+				NewNode(nullptr, i);
+			}
+			collected = true;
+			gcix::ShutdownMutatorThread();
+		});
+
+		// The collection is requested, and would have suspended the spinning thread after GCIX_SUSPEND_TIMEOUT_MS
+		while (!Collector::SafepointRequested())
+		{
+			std::this_thread::yield();
+		}
+		std::this_thread::sleep_for(std::chrono::milliseconds(GCIX_SUSPEND_TIMEOUT_MS * 10));
+		auto collectedInWindow = collected.load();
+		step = 2;
+
+		spinning.join();
+		collecting.join();
+
+		ASSERT_FALSE(collectedInWindow);
+		ASSERT_EQ(0, failedCount);
+		ASSERT_LT(collectionCount, GlobalAllocator::Instance->CollectionCount());
+	}
+
+#if (GCIX_ENABLE_CARD_TABLE == 1)
+	/**
+	A large managed array of nodes, described either by an inline visitor or by a visitor function.
+	*/
+	const uint32_t LargeNodeArrayLength = 16384;
+
+	struct LargeNodeArray
+	{
+		void* ClassDescriptor;
+		Node* Items[LargeNodeArrayLength];
+	};
+
+	static void gcix_visitor gcix_fastcall VisitLargeNodeArray(ObjectAddress* object, VisitorContext* context)
+	{
+		auto array = (LargeNodeArray*)object->ToUserObject();
+		for (uint32_t i = 0; i < LargeNodeArrayLength; i++)
+		{
+			context->Visitor((void**)&array->Items[i], context);
+		}
+	}
+
+	static void* LargeNodeArrayClasses[2][1] = 
+	{
+		{ (void*)(intptr_t)(LargeNodeArrayLength * 2 + 1) },
+		{ (void*)VisitLargeNodeArray },
+	};
+
+	/**
+	Check that stores into old large objects dirty their cards, and that sticky collections keep the young objects only 
+	referenced from their dirty cards and clean them.
+	*/
+	TEST_F(CollectorTest, CardTable)
+	{
+		const int RoundCount = 4;
+		const uint32_t SlotStride = 1000;
+
+		Collector::stickyEnabled = true;
+		Collector::Instance->fullCollectionRequested = true;
+
+		int32_t failedCount = 0;
+		int32_t stickyCount = 0;
+
+		std::thread thread([&]()
+		{
+			gcix::InitializeMutatorThread();
+
+			LargeNodeArray* volatile arrays[2];
+			for (int i = 0; i < 2; i++)
+			{
+				arrays[i] = (LargeNodeArray*)gcix::AllocateLargeObject(sizeof(LargeNodeArray), LargeNodeArrayClasses[i]);
+			}
+
+			for (int round = 0; round <= RoundCount; round++)
+			{
+				// Collect until the arrays are old
+				auto markState = ObjectAddress::MarkState;
+				auto collectionCount = GlobalAllocator::Instance->CollectionCount();
+				for (int i = 0; GlobalAllocator::Instance->CollectionCount() == collectionCount; i++)
+				{
+					NewNode(nullptr, i);
+				}
+				if (round > 0 && markState == ObjectAddress::MarkState)
+				{
+					stickyCount++;
+				}
+
+				for (int i = 0; i < 2; i++)
+				{
+					auto object = (LargeObjectAddress*)ObjectAddress::FromUserObject(arrays[i]);
+					for (uint32_t card = 0; card < object->CardCount(); card++)
+					{
+						if (object->Cards()[card] != 0)
+						{
+							failedCount++;
+						}
+					}
+				}
+
+				if (round == RoundCount)
+				{
+					break;
+				}
+
+				// Young nodes only referenced by a few slots of the old arrays
+				for (int i = 0; i < 2; i++)
+				{
+					auto array = arrays[i];
+					auto object = (LargeObjectAddress*)ObjectAddress::FromUserObject(array);
+					for (uint32_t slot = round; slot < LargeNodeArrayLength; slot += SlotStride)
+					{
+						gcix::WriteReference(array, (void**)&array->Items[slot], NewNode(nullptr, slot));
+						if (object->Cards()[object->GetCardIndex(&array->Items[slot])] == 0)
+						{
+							failedCount++;
+						}
+					}
+				}
+			}
+
+			for (int i = 0; i < 2; i++)
+			{
+				auto array = arrays[i];
+				for (uint32_t slot = 0; slot < LargeNodeArrayLength; slot++)
+				{
+					auto node = array->Items[slot];
+					if (slot % SlotStride < RoundCount ? node == nullptr || node->Value != slot : node != nullptr)
+					{
+						failedCount++;
+					}
+				}
+			}
+
+			gcix::ShutdownMutatorThread();
+		});
+		thread.join();
+
+		Collector::stickyEnabled = GCIX_ENABLE_STICKY == 1;
+
+		ASSERT_EQ(0, failedCount);
+		ASSERT_EQ(RoundCount, stickyCount);
+	}
+#endif
+
+	/**
+	Check that concurrent collections keep the objects reachable when their trace started, even when the only reference to 
+	them is moved during the trace from an object not yet traced to an object already traced, and keep the objects 
+	allocated during the trace.
+	*/
+	TEST_F(CollectorTest, ConcurrentMark)
+	{
+		const uint32_t ListLength = 100000;
+
+		// Collections counting references are never concurrent
+		Collector::concurrentEnabled = true;
+		Collector::rcEnabled = false;
+
+		// A sticky collection would end the allocation loop before the concurrent trace starts, and copy the objects of the
+		// nursery referenced from native memory
+		Collector::stickyEnabled = false;
+
+		int32_t failedCount = 0;
+		int32_t unmarkedCount = 0;
+		int32_t roundCount = 0;
+		Statistics before;
+		Statistics after;
+		gcix::GetStatistics(&before);
+
+		std::thread thread([&]()
+		{
+			gcix::InitializeMutatorThread();
+
+			// The list is traced from its last parent, the lists of children are identified by their first node
+			ParentNode* volatile list = nullptr;
+			std::vector<ParentNode*> parents;
+			std::vector<uint32_t> childLists;
+			for (uint32_t i = 0; i < ListLength; i++)
+			{
+				auto parent = (ParentNode*)gcix::AllocateStandardObject(sizeof(ParentNode), ParentNodeClass);
+				parent->Next = list;
+				parent->Child = NewNode(nullptr, i);
+				parent->Value = i;
+				list = parent;
+				parents.push_back(parent);
+				childLists.push_back(i);
+			}
+
+			// Allocate until a concurrent trace is started
+			auto collectionCount = GlobalAllocator::Instance->CollectionCount();
+			for (int i = 0; !Marker::Marking() && GlobalAllocator::Instance->CollectionCount() == collectionCount; i++)
+			{
+				NewNode(nullptr, i);
+			}
+
+			// Until the remark pause, swap the children of the first parents (not yet traced) with the children of the last 
+			// ones (already traced), prepending a new node to them
+			uint32_t remarkPair = 0;
+			while (GlobalAllocator::Instance->CollectionCount() == collectionCount)
+			{
+				roundCount++;
+				for (uint32_t i = 0; i < ListLength / 2 && GlobalAllocator::Instance->CollectionCount() == collectionCount; i++)
+				{
+					auto first = parents[i];
+					auto last = parents[ListLength - 1 - i];
+					auto firstChild = NewNode(last->Child, roundCount * ListLength + childLists[ListLength - 1 - i]);
+					auto lastChild = NewNode(first->Child, roundCount * ListLength + childLists[i]);
+					gcix::WriteBarrier(first, (void**)&first->Child);
+					first->Child = firstChild;
+					gcix::WriteBarrier(last, (void**)&last->Child);
+					last->Child = lastChild;
+					std::swap(childLists[i], childLists[ListLength - 1 - i]);
+					remarkPair = i;
+				}
+			}
+
+			// The lines of the children lost by the trace can be kept by their neighbours, so check their marks directly,
+			// except for the new nodes of the pair modified when the remark pause happened (they can be allocated after it)
+			for (uint32_t i = 0; i < ListLength; i++)
+			{
+				auto node = parents[i]->Child;
+				if (i == remarkPair || i == ListLength - 1 - remarkPair)
+				{
+					node = node->Next;
+				}
+				for (; node != nullptr; node = node->Next)
+				{
+					if (!ObjectAddress::FromUserObject(node)->IsMarked())
+					{
+						unmarkedCount++;
+					}
+				}
+			}
+
+			// Reuse the lines freed by the collection
+			collectionCount = GlobalAllocator::Instance->CollectionCount();
+			for (int i = 0; GlobalAllocator::Instance->CollectionCount() == collectionCount; i++)
+			{
+				NewNode(nullptr, i);
+			}
+
+			// The last round stopped at the remark pause, so the chains have either roundCount or roundCount + 1 nodes
+			for (uint32_t i = 0; i < ListLength; i++)
+			{
+				auto round = parents[i]->Child->Value / ListLength + 1;
+				for (auto node = parents[i]->Child; node != nullptr; node = node->Next)
+				{
+					if (node->Value != --round * ListLength + childLists[i])
+					{
+						failedCount++;
+						break;
+					}
+				}
+				if (round != 0)
+				{
+					failedCount++;
+				}
+			}
+
+			gcix::ShutdownMutatorThread();
+		});
+		thread.join();
+
+		Collector::concurrentEnabled = GCIX_ENABLE_CONCURRENT_MARK == 1;
+		Collector::rcEnabled = GCIX_ENABLE_RC == 1;
+		Collector::stickyEnabled = GCIX_ENABLE_STICKY == 1;
+		gcix::GetStatistics(&after);
+
+		ASSERT_EQ(0, unmarkedCount);
+		ASSERT_EQ(0, failedCount);
+		ASSERT_LT(0, roundCount);
+		ASSERT_LE(2u, after.ConcurrentCollectionCount - before.ConcurrentCollectionCount);
+	}
+
+#if (GCIX_ENABLE_RC == 1)
+	static Node* NewList(uint32_t length, uint32_t value)
+	{
+		Node* list = nullptr;
+		for (uint32_t i = 0; i < length; i++)
+		{
+			list = NewNode(list, value + i);
+		}
+		return list;
+	}
+
+	/**
+	Check that sticky collections counting references reclaim the old objects as soon as they are unreferenced, with the 
+	lines they leave empty, and that the objects still referenced stay intact when these lines are reused.
+	*/
+	TEST_F(CollectorTest, ReferenceCounting)
+	{
+		const uint32_t ListLength = 1000;
+		const int RoundCount = 4;
+
+		Collector::Instance->fullCollectionRequested = true;
+
+		int32_t failedCount = 0;
+		int32_t stickyCount = 0;
+		uint64_t droppedBytes = 0;
+		size_t firstLiveBytes = 0;
+		size_t lastLiveBytes = 0;
+		Statistics before;
+		Statistics after;
+
+		std::thread thread([&]()
+		{
+			gcix::InitializeMutatorThread();
+
+			NodeArray* volatile lists = (NodeArray*)gcix::AllocateStandardObject(sizeof(NodeArray), NodeArrayClass);
+			for (uint32_t i = 0; i < NodeArrayLength; i++)
+			{
+				gcix::WriteReference(lists, (void**)&lists->Items[i], NewList(ListLength, i * ListLength));
+			}
+
+			for (int round = 0; round <= RoundCount; round++)
+			{
+				// Collect until the lists are old
+				auto markState = ObjectAddress::MarkState;
+				auto collectionCount = GlobalAllocator::Instance->CollectionCount();
+				for (int i = 0; GlobalAllocator::Instance->CollectionCount() == collectionCount; i++)
+				{
+					NewNode(nullptr, i);
+				}
+				if (round > 0 && markState == ObjectAddress::MarkState)
+				{
+					stickyCount++;
+				}
+
+				GlobalAllocator::Instance->CompleteSweep();
+				if (round == 0)
+				{
+					firstLiveBytes = GlobalAllocator::Instance->LiveBytes();
+					gcix::GetStatistics(&before);
+				}
+				if (round == RoundCount)
+				{
+					lastLiveBytes = GlobalAllocator::Instance->LiveBytes();
+					break;
+				}
+
+				// Replace half of the old lists by young lists
+				for (uint32_t i = round & 1; i < NodeArrayLength; i += 2)
+				{
+					gcix::WriteReference(lists, (void**)&lists->Items[i], NewList(ListLength, i * ListLength));
+					droppedBytes += ListLength * sizeof(Node);
+				}
+			}
+			gcix::GetStatistics(&after);
+
+			for (uint32_t i = 0; i < NodeArrayLength; i++)
+			{
+				auto expected = (i + 1) * ListLength;
+				for (auto node = lists->Items[i]; node != nullptr; node = node->Next)
+				{
+					if (!ObjectAddress::FromUserObject(node)->IsMarked() || node->Value != --expected)
+					{
+						failedCount++;
+						break;
+					}
+				}
+				if (expected != i * ListLength)
+				{
+					failedCount++;
+				}
+			}
+
+			gcix::ShutdownMutatorThread();
+		});
+		thread.join();
+
+		ASSERT_EQ(0, failedCount);
+		ASSERT_EQ(RoundCount, stickyCount);
+
+		// The lists referenced from the stack are only reclaimed by the next collections
+		ASSERT_LE(droppedBytes * 9 / 10, after.ReferenceCountFreedBytes - before.ReferenceCountFreedBytes);
+		ASSERT_LE(lastLiveBytes, firstLiveBytes + firstLiveBytes / 4);
+	}
+#endif
+
+	/**
+	Check that objects of fragmented blocks are evacuated by full collections, and that the references to them (including
+	gc roots) are updated.
+	*/
+	TEST_F(CollectorTest, Evacuation)
+	{
+		const uint32_t ListLength = 2000;
+		const int SpacingCount = 16;
+
+		int32_t failedCount = 0;
+		int32_t movedCount = 0;
+		Node* root = nullptr;
+		std::vector<Node*> addresses;
+
+		// Concurrent collections and collections counting references do not evacuate
+		Collector::concurrentEnabled = false;
+		Collector::rcEnabled = false;
+
+		// Sticky collections do not evacuate the old blocks, where the list is once the first collection is done
+		Collector::stickyEnabled = false;
+
+		std::thread thread([&]()
+		{
+			gcix::InitializeMutatorThread();
+			GlobalAllocator::Instance->AddGcRoot((void**)&root);
+
+			// A list allocated between garbage objects, so that its blocks are fragmented after a collection
+			for (uint32_t i = 0; i < ListLength; i++)
+			{
+				root = NewNode(root, i);
+				for (int j = 0; j < SpacingCount; j++)
+				{
+					NewNode(nullptr, j);
+				}
+			}
+
+			for (auto node = root; node != nullptr; node = node->Next)
+			{
+				addresses.push_back(node);
+			}
+
+			// The first collection computes the fragmentation of blocks, the next one evacuates them
+			for (int i = 0; i < 2; i++)
+			{
+				auto collectionCount = GlobalAllocator::Instance->CollectionCount();
+				for (int j = 0; GlobalAllocator::Instance->CollectionCount() == collectionCount; j++)
+				{
+					NewNode(nullptr, j);
+				}
+			}
+
+			uint32_t expected = ListLength;
+			size_t index = 0;
+			for (auto node = root; node != nullptr; node = node->Next, index++)
+			{
+				if (node->Value != --expected)
+				{
+					failedCount++;
+					break;
+				}
+				if (node != addresses[index])
+				{
+					movedCount++;
+				}
+			}
+			if (expected != 0)
+			{
+				failedCount++;
+			}
+
+			GlobalAllocator::Instance->RemoveGcRoot((void**)&root);
+			gcix::ShutdownMutatorThread();
+		});
+		thread.join();
+
+		Collector::concurrentEnabled = GCIX_ENABLE_CONCURRENT_MARK == 1;
+		Collector::rcEnabled = GCIX_ENABLE_RC == 1;
+		Collector::stickyEnabled = GCIX_ENABLE_STICKY == 1;
+
+		ASSERT_EQ(0, failedCount);
+		ASSERT_LT(0, movedCount);
+	}
+
+#if (GCIX_ENABLE_NURSERY == 1)
+	/**
+	Check that the objects surviving in the nursery are copied out of it by the next collection, next to each other 
+	instead of staying in the lines of the garbage allocated between them, and that they stay intact.
+	*/
+	TEST_F(CollectorTest, Nursery)
+	{
+		const uint32_t ListLength = 2000;
+		const int SpacingCount = 16;
+
+		int32_t failedCount = 0;
+		int32_t movedCount = 0;
+		size_t lineCount = 0;
+		Node* root = nullptr;
+		std::vector<Node*> addresses;
+
+		// Concurrent collections and collections counting references do not copy objects
+		Collector::concurrentEnabled = false;
+		Collector::rcEnabled = false;
+
+		std::thread thread([&]()
+		{
+			gcix::InitializeMutatorThread();
+			GlobalAllocator::Instance->AddGcRoot((void**)&root);
+
+			// Nodes allocated between garbage objects, copied out of the nursery by the collections requested meanwhile
+			for (uint32_t i = 0; i < ListLength; i++)
+			{
+				root = NewNode(root, i);
+				addresses.push_back(root);
+				for (int j = 0; j < SpacingCount; j++)
+				{
+					NewNode(nullptr, j);
+				}
+			}
+
+			auto collectionCount = GlobalAllocator::Instance->CollectionCount();
+			for (int j = 0; GlobalAllocator::Instance->CollectionCount() == collectionCount; j++)
+			{
+				NewNode(nullptr, j);
+			}
+
+			uint32_t expected = ListLength;
+			std::vector<intptr_t> lines;
+			for (auto node = root; node != nullptr; node = node->Next)
+			{
+				if (node->Value != --expected)
+				{
+					failedCount++;
+					break;
+				}
+				if (node != addresses[expected])
+				{
+					movedCount++;
+				}
+				lines.push_back((intptr_t)node >> Constants::LineBits);
+			}
+			if (expected != 0)
+			{
+				failedCount++;
+			}
+
+			std::sort(lines.begin(), lines.end());
+			lineCount = std::unique(lines.begin(), lines.end()) - lines.begin();
+
+			GlobalAllocator::Instance->RemoveGcRoot((void**)&root);
+			gcix::ShutdownMutatorThread();
+		});
+		thread.join();
+
+		Collector::concurrentEnabled = GCIX_ENABLE_CONCURRENT_MARK == 1;
+		Collector::rcEnabled = GCIX_ENABLE_RC == 1;
+
+		ASSERT_EQ(0, failedCount);
+
+		// Only the nodes referenced from the stack when a collection starts are kept in place
+		ASSERT_LE(ListLength * 9 / 10, (uint32_t)movedCount);
+
+		// Left in place, each node would keep at least one line alive
+		ASSERT_GT(ListLength / 4, lineCount);
+	}
+#endif
+
+	/**
+	Check that a heap of many chunks, swept lazily or in parallel by the marker workers, keeps all the reachable objects 
+	and accounts for their lines.
+	*/
+	TEST_F(CollectorTest, ParallelSweep)
+	{
+		const uint32_t ListLength = 200000;
+
+		int32_t failedCount = 0;
+		size_t liveBytes = 0;
+		int32_t chunkCount = 0;
+		Node* root = nullptr;
+
+		std::thread thread([&]()
+		{
+			gcix::InitializeMutatorThread();
+			GlobalAllocator::Instance->AddGcRoot((void**)&root);
+
+			for (uint32_t i = 0; i < ListLength; i++)
+			{
+				root = NewNode(root, i);
+				NewNode(nullptr, i);
+			}
+
+			for (int i = 0; i < 2; i++)
+			{
+				auto collectionCount = GlobalAllocator::Instance->CollectionCount();
+				for (int j = 0; GlobalAllocator::Instance->CollectionCount() == collectionCount; j++)
+				{
+					NewNode(nullptr, j);
+				}
+			}
+			GlobalAllocator::Instance->CompleteSweep();
+			liveBytes = GlobalAllocator::Instance->LiveBytes();
+			chunkCount = GlobalAllocator::Instance->Chunks.Count();
+
+			uint32_t expected = ListLength;
+			for (auto node = root; node != nullptr; node = node->Next)
+			{
+				if (node->Value != --expected)
+				{
+					failedCount++;
+					break;
+				}
+			}
+			if (expected != 0)
+			{
+				failedCount++;
+			}
+
+			GlobalAllocator::Instance->RemoveGcRoot((void**)&root);
+			gcix::ShutdownMutatorThread();
+		});
+		thread.join();
+
+		ASSERT_EQ(0, failedCount);
+		ASSERT_LT(4, chunkCount);
+		ASSERT_LE(ListLength * sizeof(Node), liveBytes);
+	}
+
+	/**
+	Check that unreachable large objects of all sizes (spans of pages or directly mapped) are freed by collections while
+	reachable ones survive, and that their memory is reused.
+	*/
+	TEST_F(CollectorTest, LargeObjects)
+	{
+		const uint32_t ListLength = 16;
+		const uint32_t Sizes[] = { 20000, 200000, 2000000 };
+
+		int32_t failedCount = 0;
+		size_t listSize = 0;
+		size_t liveBytes = 0;
+		Node* root = nullptr;
+
+		// The large objects allocated during a concurrent trace are allocated black and survive it as floating garbage,
+		// beyond the few objects retained by the stack
+		Collector::concurrentEnabled = false;
+
+		std::thread thread([&]()
+		{
+			gcix::InitializeMutatorThread();
+			GlobalAllocator::Instance->AddGcRoot((void**)&root);
+
+			for (uint32_t i = 0; i < ListLength; i++)
+			{
+				auto size = Sizes[i % 3];
+				auto node = (Node*)gcix::AllocateLargeObject(size, NodeClass);
+				node->Next = root;
+				node->Value = i;
+				root = node;
+				listSize += size;
+			}
+
+			// Garbage large objects triggering a few collections
+			for (int i = 0; i < 3; i++)
+			{
+				auto collectionCount = GlobalAllocator::Instance->CollectionCount();
+				for (uint32_t j = 0; GlobalAllocator::Instance->CollectionCount() == collectionCount; j++)
+				{
+					auto node = (Node*)gcix::AllocateLargeObject(Sizes[j % 3], NodeClass);
+					if (node->Next != nullptr || node->Value != 0)
+					{
+						failedCount++;
+					}
+					node->Value = j;
+				}
+			}
+			GlobalAllocator::Instance->CompleteSweep();
+			liveBytes = GlobalAllocator::Instance->LiveBytes();
+
+			uint32_t expected = ListLength;
+			for (auto node = root; node != nullptr; node = node->Next)
+			{
+				if (node->Value != --expected)
+				{
+					failedCount++;
+					break;
+				}
+			}
+			if (expected != 0)
+			{
+				failedCount++;
+			}
+
+			GlobalAllocator::Instance->RemoveGcRoot((void**)&root);
+			gcix::ShutdownMutatorThread();
+		});
+		thread.join();
+
+		Collector::concurrentEnabled = GCIX_ENABLE_CONCURRENT_MARK == 1;
+
+		ASSERT_EQ(0, failedCount);
+		ASSERT_LE(listSize, liveBytes);
+
+		// Only a few garbage objects may be retained by the conservative scan of the stack
+		ASSERT_GT(listSize + 3 * Sizes[2], liveBytes);
+	}
+
+	/**
+	Check that the statistics account the collections, their pauses and the allocated bytes, and that the buckets of the 
+	pause histogram are contiguous.
+	*/
+	TEST_F(CollectorTest, Statistics)
+	{
+		const uint32_t LargeObjectSize = 100000;
+
+		Statistics before;
+		Statistics after;
+		gcix::GetStatistics(&before);
+
+		Node* root = nullptr;
+		std::thread thread([&]()
+		{
+			gcix::InitializeMutatorThread();
+			GlobalAllocator::Instance->AddGcRoot((void**)&root);
+
+			root = (Node*)gcix::AllocateLargeObject(LargeObjectSize, NodeClass);
+
+			// Garbage triggering a few collections
+			for (int i = 0; i < 3; i++)
+			{
+				auto collectionCount = GlobalAllocator::Instance->CollectionCount();
+				for (uint32_t j = 0; GlobalAllocator::Instance->CollectionCount() == collectionCount; j++)
+				{
+					NewNode(nullptr, j);
+				}
+			}
+			GlobalAllocator::Instance->CompleteSweep();
+			gcix::GetStatistics(&after);
+
+			GlobalAllocator::Instance->RemoveGcRoot((void**)&root);
+			gcix::ShutdownMutatorThread();
+		});
+		thread.join();
+
+		ASSERT_LE(before.CollectionCount + 3, after.CollectionCount);
+		ASSERT_LE(after.StickyCollectionCount, after.CollectionCount);
+		ASSERT_LT(before.BytesAllocated, after.BytesAllocated);
+		ASSERT_LT(0u, after.BytesFreed);
+		ASSERT_LE((uint64_t)LargeObjectSize, after.BytesMarked);
+		ASSERT_LE(1u, after.LargeObjectCount);
+		ASSERT_LE((uint64_t)LargeObjectSize, after.LargeObjectBytes);
+		ASSERT_LT(0u, after.FreeBlockCount + after.RecyclableBlockCount + after.UnavailableBlockCount);
+
+		// The pause is the sum of the phases
+		ASSERT_EQ(after.TotalPauseTime, after.StopMutatorsTime + after.ClearTime + after.StackScanTime + 
+			after.RootsTime + after.MarkTime + after.SweepTime);
+		ASSERT_LT(0u, after.MaxPauseTime);
+		ASSERT_LE(after.MaxPauseTime, after.TotalPauseTime);
+
+		// Each pause is counted by one bucket of the histogram, a concurrent collection has an initial and a remark pause
+		uint64_t pauseCount = 0;
+		for (uint32_t i = 0; i < PauseHistogramBucketCount; i++)
+		{
+			pauseCount += after.PauseHistogram[i];
+		}
+		ASSERT_EQ(after.CollectionCount + after.ConcurrentCollectionCount, pauseCount);
+		ASSERT_LE(after.ConcurrentCollectionCount, after.CollectionCount);
+
+		// Buckets are contiguous, each power of two is split in 4 buckets
+		ASSERT_EQ(0u, gcix::GetPauseHistogramBucketStart(0));
+		ASSERT_EQ(4u, gcix::GetPauseHistogramBucketStart(4));
+		ASSERT_EQ(5u, gcix::GetPauseHistogramBucketStart(5));
+		ASSERT_EQ(8u, gcix::GetPauseHistogramBucketStart(8));
+		ASSERT_EQ(10u, gcix::GetPauseHistogramBucketStart(9));
+		ASSERT_EQ(1ull << 32, gcix::GetPauseHistogramBucketStart(PauseHistogramBucketCount));
+		for (uint32_t i = 0; i < PauseHistogramBucketCount; i++)
+		{
+			ASSERT_LT(gcix::GetPauseHistogramBucketStart(i), gcix::GetPauseHistogramBucketStart(i + 1));
+		}
+	}
+}
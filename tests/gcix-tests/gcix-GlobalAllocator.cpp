@@ -54,12 +54,13 @@ namespace gcix
 		// Check that a chunk has the same address as the first block data
 		EXPECT_EQ((void*)chunk0, (void*)blockData0);
 
-        EXPECT_TRUE(chunk0->IsFree());
+        // The first block is claimed through the chunk
+        EXPECT_FALSE(chunk0->IsFree());
         EXPECT_TRUE(chunk0->HasFreeBlocks());
         EXPECT_FALSE(chunk0->HasRecyclableBlocks());
 
 		// Check block count per chunk
-		EXPECT_EQ(Constants::BlockCountPerChunk, chunk0->GetBlockCount());
+		EXPECT_EQ((int32_t)Constants::BlockCountPerChunk, chunk0->GetBlockCount());
 
 		// Check allocated blocks
 		for (int i = 0; i < chunk0->GetBlockCount(); i++)
@@ -71,9 +72,9 @@ namespace gcix
 				EXPECT_EQ(block, blockData0);
 			}
 
-			EXPECT_TRUE(block->IsFree());
+			EXPECT_EQ(i != 0, block->IsFree());
 			EXPECT_FALSE(block->IsRecyclable());
-			EXPECT_FALSE(block->IsUnavailable());
+			EXPECT_EQ(i == 0, block->IsUnavailable());
 
 			// Check that all block data are aligned on a block size
 			EXPECT_EQ(0, (intptr_t)block & Constants::BlockSizeInBytesMask);
@@ -92,7 +93,7 @@ namespace gcix
 		}
 
 		// Check Bump cursor in BlockData, must be equal to the header size
-		EXPECT_EQ(Constants::HeaderSizeInBytes, blockData0->Header.Info.BumpCursor);
+		EXPECT_EQ((uint32_t)Constants::HeaderSizeInBytes, blockData0->Header.Info.BumpCursor);
 
 		// Check BumpCursorLimit = 0
 		EXPECT_EQ(0, blockData0->Header.Info.BumpCursorLimit);
@@ -102,29 +103,40 @@ namespace gcix
 		auto maxChunkAddress = (Chunk*)((intptr_t)chunk0 + Constants::BlockSizeInBytes * Constants::BlockCountPerChunk);
 
 		// Check pointers inside the chunk
-		EXPECT_TRUE(instance->Chunks.Contains(chunk0));
-		EXPECT_TRUE(instance->Chunks.Contains((Chunk*)((intptr_t)maxChunkAddress - 1)));
+		EXPECT_EQ(chunk0, *instance->chunkMap.Find(chunk0));
+		EXPECT_EQ(chunk0, *instance->chunkMap.Find((Chunk*)((intptr_t)maxChunkAddress - 1)));
 
 		// Check pointers outside the chunk
-		EXPECT_FALSE(instance->Chunks.Contains((Chunk*)((intptr_t)chunk0 - 1)));
-		EXPECT_FALSE(instance->Chunks.Contains(maxChunkAddress));
+		auto beforeChunk = instance->chunkMap.Find((Chunk*)((intptr_t)chunk0 - 1));
+		auto afterChunk = instance->chunkMap.Find(maxChunkAddress);
+		EXPECT_TRUE(beforeChunk == nullptr || *beforeChunk == nullptr);
+		EXPECT_TRUE(afterChunk == nullptr || *afterChunk == nullptr);
 
 		// Allocate remaining blocks into the chunk
 		for (int i = 1; i < chunk0->GetBlockCount(); i++)
 		{
 			auto nextBlock = instance->RequestBlock(false);
-			EXPECT_TRUE(instance->Chunks.Contains((Chunk*)nextBlock));
+			EXPECT_EQ(chunk0, *instance->chunkMap.Find(nextBlock));
 		}
 
 		// Reallocate a new block from a new chunk
 		auto nextBlockOfNextChunj = instance->RequestBlock(false);
 		auto nextChunk = (Chunk*)nextBlockOfNextChunj;
-		EXPECT_TRUE(nextChunk < minChunkAddress || nextChunk > maxChunkAddress);
+		EXPECT_TRUE(nextChunk < minChunkAddress || nextChunk >= maxChunkAddress);
 
-		// Recycle freshly allocated block, as they have not been marked, the nextChunk must be freed by the recycle
-		// while the firstChunk must be kept for future allocation.
-		instance->Recycle();
+		// Recycle freshly allocated block, as they have not been marked, the nextChunk must be freed once it has been found
+		// free by enough consecutive sweeps, while the firstChunk must be kept for future allocation. Chunks are swept 
+		// lazily after a recycle, at the latest by the next recycle.
+		instance->Recycle(false);
+		for (uint32_t i = 1; i < Constants::FreeChunkReleaseDelay; i++)
+		{
+			instance->Recycle(false);
+			EXPECT_EQ(2, instance->Chunks.Count());
+		}
+		instance->Recycle(false);
 		EXPECT_EQ(1, instance->Chunks.Count());
+		EXPECT_EQ(chunk0, instance->Chunks[0]);
+		EXPECT_TRUE(instance->chunkMap.Find(nextChunk) == nullptr || *instance->chunkMap.Find(nextChunk) == nullptr);
 
 		// TODO Add tests after recycle
 
@@ -0,0 +1,89 @@
+// Copyright (c) 2014, Alexandre Mutel
+// All rights reserved.
+// 
+// Redistribution and use in source and binary forms, with or without modification, are permitted provided that the following
+// conditions are met:
+// 
+// 1. Redistributions of source code must retain the above copyright notice, this list of conditions and the following 
+//    disclaimer.
+// 
+// 2. Redistributions in binary form must reproduce the above copyright notice, this list of conditions and the following 
+//    disclaimer in the documentation and/or other materials provided with the distribution.
+// 
+// THIS SOFTWARE IS PROVIDED BY THE COPYRIGHT HOLDERS AND CONTRIBUTORS "AS IS" AND ANY EXPRESS OR IMPLIED WARRANTIES, 
+// INCLUDING, BUT NOT LIMITED TO, THE IMPLIED WARRANTIES OF MERCHANTABILITY AND FITNESS FOR A PARTICULAR PURPOSE ARE 
+// DISCLAIMED. IN NO EVENT SHALL THE COPYRIGHT HOLDER OR CONTRIBUTORS BE LIABLE FOR ANY DIRECT, INDIRECT, INCIDENTAL, SPECIAL, 
+// EXEMPLARY, OR CONSEQUENTIAL DAMAGES (INCLUDING, BUT NOT LIMITED TO, PROCUREMENT OF SUBSTITUTE GOODS OR SERVICES; LOSS OF 
+// USE, DATA, OR PROFITS; OR BUSINESS INTERRUPTION) HOWEVER CAUSED AND ON ANY THEORY OF LIABILITY, WHETHER IN CONTRACT, STRICT 
+// LIABILITY, OR TORT (INCLUDING NEGLIGENCE OR OTHERWISE) ARISING IN ANY WAY OUT OF THE USE OF THIS SOFTWARE, EVEN IF ADVISED 
+// OF THE POSSIBILITY OF SUCH DAMAGE.
+#include "gtest/gtest.h"
+
+#include "LargeObjectSpace.h"
+
+namespace gcix
+{
+	class LargeObjectSpaceTest : public ::testing::Test
+	{
+	public:
+		virtual void SetUp() 
+		{
+			Memory::Initialize();
+			LargeObjectSpace::Initialize();
+		}
+		virtual void TearDown() {}
+	};
+
+	/**
+	Check that spans are zeroed and reused by the objects of the same size class
+	*/
+	TEST_F(LargeObjectSpaceTest, AllocateFreeSpans)
+	{
+		auto space = LargeObjectSpace::Instance;
+		auto size = LargeObjectSpace::GetAllocationSize(20000);
+		ASSERT_EQ(5 * LargeObjectSpace::PageSizeInBytes, size);
+
+		auto span0 = (uint8_t*)space->Allocate(size);
+		auto span1 = (uint8_t*)space->Allocate(size);
+		ASSERT_NE(nullptr, span0);
+		ASSERT_NE(nullptr, span1);
+		ASSERT_EQ(0, (intptr_t)span0 & (LargeObjectSpace::PageSizeInBytes - 1));
+		ASSERT_TRUE(span1 >= span0 + size || span1 + size <= span0);
+
+		span0[0] = 1;
+		span0[size - 1] = 1;
+		space->Free(span0, size);
+
+		// An object of another size class doesn't reuse the span
+		auto otherSize = LargeObjectSpace::GetAllocationSize(30000);
+		auto otherSpan = (uint8_t*)space->Allocate(otherSize);
+		ASSERT_NE(span0, otherSpan);
+
+		auto span = (uint8_t*)space->Allocate(size);
+		ASSERT_EQ(span0, span);
+		ASSERT_EQ(0, span[0]);
+		ASSERT_EQ(0, span[size - 1]);
+
+		space->Free(span, size);
+		space->Free(span1, size);
+		space->Free(otherSpan, otherSize);
+	}
+
+	/**
+	Check that huge objects are mapped directly and zeroed
+	*/
+	TEST_F(LargeObjectSpaceTest, AllocateFreeHuge)
+	{
+		auto space = LargeObjectSpace::Instance;
+		auto size = LargeObjectSpace::GetAllocationSize(LargeObjectSpace::MaxSpanSizeInBytes + 1);
+
+		auto object = (uint8_t*)space->Allocate(size);
+		ASSERT_NE(nullptr, object);
+		for (size_t i = 0; i < size; i += LargeObjectSpace::PageSizeInBytes)
+		{
+			ASSERT_EQ(0, object[i]);
+		}
+		object[size - 1] = 1;
+		space->Free(object, size);
+	}
+}
@@ -0,0 +1,147 @@
+// Copyright (c) 2014, Alexandre Mutel
+// All rights reserved.
+// 
+// Redistribution and use in source and binary forms, with or without modification, are permitted provided that the following
+// conditions are met:
+// 
+// 1. Redistributions of source code must retain the above copyright notice, this list of conditions and the following 
+//    disclaimer.
+// 
+// 2. Redistributions in binary form must reproduce the above copyright notice, this list of conditions and the following 
+//    disclaimer in the documentation and/or other materials provided with the distribution.
+// 
+// THIS SOFTWARE IS PROVIDED BY THE COPYRIGHT HOLDERS AND CONTRIBUTORS "AS IS" AND ANY EXPRESS OR IMPLIED WARRANTIES, 
+// INCLUDING, BUT NOT LIMITED TO, THE IMPLIED WARRANTIES OF MERCHANTABILITY AND FITNESS FOR A PARTICULAR PURPOSE ARE 
+// DISCLAIMED. IN NO EVENT SHALL THE COPYRIGHT HOLDER OR CONTRIBUTORS BE LIABLE FOR ANY DIRECT, INDIRECT, INCIDENTAL, SPECIAL, 
+// EXEMPLARY, OR CONSEQUENTIAL DAMAGES (INCLUDING, BUT NOT LIMITED TO, PROCUREMENT OF SUBSTITUTE GOODS OR SERVICES; LOSS OF 
+// USE, DATA, OR PROFITS; OR BUSINESS INTERRUPTION) HOWEVER CAUSED AND ON ANY THEORY OF LIABILITY, WHETHER IN CONTRACT, STRICT 
+// LIABILITY, OR TORT (INCLUDING NEGLIGENCE OR OTHERWISE) ARISING IN ANY WAY OUT OF THE USE OF THIS SOFTWARE, EVEN IF ADVISED 
+// OF THE POSSIBILITY OF SUCH DAMAGE.
+
+#include "gtest/gtest.h"
+
+#include "LineMask.h"
+
+#include <random>
+
+namespace gcix
+{
+	class LineMaskTest : public ::testing::Test
+	{
+	public:
+		virtual void SetUp() {}
+		virtual void TearDown() {}
+
+	protected:
+		/**
+		Fills the line flags with a random fragmented pattern of marked lines, the header lines being always marked
+		*/
+		static void Fragment(std::mt19937& random, LineFlags* lineFlags, uint32_t usedPercent)
+		{
+			for (uint32_t i = 0; i < Constants::LineCount; i++)
+			{
+				auto isUsed = i < Constants::HeaderLineCount || (random() % 100) < usedPercent;
+				lineFlags[i] = isUsed ? (LineFlags)((uint8_t)LineFlags::Marked | (uint8_t)LineFlags::ContainsObject) : 
+					(LineFlags)(random() & (uint8_t)LineFlags::ContainsObject);
+			}
+		}
+
+		/**
+		Reference implementation of the hole search: a byte per byte scan of the line flags
+		*/
+		static bool FindHoleReference(const bool* used, uint32_t fromLine, uint32_t lineCount, uint32_t& holeStart,
+			uint32_t& holeEnd)
+		{
+			uint32_t start = Constants::LineCount;
+			for (uint32_t i = fromLine; i <= Constants::LineCount; i++)
+			{
+				if (i == Constants::LineCount || used[i])
+				{
+					if (start != Constants::LineCount && (i - start) >= lineCount)
+					{
+						holeStart = start;
+						holeEnd = i;
+						return true;
+					}
+					start = Constants::LineCount;
+				}
+				else if (start == Constants::LineCount)
+				{
+					start = i;
+				}
+			}
+			return false;
+		}
+	};
+
+	/**
+	Check that marked lines are extracted to the mask and cleared from the line flags
+	*/
+	TEST_F(LineMaskTest, ExtractMarkedLines)
+	{
+		std::mt19937 random(1);
+		LineFlags lineFlags[Constants::LineCount];
+		uint32_t mask[LineMask::WordCount];
+
+		for (int iteration = 0; iteration < 100; iteration++)
+		{
+			Fragment(random, lineFlags, iteration % 100);
+
+			bool used[Constants::LineCount];
+			LineFlags expectedFlags[Constants::LineCount];
+			for (uint32_t i = 0; i < Constants::LineCount; i++)
+			{
+				used[i] = ((uint8_t)lineFlags[i] & (uint8_t)LineFlags::Marked) != 0;
+				expectedFlags[i] = (LineFlags)((uint8_t)lineFlags[i] & ~(uint8_t)LineFlags::Marked);
+			}
+
+			LineMask::ExtractMarkedLines(lineFlags, mask);
+
+			uint32_t usedCount = 0;
+			for (uint32_t i = 0; i < Constants::LineCount; i++)
+			{
+				ASSERT_EQ(used[i], (mask[i >> 5] & (1u << (i & 31))) != 0);
+				ASSERT_EQ(expectedFlags[i], lineFlags[i]);
+				usedCount += used[i] ? 1 : 0;
+			}
+			ASSERT_EQ(usedCount, LineMask::CountLines(mask));
+		}
+	}
+
+	/**
+	Check that the hole search matches a byte per byte scan on random fragmented blocks
+	*/
+	TEST_F(LineMaskTest, FindHole)
+	{
+		std::mt19937 random(2);
+		LineFlags lineFlags[Constants::LineCount];
+		uint32_t mask[LineMask::WordCount];
+		bool used[Constants::LineCount];
+
+		for (int iteration = 0; iteration < 200; iteration++)
+		{
+			Fragment(random, lineFlags, iteration % 100);
+			for (uint32_t i = 0; i < Constants::LineCount; i++)
+			{
+				used[i] = ((uint8_t)lineFlags[i] & (uint8_t)LineFlags::Marked) != 0;
+			}
+			LineMask::ExtractMarkedLines(lineFlags, mask);
+
+			for (uint32_t lineCount = 1; lineCount <= 8; lineCount++)
+			{
+				for (uint32_t fromLine = 0; fromLine <= Constants::LineCount; fromLine += 7)
+				{
+					uint32_t expectedStart = 0, expectedEnd = 0, start = 0, end = 0;
+					auto expected = FindHoleReference(used, fromLine, lineCount, expectedStart, expectedEnd);
+					auto found = LineMask::FindHole(mask, fromLine, lineCount, start, end);
+					ASSERT_EQ(expected, found);
+					if (found)
+					{
+						ASSERT_EQ(expectedStart, start);
+						ASSERT_EQ(expectedEnd, end);
+					}
+				}
+			}
+		}
+	}
+}
@@ -0,0 +1,75 @@
+// Copyright (c) 2014, Alexandre Mutel
+// All rights reserved.
+// 
+// Redistribution and use in source and binary forms, with or without modification, are permitted provided that the following
+// conditions are met:
+// 
+// 1. Redistributions of source code must retain the above copyright notice, this list of conditions and the following 
+//    disclaimer.
+// 
+// 2. Redistributions in binary form must reproduce the above copyright notice, this list of conditions and the following 
+//    disclaimer in the documentation and/or other materials provided with the distribution.
+// 
+// THIS SOFTWARE IS PROVIDED BY THE COPYRIGHT HOLDERS AND CONTRIBUTORS "AS IS" AND ANY EXPRESS OR IMPLIED WARRANTIES, 
+// INCLUDING, BUT NOT LIMITED TO, THE IMPLIED WARRANTIES OF MERCHANTABILITY AND FITNESS FOR A PARTICULAR PURPOSE ARE 
+// DISCLAIMED. IN NO EVENT SHALL THE COPYRIGHT HOLDER OR CONTRIBUTORS BE LIABLE FOR ANY DIRECT, INDIRECT, INCIDENTAL, SPECIAL, 
+// EXEMPLARY, OR CONSEQUENTIAL DAMAGES (INCLUDING, BUT NOT LIMITED TO, PROCUREMENT OF SUBSTITUTE GOODS OR SERVICES; LOSS OF 
+// USE, DATA, OR PROFITS; OR BUSINESS INTERRUPTION) HOWEVER CAUSED AND ON ANY THEORY OF LIABILITY, WHETHER IN CONTRACT, STRICT 
+// LIABILITY, OR TORT (INCLUDING NEGLIGENCE OR OTHERWISE) ARISING IN ANY WAY OUT OF THE USE OF THIS SOFTWARE, EVEN IF ADVISED 
+// OF THE POSSIBILITY OF SUCH DAMAGE.
+
+#include "gtest/gtest.h"
+
+#include "Collections/PageMap.h"
+
+namespace gcix
+{
+	class PageMapTest : public ::testing::Test
+	{
+	public:
+		virtual void SetUp() 
+		{
+			Memory::Initialize();
+		}
+		virtual void TearDown() {}
+	};
+
+	/**
+	Check that pages are resolved to the values set and that unmapped or out of range addresses are rejected
+	*/
+	TEST_F(PageMapTest, SetFind)
+	{
+		typedef PageMap<void*, 16> TestPageMap;
+		TestPageMap pageMap;
+
+		auto start = (void*)(size_t)0x12340000;
+		auto end = (void*)(size_t)0x12380000;
+		ASSERT_EQ(nullptr, pageMap.Find(start));
+
+		ASSERT_TRUE(pageMap.Set(start, end, start));
+
+		// All pages in the range are resolved, including interior addresses
+		for (auto ptr = (size_t)start; ptr < (size_t)end; ptr += 0x1234)
+		{
+			auto entry = pageMap.Find((void*)ptr);
+			ASSERT_NE(nullptr, entry);
+			ASSERT_EQ(start, *entry);
+		}
+
+		// Pages around the range belong to the same leaf but are not set
+		ASSERT_EQ(nullptr, *pageMap.Find((void*)((size_t)start - 1)));
+		ASSERT_EQ(nullptr, *pageMap.Find(end));
+
+		// Pages in another leaf are not allocated
+		ASSERT_EQ(nullptr, pageMap.Find((void*)((size_t)start ^ ((size_t)1 << (TestPageMap::LeafBits + 16)))));
+
+		// Addresses out of the address space
+		if (sizeof(void*) == 8)
+		{
+			ASSERT_EQ(nullptr, pageMap.Find((void*)~(size_t)0));
+		}
+
+		ASSERT_TRUE(pageMap.Set(start, end, nullptr));
+		ASSERT_EQ(nullptr, *pageMap.Find(start));
+	}
+}
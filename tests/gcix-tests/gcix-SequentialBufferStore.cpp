@@ -20,7 +20,7 @@
 
 #include "gtest/gtest.h"
 
-#include "Collections\SequentialStoreBuffer.h"
+#include "Collections/SequentialStoreBuffer.h"
 
 namespace gcix
 {
@@ -47,7 +47,7 @@ namespace gcix
 
 		for (int i = 0; i < pointerCount; i++)
 		{
-			handler.Push((void*)(i + 1));
+			handler.Push((void*)(intptr_t)(i + 1));
 		}
 
 		auto nextBuffer2 = handler.buffer;
@@ -60,12 +60,13 @@ namespace gcix
 			ASSERT_EQ((intptr_t)i, ptr);
 		}
 
-		ASSERT_NE(nextBuffer, handler.buffer);
+		// Popping from the empty second buffer has recycled it and moved back to the first buffer
+		ASSERT_EQ(nextBuffer, handler.buffer);
 
 		ASSERT_EQ(nullptr, handler.Pop());
-		ASSERT_NE(nextBuffer, handler.buffer);
+		ASSERT_EQ(nextBuffer, handler.buffer);
 
 		ASSERT_EQ(nullptr, handler.Pop());
-		ASSERT_NE(nextBuffer, handler.buffer);
+		ASSERT_EQ(nextBuffer, handler.buffer);
 	}
 };
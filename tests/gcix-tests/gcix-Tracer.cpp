@@ -0,0 +1,127 @@
+// Copyright (c) 2014, Alexandre Mutel
+// All rights reserved.
+// 
+// Redistribution and use in source and binary forms, with or without modification, are permitted provided that the following
+// conditions are met:
+// 
+// 1. Redistributions of source code must retain the above copyright notice, this list of conditions and the following 
+//    disclaimer.
+// 
+// 2. Redistributions in binary form must reproduce the above copyright notice, this list of conditions and the following 
+//    disclaimer in the documentation and/or other materials provided with the distribution.
+// 
+// THIS SOFTWARE IS PROVIDED BY THE COPYRIGHT HOLDERS AND CONTRIBUTORS "AS IS" AND ANY EXPRESS OR IMPLIED WARRANTIES, 
+// INCLUDING, BUT NOT LIMITED TO, THE IMPLIED WARRANTIES OF MERCHANTABILITY AND FITNESS FOR A PARTICULAR PURPOSE ARE 
+// DISCLAIMED. IN NO EVENT SHALL THE COPYRIGHT HOLDER OR CONTRIBUTORS BE LIABLE FOR ANY DIRECT, INDIRECT, INCIDENTAL, SPECIAL, 
+// EXEMPLARY, OR CONSEQUENTIAL DAMAGES (INCLUDING, BUT NOT LIMITED TO, PROCUREMENT OF SUBSTITUTE GOODS OR SERVICES; LOSS OF 
+// USE, DATA, OR PROFITS; OR BUSINESS INTERRUPTION) HOWEVER CAUSED AND ON ANY THEORY OF LIABILITY, WHETHER IN CONTRACT, STRICT 
+// LIABILITY, OR TORT (INCLUDING NEGLIGENCE OR OTHERWISE) ARISING IN ANY WAY OUT OF THE USE OF THIS SOFTWARE, EVEN IF ADVISED 
+// OF THE POSSIBILITY OF SUCH DAMAGE.
+
+#include "gtest/gtest.h"
+
+#include "gcix.h"
+#include "Tracer.h"
+
+#include <stdio.h>
+#include <string>
+#include <thread>
+
+namespace gcix
+{
+	class TracerTest : public ::testing::Test
+	{
+	public:
+		virtual void SetUp() 
+		{
+			gcix::Initialize();
+		}
+		virtual void TearDown() {}
+	};
+
+	/** 
+	Reads a whole file into a string.
+	*/
+	static std::string ReadFile(const char* path)
+	{
+		std::string content;
+		auto file = fopen(path, "r");
+		if (file != nullptr)
+		{
+			char buffer[4096];
+			size_t size;
+			while ((size = fread(buffer, 1, sizeof(buffer), file)) > 0)
+			{
+				content.append(buffer, size);
+			}
+			fclose(file);
+		}
+		return content;
+	}
+
+	/** 
+	Counts the occurrences of a string.
+	*/
+	static int32_t CountOccurrences(const std::string& content, const std::string& value)
+	{
+		int32_t count = 0;
+		for (auto index = content.find(value); index != std::string::npos; index = content.find(value, index + 1))
+		{
+			count++;
+		}
+		return count;
+	}
+
+	/**
+	Check that the events recorded by several threads are written once to the trace file, and that events are dropped 
+	while the buffer of a thread is full.
+	*/
+	TEST_F(TracerTest, Write)
+	{
+		const char* Path = "gcix-tracer-test.json";
+		const int32_t PhaseCount = 100;
+		const std::string BeginEvent = "{\"name\":\"TracerTest\",\"cat\":\"gc\",\"ph\":\"B\"";
+		const std::string EndEvent = "{\"name\":\"TracerTest\",\"cat\":\"gc\",\"ph\":\"E\"";
+
+		// Events are not recorded until the tracer is started
+		Tracer::Begin("TracerTest");
+		Tracer::End("TracerTest");
+
+		Tracer::Start();
+		auto record = [&]()
+		{
+			for (int32_t i = 0; i < PhaseCount; i++)
+			{
+				TraceScope scope("TracerTest");
+			}
+			Tracer::ReleaseThreadBuffer();
+		};
+		std::thread thread1(record);
+		std::thread thread2(record);
+		thread1.join();
+		thread2.join();
+
+		ASSERT_TRUE(Tracer::Instance->Write(Path));
+		auto content = ReadFile(Path);
+		ASSERT_EQ(0u, content.find("{\"traceEvents\":["));
+		ASSERT_EQ(2 * PhaseCount, CountOccurrences(content, BeginEvent));
+		ASSERT_EQ(2 * PhaseCount, CountOccurrences(content, EndEvent));
+
+		// Fill the buffer of this thread, the last events are dropped
+		for (uint32_t i = 0; i < TraceBuffer::EventCount + 2; i++)
+		{
+			Tracer::Begin("TracerOverflow");
+		}
+		Tracer::Stop();
+		Tracer::ReleaseThreadBuffer();
+
+		// Events are written only once
+		ASSERT_TRUE(Tracer::Instance->Write(Path));
+		content = ReadFile(Path);
+		ASSERT_EQ(0, CountOccurrences(content, "TracerTest"));
+		ASSERT_EQ((int32_t)TraceBuffer::EventCount, CountOccurrences(content, "\"TracerOverflow\""));
+		ASSERT_NE(std::string::npos, content.find("\"droppedEvents\":2}"));
+
+		remove(Path);
+	}
+}
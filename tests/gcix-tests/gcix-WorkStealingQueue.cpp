@@ -0,0 +1,135 @@
+// Copyright (c) 2014, Alexandre Mutel
+// All rights reserved.
+// 
+// Redistribution and use in source and binary forms, with or without modification, are permitted provided that the following
+// conditions are met:
+// 
+// 1. Redistributions of source code must retain the above copyright notice, this list of conditions and the following 
+//    disclaimer.
+// 
+// 2. Redistributions in binary form must reproduce the above copyright notice, this list of conditions and the following 
+//    disclaimer in the documentation and/or other materials provided with the distribution.
+// 
+// THIS SOFTWARE IS PROVIDED BY THE COPYRIGHT HOLDERS AND CONTRIBUTORS "AS IS" AND ANY EXPRESS OR IMPLIED WARRANTIES, 
+// INCLUDING, BUT NOT LIMITED TO, THE IMPLIED WARRANTIES OF MERCHANTABILITY AND FITNESS FOR A PARTICULAR PURPOSE ARE 
+// DISCLAIMED. IN NO EVENT SHALL THE COPYRIGHT HOLDER OR CONTRIBUTORS BE LIABLE FOR ANY DIRECT, INDIRECT, INCIDENTAL, SPECIAL, 
+// EXEMPLARY, OR CONSEQUENTIAL DAMAGES (INCLUDING, BUT NOT LIMITED TO, PROCUREMENT OF SUBSTITUTE GOODS OR SERVICES; LOSS OF 
+// USE, DATA, OR PROFITS; OR BUSINESS INTERRUPTION) HOWEVER CAUSED AND ON ANY THEORY OF LIABILITY, WHETHER IN CONTRACT, STRICT 
+// LIABILITY, OR TORT (INCLUDING NEGLIGENCE OR OTHERWISE) ARISING IN ANY WAY OUT OF THE USE OF THIS SOFTWARE, EVEN IF ADVISED 
+// OF THE POSSIBILITY OF SUCH DAMAGE.
+
+#include "gtest/gtest.h"
+
+#include "Collections/WorkStealingQueue.h"
+
+#include <thread>
+#include <vector>
+
+namespace gcix
+{
+	class WorkStealingQueueTest : public ::testing::Test
+	{
+	public:
+		virtual void SetUp() {}
+		virtual void TearDown() {}
+	};
+
+	/**
+	Check LIFO order for the owner, FIFO order for thieves and the bounded capacity
+	*/
+	TEST_F(WorkStealingQueueTest, PushPopSteal)
+	{
+		auto queue = new WorkStealingQueue<intptr_t, 16>();
+		intptr_t item;
+
+		EXPECT_TRUE(queue->IsEmpty());
+		EXPECT_FALSE(queue->Pop(item));
+		EXPECT_FALSE(queue->Steal(item));
+
+		for (intptr_t i = 1; i <= 16; i++)
+		{
+			ASSERT_TRUE(queue->Push(i));
+		}
+		EXPECT_FALSE(queue->Push(17));
+
+		ASSERT_TRUE(queue->Pop(item));
+		EXPECT_EQ(16, item);
+
+		ASSERT_TRUE(queue->Steal(item));
+		EXPECT_EQ(1, item);
+
+		for (intptr_t i = 15; i >= 2; i--)
+		{
+			ASSERT_TRUE(queue->Pop(item));
+			EXPECT_EQ(i, item);
+		}
+
+		EXPECT_TRUE(queue->IsEmpty());
+		EXPECT_FALSE(queue->Pop(item));
+		EXPECT_FALSE(queue->Steal(item));
+
+		delete queue;
+	}
+
+	/**
+	Check that each item pushed is taken exactly once while several threads are stealing
+	*/
+	TEST_F(WorkStealingQueueTest, ConcurrentSteal)
+	{
+		const int itemCount = 100000;
+		const int thiefCount = 4;
+
+		auto queue = new WorkStealingQueue<intptr_t, 1024>();
+		std::vector<std::atomic<int>> taken(itemCount);
+		for (auto& value : taken)
+		{
+			value = 0;
+		}
+		std::atomic<bool> completed(false);
+
+		std::vector<std::thread> thieves;
+		for (int i = 0; i < thiefCount; i++)
+		{
+			thieves.push_back(std::thread([&]()
+			{
+				intptr_t item;
+				while (!completed)
+				{
+					if (queue->Steal(item))
+					{
+						taken[item]++;
+					}
+				}
+			}));
+		}
+
+		intptr_t item;
+		for (intptr_t i = 0; i < itemCount; i++)
+		{
+			while (!queue->Push(i))
+			{
+				if (queue->Pop(item))
+				{
+					taken[item]++;
+				}
+			}
+		}
+		while (queue->Pop(item))
+		{
+			taken[item]++;
+		}
+
+		completed = true;
+		for (auto& thief : thieves)
+		{
+			thief.join();
+		}
+
+		for (int i = 0; i < itemCount; i++)
+		{
+			ASSERT_EQ(1, taken[i].load());
+		}
+
+		delete queue;
+	}
+};
@@ -1,7 +1,7 @@
 #include "gtest/gtest.h"
 #include "GlobalAllocator.h"
 
-int main(int argc, wchar_t* argv[])
+int main(int argc, char* argv[])
 {
 	::testing::InitGoogleTest(&argc, argv);
 